@@ -53,21 +53,24 @@ static bool GenPendingDelegates(CBlock &block, CCacheWrapper &cw, PendingDelegat
     return true;
 }
 
+int32_t chain::GetActivateDelegateInterval(int32_t height) {
+    // TODO: move to sysconf
+    return GetFeatureForkVersion(height) >= MAJOR_VER_R3 ? 24 : 0;
+}
+
 // process block delegates, call in the tail of block executing
 bool chain::ProcessBlockDelegates(CBlock &block, CCacheWrapper &cw, CValidationState &state) {
     // required preparing the undo for cw
 
     int32_t countVoteInterval; // the interval to count the vote
-    int32_t activateDelegateInterval; // the interval to count the vote
+    int32_t activateDelegateInterval = GetActivateDelegateInterval(block.GetHeight()); // the interval to activate
 
     // TODO: move to sysconf
     FeatureForkVersionEnum version = GetFeatureForkVersion(block.GetHeight());
     if (version >= MAJOR_VER_R3) {
         countVoteInterval = 8;
-        activateDelegateInterval = 24;
     } else {
         countVoteInterval = 0;
-        activateDelegateInterval = 0;
     }
 
     PendingDelegates pendingDelegates;
@@ -11,6 +11,9 @@
 
 namespace chain {
 
+    // the interval from counting the votes to activating the pending delegates at the height
+    int32_t GetActivateDelegateInterval(int32_t height);
+
     // process block delegates, call in the tail of block executing
     bool ProcessBlockDelegates(CBlock &block, CCacheWrapper &cw, CValidationState &state);
 };
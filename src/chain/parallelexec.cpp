@@ -0,0 +1,227 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "parallelexec.h"
+
+#include "main.h"
+#include "tx/cointransfertx.h"
+
+#include <atomic>
+#include <exception>
+#include <boost/thread.hpp>
+
+using namespace std;
+
+// below this count of consecutive parallel txs, the thread scheduling costs more than it saves
+static const int32_t MIN_PARALLEL_RUN_TX_COUNT = 8;
+
+static std::atomic<int32_t> nParallelConnectThreads(0);
+
+// Only the txs whose whole read/write set is known before execution may run out of block order.
+// A base coin transfer touches the accounts of sender and receiver only, and the regid it may
+// generate is derived from (height, index), so it is unique in the block.
+static bool IsParallelTx(const CBaseTx &tx) {
+    return tx.nTxType == BCOIN_TRANSFER_TX;
+}
+
+static bool GetParallelTxKeyIds(CBaseTx &tx, CCacheWrapper &cw, set<CKeyID> &keyIds) {
+    auto pTransferTx = (CBaseCoinTransferTx *)&tx;
+    CKeyID toKeyId;
+    // the uid unresolvable before execution, e.g. a regid registered in the same block, can not be grouped
+    if (!pTransferTx->GetInvolvedKeyIds(cw, keyIds) || !cw.accountCache.GetKeyId(pTransferTx->toUid, toKeyId))
+        return false;
+
+    keyIds.insert(toKeyId);
+    return true;
+}
+
+static int32_t FindGroupRoot(vector<int32_t> &parents, int32_t i) {
+    while (parents[i] != i) {
+        parents[i] = parents[parents[i]];
+        i          = parents[i];
+    }
+    return i;
+}
+
+static bool ExecuteTx(CBlock &block, CBlockIndex *pIndex, int32_t index, CCacheWrapper &cw, CValidationState &state) {
+    uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
+    CTxExecuteContext context(pIndex->height, index, block.GetFuelRate(), pIndex->nTime, prevBlockTime, &cw, &state);
+    return block.vptx[index]->ExecuteTx(context);
+}
+
+static bool ReportTxExecuteFail(CBlock &block, CBlockIndex *pIndex, int32_t index, CCacheWrapper &cw,
+                                CValidationState &state) {
+    std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
+    pCdMan->pLogCache->SetExecuteFail(pIndex->height, pBaseTx->GetHash(), state.GetRejectCode(),
+                                      state.GetRejectReason());
+    return state.DoS(100, ERRORMSG("ConnectBlock() : txid=%s execute failed, in detail: %s",
+                     pBaseTx->GetHash().GetHex(), pBaseTx->ToString(cw.accountCache)), REJECT_INVALID, "tx-execute-failed");
+}
+
+static bool ExecuteTxsSerially(CBlock &block, CBlockIndex *pIndex, int32_t begin, int32_t end, CCacheWrapper &cw,
+                               CBlockUndo &blockUndo, CValidationState &state) {
+    for (int32_t index = begin; index < end; ++index) {
+        CTxUndoOpLogger opLogger(cw, block.vptx[index]->GetHash(), blockUndo);
+        if (!ExecuteTx(block, pIndex, index, cw, state))
+            return ReportTxExecuteFail(block, pIndex, index, cw, state);
+    }
+
+    return true;
+}
+
+static bool ExecuteTxsInParallel(CBlock &block, CBlockIndex *pIndex, int32_t begin, int32_t end, CCacheWrapper &cw,
+                                 CBlockUndo &blockUndo, CValidationState &state) {
+    int64_t nStart = GetTimeMicros();
+    int32_t count  = end - begin;
+
+    // 1. Group the txs by the accounts they touch, the txs of a group keep the block order.
+    vector<int32_t> parents(count);
+    map<CKeyID, int32_t> keyOwners;
+    for (int32_t i = 0; i < count; ++i) {
+        parents[i] = i;
+
+        set<CKeyID> keyIds;
+        if (!GetParallelTxKeyIds(*block.vptx[begin + i], cw, keyIds))
+            return ExecuteTxsSerially(block, pIndex, begin, end, cw, blockUndo, state);
+
+        for (const auto &keyId : keyIds) {
+            auto ret = keyOwners.emplace(keyId, i);
+            if (!ret.second)
+                parents[FindGroupRoot(parents, i)] = FindGroupRoot(parents, ret.first->second);
+        }
+    }
+
+    vector<vector<int32_t> > groups;
+    map<int32_t, size_t> rootGroups;
+    for (int32_t i = 0; i < count; ++i) {
+        auto ret = rootGroups.emplace(FindGroupRoot(parents, i), groups.size());
+        if (ret.second)
+            groups.emplace_back();
+
+        groups[ret.first->second].push_back(begin + i);
+    }
+
+    if (groups.size() < 2)
+        return ExecuteTxsSerially(block, pIndex, begin, end, cw, blockUndo, state);
+
+    // 2. Load the touched accounts into cw in advance, GetDataIt() inserts the value found at the base
+    // into the current cache, so the workers must find everything in cw and only read the shared caches.
+    for (const auto &item : keyOwners) {
+        CAccount account;
+        cw.accountCache.GetAccount(item.first, account);
+    }
+
+    // 3. Execute the groups on the workers, each group writes to its own child cache.
+    vector<CTxUndo> txUndos(count);
+    vector<std::shared_ptr<CCacheWrapper> > groupCws(groups.size());
+    vector<CValidationState> groupStates(groups.size());
+    vector<int32_t> failedIndexes(groups.size(), -1);
+    vector<std::exception_ptr> exceptions(groups.size());
+    std::atomic<size_t> nextGroup(0);
+
+    auto worker = [&]() {
+        size_t g;
+        while ((g = nextGroup++) < groups.size()) {
+            try {
+                auto spCw = std::make_shared<CCacheWrapper>(&cw);
+                for (int32_t index : groups[g]) {
+                    CTxUndo &txUndo = txUndos[index - begin];
+                    txUndo.SetTxID(block.vptx[index]->GetHash());
+
+                    spCw->SetDbOpLogMap(&txUndo.dbOpLogMap);
+                    bool executed = ExecuteTx(block, pIndex, index, *spCw, groupStates[g]);
+                    spCw->SetDbOpLogMap(nullptr);
+                    if (!executed) {
+                        failedIndexes[g] = index;
+                        break;
+                    }
+                }
+                groupCws[g] = spCw;
+            } catch (...) {
+                exceptions[g] = std::current_exception();
+            }
+        }
+    };
+
+    int32_t threads = std::min<int32_t>(nParallelConnectThreads, groups.size());
+    boost::thread_group workers;
+    for (int32_t i = 1; i < threads; ++i) {
+        workers.create_thread([&]() {
+            RenameThread("coin-connect");
+            worker();
+        });
+    }
+    worker();
+    workers.join_all();
+
+    // 4. Report the failure of the first tx in block order, just like the serial execution.
+    for (auto &e : exceptions) {
+        if (e)
+            std::rethrow_exception(e);
+    }
+
+    int32_t failedGroup = -1;
+    for (int32_t g = 0; g < (int32_t)groups.size(); ++g) {
+        if (failedIndexes[g] >= 0 && (failedGroup < 0 || failedIndexes[g] < failedIndexes[failedGroup]))
+            failedGroup = g;
+    }
+
+    if (failedGroup >= 0) {
+        state = groupStates[failedGroup];
+        return ReportTxExecuteFail(block, pIndex, failedIndexes[failedGroup], cw, state);
+    }
+
+    // 5. Merge into cw. The groups have no common key, so the merged state and the undo logs in block
+    // order are identical to the serial execution.
+    for (auto &spCw : groupCws) {
+        spCw->Flush();
+    }
+
+    for (auto &txUndo : txUndos) {
+        blockUndo.vtxundo.push_back(std::move(txUndo));
+    }
+
+    if (SysCfg().IsBenchmark())
+        LogPrint(BCLog::INFO, "- Execute %d transactions in %u parallel groups with %d threads: %.2fms\n", count,
+                 groups.size(), threads, 0.001 * (GetTimeMicros() - nStart));
+
+    return true;
+}
+
+namespace chain {
+
+void SetParallelConnectThreads(int32_t threads) {
+    nParallelConnectThreads = std::max(0, std::min(threads, MAX_PARALLEL_CONNECT_THREADS));
+}
+
+int32_t GetParallelConnectThreads() { return nParallelConnectThreads; }
+
+bool ExecuteBlockTxs(CBlock &block, CBlockIndex *pIndex, CCacheWrapper &cw, CBlockUndo &blockUndo,
+                     CValidationState &state) {
+    int32_t txCount = block.vptx.size();
+    if (nParallelConnectThreads < 2)
+        return ExecuteTxsSerially(block, pIndex, 1, txCount, cw, blockUndo, state);
+
+    // Split the block into the runs of consecutive parallel txs, the other txs are barriers executed serially.
+    int32_t index = 1;
+    while (index < txCount) {
+        int32_t end = index;
+        while (end < txCount && IsParallelTx(*block.vptx[end]))
+            ++end;
+
+        if (end - index >= MIN_PARALLEL_RUN_TX_COUNT) {
+            if (!ExecuteTxsInParallel(block, pIndex, index, end, cw, blockUndo, state))
+                return false;
+        } else {
+            end = std::max(end, index + 1);
+            if (!ExecuteTxsSerially(block, pIndex, index, end, cw, blockUndo, state))
+                return false;
+        }
+        index = end;
+    }
+
+    return true;
+}
+
+};
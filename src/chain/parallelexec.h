@@ -0,0 +1,31 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+
+#ifndef CHAIN_PARALLEL_EXEC_H
+#define CHAIN_PARALLEL_EXEC_H
+
+#include "persistence/cachewrapper.h"
+#include "persistence/blockundo.h"
+
+class CBlock;
+class CBlockIndex;
+class CValidationState;
+
+namespace chain {
+
+    static const int32_t MAX_PARALLEL_CONNECT_THREADS = 16;
+
+    // set the worker count used when connecting blocks, 0 means executing all txs serially
+    void SetParallelConnectThreads(int32_t threads);
+    int32_t GetParallelConnectThreads();
+
+    // execute the txs of block except the reward tx. The txs without conflicting accounts may be executed
+    // in parallel, the resulting state and the undo logs pushed to blockUndo are the same as serial execution.
+    bool ExecuteBlockTxs(CBlock &block, CBlockIndex *pIndex, CCacheWrapper &cw, CBlockUndo &blockUndo,
+                         CValidationState &state);
+};
+
+
+#endif //CHAIN_PARALLEL_EXEC_H
@@ -106,6 +106,8 @@ static const uint32_t MAX_BLOCK_SIZE = 4000000;
 static const uint32_t DEFAULT_BLOCK_MAX_SIZE = 3750000;
 /** The maximum size for transactions we're willing to relay/mine */
 static const uint32_t MAX_STANDARD_TX_SIZE = 100000;
+/** Default for -maxmempool, max. size of the memory pool txs in megabytes */
+static const uint32_t DEFAULT_MAX_MEMPOOL_SIZE = 300;
 
 /** The maximum number of orphan blocks kept in memory */
 static const uint32_t MAX_ORPHAN_BLOCKS = 750;
@@ -113,6 +115,19 @@ static const uint32_t MAX_ORPHAN_BLOCKS = 750;
 static const int32_t MAX_BLOCKS_IN_TRANSIT_PER_PEER = 128;
 /** Timeout in seconds before considering a block download peer unresponsive. */
 static const uint32_t BLOCK_DOWNLOAD_TIMEOUT  = 60;
+/** Number of blocks above the chain tip downloaded from the peers in parallel, the blocks received out of order
+ * wait in the orphan pool, so it must be less than MAX_ORPHAN_BLOCKS */
+static const int32_t BLOCK_DOWNLOAD_WINDOW = 512;
+/** Timeout in seconds before the blocks in flight from a peer holding back the download window are reassigned. */
+static const uint32_t BLOCK_STALLING_TIMEOUT = 5;
+/** Number of headers sent in one headers message */
+static const uint32_t MAX_HEADERS_RESULTS = 2000;
+/** Max. headers above the chain tip kept for the headers-first sync */
+static const uint32_t MAX_SYNC_HEADERS = 20000;
+/** Max. compact blocks waiting for their missing txs */
+static const uint32_t MAX_PARTIAL_BLOCKS = 16;
+/** Timeout in seconds of a compact block waiting for its missing txs */
+static const uint32_t PARTIAL_BLOCK_TIMEOUT = 10;
 
 /** Minimum disk space required */
 static const uint64_t MIN_DISK_SPACE = 52428800;
@@ -128,6 +143,18 @@ static const int64_t DEFAULT_DB_CACHE = 100;
 static const int64_t MAX_DB_CACHE = sizeof(void *) > 4 ? 4096 : 1024;
 /** min. -dbcache in (MiB) */
 static const int64_t MIN_DB_CACHE = 4;
+/** -dbflushblocks default, max. blocks of chain state not written to db after initial block download */
+static const int32_t DEFAULT_DB_FLUSH_BLOCKS = 10;
+/** Max. keys known missing in db kept by each db level cache */
+static const uint32_t DB_CACHE_MAX_MISSING_KEYS = 20000;
+/** -dbreadcache default (MiB), the memory of the deserialized db data kept after flushed */
+static const int64_t DEFAULT_DB_READ_CACHE = 64;
+/** -blockcache default (MiB), the memory of the recently written or read blocks */
+static const int64_t DEFAULT_BLOCK_CACHE = 32;
+/** The max count of the tx offsets indexed for the blocks, to read a tx of a block by its CTxCord */
+static const uint64_t MAX_BLOCK_TX_OFFSETS = 1000000;
+/** The max size of the precompiled lua contract scripts cached */
+static const uint64_t MAX_LUA_PROTO_CACHE_SIZE = 16 << 20;
 
 /** Coinbase transaction outputs can only be spent after this number of new blocks (network rule) */
 static const int32_t BLOCK_REWARD_MATURITY = 100;
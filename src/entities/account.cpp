@@ -242,6 +242,17 @@ Object CAccount::ToJsonObj() const {
     vector<CCandidateReceivedVote> candidateVotes;
     pCdMan->pDelegateCache->GetCandidateVotes(regid, candidateVotes);
 
+    return ToJsonObj(candidateVotes, chainActive.Height());
+}
+
+Object CAccount::ToJsonObj(CCacheWrapper &cw, int32_t height) const {
+    vector<CCandidateReceivedVote> candidateVotes;
+    cw.delegateCache.GetCandidateVotes(regid, candidateVotes);
+
+    return ToJsonObj(candidateVotes, height);
+}
+
+Object CAccount::ToJsonObj(const vector<CCandidateReceivedVote> &candidateVotes, int32_t height) const {
     Array candidateVoteArray;
     for (auto &vote : candidateVotes) {
         candidateVoteArray.push_back(vote.ToJson());
@@ -263,9 +274,9 @@ Object CAccount::ToJsonObj() const {
     obj.push_back(Pair("address",           keyid.ToAddress()));
     obj.push_back(Pair("keyid",             keyid.ToString()));
     obj.push_back(Pair("nickid",            nickid.ToString()));
-    obj.push_back(Pair("nickid_mature",     nickid.IsMature(chainActive.Height())));
+    obj.push_back(Pair("nickid_mature",     nickid.IsMature(height)));
     obj.push_back(Pair("regid",             regid.ToString()));
-    obj.push_back(Pair("regid_mature",      regid.IsMature(chainActive.Height())));
+    obj.push_back(Pair("regid_mature",      regid.IsMature(height)));
     obj.push_back(Pair("owner_pubkey",      owner_pubkey.ToString()));
     obj.push_back(Pair("miner_pubkey",      miner_pubkey.ToString()));
     obj.push_back(Pair("tokens",            tokenMapObj));
@@ -25,6 +25,7 @@
 using namespace json_spirit;
 
 class CAccountDBCache;
+class CCacheWrapper;
 
 enum BalanceType : uint8_t {
     NULL_TYPE    = 0,  //!< invalid type
@@ -204,12 +205,15 @@ public:
     void SetEmpty() { keyid.SetEmpty(); }  // TODO: need set other fields to empty()??
     string ToString() const;
     Object ToJsonObj() const;
+    // the votes and the maturity are read from the cache at the height, e.g. a snapshot of the chain state
+    Object ToJsonObj(CCacheWrapper &cw, int32_t height) const;
 
     void SetRegId(CRegID & regIdIn) { regid = regIdIn; }
 
     bool IsMyUid(const CUserID &uid);
 
 private:
+    Object ToJsonObj(const vector<CCandidateReceivedVote> &candidateVotes, int32_t height) const;
     bool IsBcoinWithinRange(uint64_t nAddMoney);
     bool IsFcoinWithinRange(uint64_t nAddMoney);
 };
@@ -212,6 +212,10 @@ string CUserID::ToDebugString() const {
 }
 
 shared_ptr<CUserID> CUserID::ParseUserId(const string &idStr) {
+    return ParseUserId(idStr, *pCdMan->pAccountCache);
+}
+
+shared_ptr<CUserID> CUserID::ParseUserId(const string &idStr, const CAccountDBCache &accountCache) {
     CRegID regId(idStr);
     if (!regId.IsEmpty())
         return std::make_shared<CUserID>(regId);
@@ -228,7 +232,7 @@ shared_ptr<CUserID> CUserID::ParseUserId(const string &idStr) {
 
     CNickID nickId(idStr) ;
 
-    if( pCdMan->pAccountCache->GetKeyId(nickId, keyId)){
+    if( accountCache.GetKeyId(nickId, keyId)){
         return std::make_shared<CUserID>(keyId);
     }
 
@@ -20,10 +20,13 @@
 #include "main.h"
 #include "miner/miner.h"
 #include "net.h"
+#include "p2p/msgprecheck.h"
 #include "persistence/blockdb.h"
 #include "persistence/accountdb.h"
 #include "persistence/txdb.h"
 #include "persistence/contractdb.h"
+#include "persistence/memcachefile.h"
+#include "chain/parallelexec.h"
 #include "tx/tx.h"
 #include "commons/util/util.h"
 #include "commons/util/time.h"
@@ -79,6 +82,9 @@ extern void wasm_code_cache_free();
 #define MIN_CORE_FILEDESCRIPTORS 150
 #endif
 
+// the max. number of threads reading the latest blocks to rebuild the memory caches at startup
+static const int32_t MAX_BLOCK_READ_THREADS = 8;
+
 // Used to pass flags to the Bind() function
 enum BindFlags {
     BF_NONE         = 0,
@@ -124,6 +130,46 @@ bool ShutdownRequested() { return fRequestShutdown; }
 
 void Interrupt() { InterruptRPCServer(); }
 
+// Pass the latest blocks of the active chain to the handler one at a time in any order, the blocks are read from
+// disk on a few threads.
+static bool ReadLatestBlocks(int32_t count, const std::function<bool(const CBlock &)> &handler) {
+    vector<CBlockIndex *> blockIndexes;
+    for (CBlockIndex *pIndex = chainActive.Tip(); pIndex && (int32_t)blockIndexes.size() < count;
+         pIndex = pIndex->pprev) {
+        blockIndexes.push_back(pIndex);
+    }
+
+    std::atomic<size_t> nextIndex(0);
+    std::atomic<bool> fFailed(false);
+    std::mutex mtxHandler;
+    auto worker = [&]() {
+        CBlock block;
+        for (size_t i = nextIndex++; i < blockIndexes.size() && !fFailed; i = nextIndex++) {
+            if (!ReadBlockFromDisk(blockIndexes[i], block)) {
+                fFailed = true;
+                break;
+            }
+
+            std::lock_guard<std::mutex> lock(mtxHandler);
+            if (!handler(block))
+                fFailed = true;
+        }
+    };
+
+    int32_t threads = std::min<int32_t>(MAX_BLOCK_READ_THREADS, blockIndexes.size());
+    boost::thread_group readers;
+    for (int32_t i = 1; i < threads; ++i) {
+        readers.create_thread([&]() {
+            RenameThread("coin-loadblk");
+            worker();
+        });
+    }
+    worker();
+    readers.join_all();
+
+    return !fFailed;
+}
+
 void Shutdown() {
     LogPrint(BCLog::INFO, "Shutdown() : In progress...\n");
     static CCriticalSection cs_Shutdown;
@@ -141,6 +187,8 @@ void Shutdown() {
 
     StopNode();
     UnregisterNodeSignals(GetNodeSignals());
+    signatureCheckQueue.Stop();
+    messagePrecheckQueue.Stop();
 
     {
         LOCK(cs_main);
@@ -151,6 +199,9 @@ void Shutdown() {
         }
 
         if (pCdMan != nullptr) {
+            ReleaseChainStateSnapshot();
+            if (fMemCachesLoaded)
+                CMemCacheFile().Write(pCdMan->pBlockCache->GetBestBlockHash(), *pCdMan->pTxCache, *pCdMan->pPpCache);
             pCdMan->Flush();
             delete pCdMan;
             pCdMan = nullptr;
@@ -213,6 +264,12 @@ string HelpMessage() {
 #endif
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
+    strUsage += "  -par=<n>               " + strprintf(_("Set the number of signature verification threads (%d to %d, 0 = auto, <0 = leave that many cores free, default: %d)"), -(int32_t)boost::thread::hardware_concurrency(), MAX_SIG_CHECK_THREADS, DEFAULT_SIG_CHECK_THREADS) + "\n";
+    strUsage += "  -msgthreads=<n>        " + strprintf(_("Set the number of threads deserializing and verifying the signatures of the received transactions and pbft messages ahead of their processing (0 to %d, 0 = disabled, default: %d)"), MAX_MSG_PRECHECK_THREADS, DEFAULT_MSG_PRECHECK_THREADS) + "\n";
+    strUsage += "  -parallelconnect=<n>   " + strprintf(_("Set the number of threads executing conflict-free transactions when connecting blocks (0 to %d, 0 = serial, default: 0)"), chain::MAX_PARALLEL_CONNECT_THREADS) + "\n";
+    strUsage += "  -blockcache=<n>        " + strprintf(_("Keep up to <n> megabytes of the recently written or read blocks in memory, 0 = disabled (default: %d)"), DEFAULT_BLOCK_CACHE) + "\n";
+    strUsage += "  -dbreadcache=<n>       " + strprintf(_("Keep up to <n> megabytes of the hot chain state data read from disk in memory, 0 = disabled (default: %d)"), DEFAULT_DB_READ_CACHE) + "\n";
+    strUsage += "  -dbflushblocks=<n>     " + strprintf(_("Write chain state to disk in the background every <n> blocks after initial block download (default: %d)"), DEFAULT_DB_FLUSH_BLOCKS) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: coin.pid)") + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
@@ -301,6 +358,7 @@ string HelpMessage() {
 
     strUsage += "\n" + _("Block creation options:") + "\n";
     strUsage += "  -blockmaxsize=<n>      " + strprintf(_("Set maximum block size in bytes (default: %d)"), DEFAULT_BLOCK_MAX_SIZE) + "\n";
+    strUsage += "  -maxmempool=<n>        " + strprintf(_("Keep the memory pool below <n> megabytes, evicting the txs with the lowest fee rate (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE) + "\n";
 
     strUsage += "\n" + _("RPC server options:") + "\n";
     strUsage += "  -rpcserver             " + _("Accept command line and JSON-RPC commands") + "\n";
@@ -493,9 +551,13 @@ bool AppInit(boost::thread_group &threadGroup) {
     }
 
     // Make sure enough file descriptors are available
-    int32_t nBind   = max((int32_t)SysCfg().IsArgCount("-bind"), 1);
     nMaxConnections = SysCfg().GetArg("-maxconnections", 125);
+#ifdef USE_EPOLL
+    nMaxConnections = max(nMaxConnections, 0);
+#else
+    int32_t nBind   = max((int32_t)SysCfg().IsArgCount("-bind"), 1);
     nMaxConnections = max(min(nMaxConnections, (int32_t)(FD_SETSIZE - nBind - MIN_CORE_FILEDESCRIPTORS)), 0);
+#endif
     int32_t nFD     = RaiseFileDescriptorLimit(nMaxConnections + MIN_CORE_FILEDESCRIPTORS);
     if (nFD < MIN_CORE_FILEDESCRIPTORS)
         return InitError(_("Not enough file descriptors available."));
@@ -669,6 +731,25 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetGenReceipt(SysCfg().GetBoolArg("-genreceipt", false));
 
+    chain::SetParallelConnectThreads(SysCfg().GetArg("-parallelconnect", 0));
+
+    // -par=0 means autodetect, but the calling thread verifies signatures as well
+    int32_t nSigCheckThreads = SysCfg().GetArg("-par", DEFAULT_SIG_CHECK_THREADS);
+    if (nSigCheckThreads <= 0)
+        nSigCheckThreads += boost::thread::hardware_concurrency();
+    nSigCheckThreads = max(1, min(nSigCheckThreads, MAX_SIG_CHECK_THREADS));
+    if (nSigCheckThreads > 1) {
+        LogPrint(BCLog::INFO, "Using %d threads for signature verification\n", nSigCheckThreads);
+        signatureCheckQueue.Start(nSigCheckThreads - 1);
+    }
+
+    int32_t nMsgPrecheckThreads = max(0, min((int32_t)SysCfg().GetArg("-msgthreads", DEFAULT_MSG_PRECHECK_THREADS),
+                                              MAX_MSG_PRECHECK_THREADS));
+    if (nMsgPrecheckThreads > 0) {
+        LogPrint(BCLog::INFO, "Using %d threads for message precheck\n", nMsgPrecheckThreads);
+        messagePrecheckQueue.Start(nMsgPrecheckThreads);
+    }
+
     filesystem::path blocksDir = GetDataDir() / "blocks";
     if (!filesystem::exists(blocksDir)) {
         filesystem::create_directories(blocksDir);
@@ -695,6 +776,10 @@ bool AppInit(boost::thread_group &threadGroup) {
 
                 bool fReIndex = SysCfg().IsReindex();
                 pCdMan = new CCacheDBManager(fReIndex, false);
+                if (!pCdMan->RecoverFlushJournal()) {
+                    strLoadError = _("Error recovering the interrupted writing of the chain state");
+                    break;
+                }
                 if (fReIndex)
                     pCdMan->pBlockCache->WriteReindexing(true);
 
@@ -766,7 +851,7 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (SysCfg().IsArgCount("-printblock")) {
         string strMatch = SysCfg().GetArg("-printblock", "");
         int32_t nFound      = 0;
-        for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+        for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
             uint256 hash = (*mi).first;
             if (strncmp(hash.ToString().c_str(), strMatch.c_str(), strMatch.size()) == 0) {
                 CBlockIndex *pIndex = (*mi).second;
@@ -788,45 +873,36 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (!ActivateBestChain(state))
         return InitError("Failed to connect best block");
 
-    nStart                   = GetTimeMillis();
-    CBlockIndex *pBlockIndex = chainActive.Tip();
-    int32_t nCacheHeight     = SysCfg().GetTxCacheHeight();
-    int32_t nCount           = 0;
-    CBlock block;
-    while (pBlockIndex && nCacheHeight-- > 0) {
-        if (!ReadBlockFromDisk(pBlockIndex, block))
-            return InitError("Failed to read block from disk");
-
-        if (!pCdMan->pTxCache->AddBlockTx(block))
+    nStart = GetTimeMillis();
+    if (chainActive.Tip() &&
+        CMemCacheFile().Read(chainActive.Tip()->GetBlockHash(), *pCdMan->pTxCache, *pCdMan->pPpCache)) {
+        LogPrint(BCLog::INFO, "Loaded the memory caches of the latest blocks from memcache.dat (%dms)\n",
+                 GetTimeMillis() - nStart);
+    } else {
+        int32_t nCount = 0;
+        if (!ReadLatestBlocks(SysCfg().GetTxCacheHeight(), [&](const CBlock &block) {
+                ++nCount;
+                return pCdMan->pTxCache->AddBlockTx(block);
+            }))
             return InitError("Failed to add block to transaction memory cache");
-
-        pBlockIndex = pBlockIndex->pprev;
-        ++nCount;
-    }
-    LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
-
-    nStart       = GetTimeMillis();
-    pBlockIndex  = chainActive.Tip();
-    nCacheHeight = 11;  // TODO: parameterize 11.
-    nCount       = 0;
-
-
-    if (pBlockIndex) {
-        if (!ReadBlockFromDisk(pBlockIndex, block))
-            return InitError("Failed to read block from disk");
-    }
-
-    while (pBlockIndex && nCacheHeight-- > 0) {
-        if (!ReadBlockFromDisk(pBlockIndex, block))
-            return InitError("Failed to read block from disk");
-
-        if (!pCdMan->pPpCache->AddPriceByBlock(block))
+        LogPrint(BCLog::INFO, "Added the latest %d blocks to transaction memory cache (%dms)\n", nCount,
+                 GetTimeMillis() - nStart);
+
+        nStart = GetTimeMillis();
+        nCount = 0;
+        // TODO: parameterize 11.
+        if (!ReadLatestBlocks(11, [&](const CBlock &block) {
+                ++nCount;
+                return pCdMan->pPpCache->AddPriceByBlock(block);
+            }))
             return InitError("Failed to add block to price point memory cache");
-
-        pBlockIndex = pBlockIndex->pprev;
-        ++nCount;
+        LogPrint(BCLog::INFO, "Added the latest %d blocks to price point memory cache (%dms)\n", nCount,
+                 GetTimeMillis() - nStart);
     }
-    LogPrint(BCLog::INFO, "Added the latest %d blocks to price point memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
+    fMemCachesLoaded = true;
+
+    // the read only RPCs read the snapshot of the loaded chain state
+    PublishChainStateSnapshot();
 
     vector<boost::filesystem::path> vImportFiles;
     if (SysCfg().IsArgCount("-loadblock")) {
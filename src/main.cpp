@@ -26,7 +26,9 @@
 #include "p2p/processmessage.hpp"
 #include "p2p/sendmessage.hpp"
 #include "chain/blockdelegates.h"
+#include "chain/parallelexec.h"
 #include "persistence/blockundo.h"
+#include "persistence/memcachefile.h"
 #include "tx/txserializer.h"
 
 #include <sstream>
@@ -53,14 +55,17 @@ using namespace boost;
 CCacheDBManager *pCdMan = nullptr;
 CCriticalSection cs_main;
 CTxMemPool mempool;
-map<uint256, CBlockIndex *> mapBlockIndex;
+BlockMap mapBlockIndex;
+CBlockIndexArena blockIndexArena;
 int32_t nSyncTipHeight = 0;
 string publicIp;
 map<uint256/* blockhash */, std::shared_ptr<CCacheWrapper>> mapForkCache;
 CSignatureCache signatureCache;
+CSignatureCheckQueue signatureCheckQueue(signatureCache);
 CChain chainActive;
 CChain chainMostWork;
 bool mining;        // could change from time to time due to vote change
+std::atomic<bool> fMemCachesLoaded{false};
 CKeyID minerKeyId;  // miner accout keyId
 CKeyID nodeKeyId;   // 1st keyId of the node
 extern CPBFTMan pbftMan;
@@ -103,8 +108,8 @@ namespace {
     bool operator()(CBlockIndex *pa, CBlockIndex *pb) const {
 
         // First sort by most total work, ...
-        if (pa->nChainWork != pb->nChainWork) {
-            return (pa->nChainWork < pb->nChainWork) ;
+        if (pa->height != pb->height) {
+            return (pa->height < pb->height) ;
         }
 
         // ... then by earliest time received, ...
@@ -322,7 +327,7 @@ int32_t CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex *&pindexRet) const {
     AssertLockHeld(cs_main);
 
     // Find the block it claims to be in
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(blockHash);
+    BlockMap::iterator mi = mapBlockIndex.find(blockHash);
     if (mi == mapBlockIndex.end())
         return 0;
 
@@ -362,14 +367,10 @@ int32_t GetTxConfirmHeight(const uint256 &hash, CBlockDBCache &blockCache) {
     if (SysCfg().IsTxIndex()) {
         CDiskTxPos diskTxPos;
         if (blockCache.ReadTxIndex(hash, diskTxPos)) {
-            CAutoFile file(OpenBlockFile(diskTxPos, true), SER_DISK, CLIENT_VERSION);
             CBlockHeader header;
-            try {
-                file >> header;
-            } catch (std::exception &e) {
-                ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+            if (!ReadBlockFile(diskTxPos, [&](CBlockFileStream &stream) { stream >> header; }))
                 return -1;
-            }
+
             return header.GetHeight();
         }
     }
@@ -380,6 +381,7 @@ int32_t GetTxConfirmHeight(const uint256 &hash, CBlockDBCache &blockCache) {
 // Return transaction in tx, and if it was found inside a block, its hash is placed in blockHash
 bool GetTransaction(std::shared_ptr<CBaseTx> &pBaseTx, const uint256 &hash, CBlockDBCache &blockCache,
                     bool bSearchMemPool) {
+    CDiskTxPos diskTxPos;
     {
         LOCK(cs_main);
         {
@@ -390,23 +392,12 @@ bool GetTransaction(std::shared_ptr<CBaseTx> &pBaseTx, const uint256 &hash, CBlo
             }
         }
 
-        if (SysCfg().IsTxIndex()) {
-            CDiskTxPos diskTxPos;
-            if (blockCache.ReadTxIndex(hash, diskTxPos)) {
-                CAutoFile file(OpenBlockFile(diskTxPos, true), SER_DISK, CLIENT_VERSION);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file, diskTxPos.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
-                } catch (std::exception &e) {
-                    return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
-                }
-                return true;
-            }
-        }
+        if (!SysCfg().IsTxIndex() || !blockCache.ReadTxIndex(hash, diskTxPos))
+            return false;
     }
-    return false;
+
+    // the block file is read without the lock
+    return ReadTxFromBlockFile(diskTxPos, pBaseTx);
 }
 
 uint256 GetOrphanRoot(const uint256 &hash) {
@@ -450,20 +441,6 @@ bool static PruneOrphanBlocks(int32_t height) {
     return true;
 }
 
-arith_uint256 GetBlockProof(const CBlockIndex &block) {
-    arith_uint256 bnTarget;
-    bool fNegative;
-    bool fOverflow;
-    bnTarget.SetCompact(block.nBits, &fNegative, &fOverflow);
-    if (fNegative || fOverflow || bnTarget == 0)
-        return 0;
-    // We need to compute 2**256 / (bnTarget+1), but we can't represent 2**256
-    // as it's too large for a arith_uint256. However, as 2**256 is at least as large
-    // as bnTarget+1, it is equal to ((2**256 - bnTarget - 1) / (bnTarget+1)) + 1,
-    // or ~bnTarget / (nTarget+1) + 1.
-    return (~bnTarget / (bnTarget + 1)) + 1;
-}
-
 bool fLargeWorkForkFound         = false;
 bool fLargeWorkInvalidChainFound = false;
 CBlockIndex *pIndexBestForkTip   = nullptr;
@@ -482,7 +459,7 @@ void CheckForkWarningConditions() {
 
     if (pIndexBestForkTip ||
         (pIndexBestInvalid &&
-         pIndexBestInvalid->nChainWork > chainActive.Tip()->nChainWork + (GetBlockProof(*chainActive.Tip()) * 6))) {
+         pIndexBestInvalid->GetChainWork() > chainActive.Tip()->GetChainWork())) {
         if (!fLargeWorkForkFound && pIndexBestForkBase) {
             string strCmd = SysCfg().GetArg("-alertnotify", "");
             if (!strCmd.empty()) {
@@ -536,7 +513,7 @@ void CheckForkWarningConditionsOnNewFork(CBlockIndex *pindexNewForkTip) {
     // the 7-block condition and from this always have the most-likely-to-cause-warning fork
     if (pfork &&
         (!pIndexBestForkTip || (pIndexBestForkTip && pindexNewForkTip->height > pIndexBestForkTip->height)) &&
-        pindexNewForkTip->nChainWork - pfork->nChainWork > (GetBlockProof(*pfork) * 7) &&
+        pindexNewForkTip->GetChainWork() > pfork->GetChainWork() &&
         chainActive.Height() - pindexNewForkTip->height < 72) {
         pIndexBestForkTip  = pindexNewForkTip;
         pIndexBestForkBase = pfork;
@@ -566,21 +543,21 @@ void Misbehaving(NodeId pNode, int32_t howmuch) {
 }
 
 void static InvalidChainFound(CBlockIndex *pIndexNew) {
-    if (!pIndexBestInvalid || pIndexNew->nChainWork > pIndexBestInvalid->nChainWork) {
+    if (!pIndexBestInvalid || pIndexNew->height > pIndexBestInvalid->height) {
         pIndexBestInvalid = pIndexNew;
         // The current code doesn't actually read the BestInvalidWork entry in
         // the block database anymore, as it is derived from the flags in block
         // index entry. We only write it for backward compatibility.
         // TODO: need to remove the indexBestInvalid
-        //pCdMan->pBlockCache->WriteBestInvalidWork(ArithToUint256(pIndexBestInvalid->nChainWork));
+        //pCdMan->pBlockCache->WriteBestInvalidWork(ArithToUint256(pIndexBestInvalid->GetChainWork()));
     }
     LogPrint(BCLog::INFO, "InvalidChainFound: invalid block=%s  height=%d  log2_work=%.8g  date=%s\n",
              pIndexNew->GetBlockHash().ToString(), pIndexNew->height,
-             log(pIndexNew->nChainWork.getdouble()) / log(2.0),
+             log(pIndexNew->GetChainWork().getdouble()) / log(2.0),
              DateTimeStrFormat("%Y-%m-%d %H:%M:%S", pIndexNew->GetBlockTime()));
     LogPrint(BCLog::INFO, "InvalidChainFound:  current best=%s  height=%d  log2_work=%.8g  date=%s\n",
              chainActive.Tip()->GetBlockHash().ToString(), chainActive.Height(),
-             log(chainActive.Tip()->nChainWork.getdouble()) / log(2.0),
+             log(chainActive.Tip()->GetChainWork().getdouble()) / log(2.0),
              DateTimeStrFormat("%Y-%m-%d %H:%M:%S", chainActive.Tip()->GetBlockTime()));
     CheckForkWarningConditions();
 }
@@ -644,8 +621,8 @@ bool ReconsiderBlock(CValidationState &state, CBlockIndex *pIndex) {
     AssertLockHeld(cs_main);
 
     // Remove the invalidity flag from this block and all its descendants.
-    map<uint256, CBlockIndex *>::const_iterator it = mapBlockIndex.begin();
-    int32_t height                                    = pIndex->height;
+    BlockMap::const_iterator it = mapBlockIndex.begin();
+    int32_t height               = pIndex->height;
     while (it != mapBlockIndex.end()) {
         if (it->second->nStatus & BLOCK_FAILED_MASK && it->second->GetAncestor(height) == pIndex) {
             it->second->nStatus &= ~BLOCK_FAILED_MASK;
@@ -676,7 +653,8 @@ void UpdateTime(CBlockHeader &block, const CBlockIndex *pIndexPrev) {
     block.SetTime(max(pIndexPrev->GetMedianTimePast() + 1, GetAdjustedTime()));
 }
 
-bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool *pfClean) {
+bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool *pfClean,
+                     set<string> *pChangedDbKeys) {
     assert(pIndex->GetBlockHash() == cw.blockCache.GetBestBlockHash());
 
     if (pfClean)
@@ -699,6 +677,9 @@ bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CVal
         return ERRORMSG("DisconnectBlock() : Undo all data in block failed");
     }
 
+    if (pChangedDbKeys != nullptr)
+        blockUndo.GetDbKeys(*pChangedDbKeys);
+
     // Set previous block as the best block
     cw.blockCache.SetBestBlock(pIndex->pprev->GetBlockHash());
 
@@ -1009,7 +990,8 @@ static bool ComputeVoteStakingInterestAndRevokeVotes(const int32_t currHeight, c
     return true;
 }
 
-bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck) {
+bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck,
+                  set<string> *pChangedDbKeys) {
     AssertLockHeld(cs_main);
 
     bool isGensisBlock = block.GetHeight() == 0 && block.GetHash() == SysCfg().GetGenesisBlockHash();
@@ -1091,17 +1073,13 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
                                  pBaseTx->GetHash().GetHex()), REJECT_INVALID, "tx-invalid-height");
 
             pBaseTx->nFuelRate = fuelRate;
-            CTxUndoOpLogger opLogger(cw, pBaseTx->GetHash(), blockUndo);
+        }
 
-            uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
-            CTxExecuteContext context(pIndex->height, index, fuelRate, pIndex->nTime, prevBlockTime, &cw, &state);
-            if (!pBaseTx->ExecuteTx(context)) {
-                pCdMan->pLogCache->SetExecuteFail(pIndex->height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                  state.GetRejectReason());
-                return state.DoS(100, ERRORMSG("ConnectBlock() : txid=%s execute failed, in detail: %s",
-                                 pBaseTx->GetHash().GetHex(), pBaseTx->ToString(cw.accountCache)), REJECT_INVALID, "tx-execute-failed");
-            }
+        if (!chain::ExecuteBlockTxs(block, pIndex, cw, blockUndo, state))
+            return false;
 
+        for (int32_t index = 1; index < (int32_t)block.vptx.size(); ++index) {
+            std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
             vPos.push_back(make_pair(pBaseTx->GetHash(), pos));
 
             totalRunStep += pBaseTx->nRunStep;
@@ -1224,6 +1202,9 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
         LogPrint(BCLog::INFO, "- Connect %u transactions: %.2fms (%.3fms/tx)\n",
                  (uint32_t)block.vptx.size(), 0.001 * nTime, 0.001 * nTime / block.vptx.size());
 
+    if (pChangedDbKeys != nullptr)
+        blockUndo.GetDbKeys(*pChangedDbKeys);
+
     if (fJustCheck)
         return true;
 
@@ -1260,12 +1241,12 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             pDeleteBlockIndex = pDeleteBlockIndex->pprev;
         }
 
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
+        std::shared_ptr<const CBlock> pDeleteBlock;
+        if (!ReadBlockFromDisk(pDeleteBlockIndex, pDeleteBlock)) {
             return state.Abort(_("ConnectBlock() : failed to read block"));
         }
 
-        if (!cw.txCache.RemoveBlockTx(deleteBlock)) {
+        if (!cw.txCache.RemoveBlockTx(*pDeleteBlock)) {
             return state.Abort(_("ConnectBlock() : failed delete block from transaction memory cache"));
         }
     }
@@ -1281,12 +1262,12 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             pDeleteBlockIndex = pDeleteBlockIndex->pprev;
         }
 
-        CBlock deleteBlock;
-        if (!ReadBlockFromDisk(pDeleteBlockIndex, deleteBlock)) {
+        std::shared_ptr<const CBlock> pDeleteBlock;
+        if (!ReadBlockFromDisk(pDeleteBlockIndex, pDeleteBlock)) {
             return state.Abort(_("ConnectBlock() : failed to read block"));
         }
 
-        if (!cw.ppCache.DeleteBlockFromCache(deleteBlock)) {
+        if (!cw.ppCache.DeleteBlockFromCache(*pDeleteBlock)) {
             return state.Abort(_("ConnectBlock() : failed delete block from price point memory cache"));
         }
     }
@@ -1297,6 +1278,64 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     return true;
 }
 
+// the times the chain state is written by WriteChainState()
+static uint64_t nChainStateFlushes = 0;
+// the latest chain state snapshot, it is accessed by std::atomic_load() and std::atomic_store()
+static std::shared_ptr<const CChainStateSnapshot> spChainStateSnapshot;
+// max. layers of the block changes in a chain state snapshot, the readers look up the data through all the layers
+static const uint32_t MAX_CHAIN_STATE_LAYERS = 20;
+
+// New a frozen layer of the changes of the block to connect or disconnect at the tip, above the published snapshot
+// of the tip. It must be called before the changes are flushed to the global caches, nullptr if there is no such
+// snapshot.
+static std::shared_ptr<CCacheWrapper> NewChainStateLayer(CCacheWrapper &cw) {
+    auto spSnapshot = GetChainStateSnapshot();
+    if (!spSnapshot || IsInitialBlockDownload() || chainActive.Tip() == nullptr ||
+        spSnapshot->blockHash != chainActive.Tip()->GetBlockHash())
+        return nullptr;
+
+    return CCacheWrapper::NewSnapshotLayer(spSnapshot->spCw, cw);
+}
+
+void PublishChainStateSnapshot(const std::shared_ptr<CCacheWrapper> &spTipLayer) {
+    LOCK(cs_main);
+    // During the initial block download, the caches grow large between the writings of the chain state, so they
+    // are copied only right after the writing.
+    static uint64_t nSnapshotFlushes = 0;
+    auto spLastSnapshot              = std::atomic_load(&spChainStateSnapshot);
+    bool fFlushed                    = nSnapshotFlushes != nChainStateFlushes;
+    if (spLastSnapshot && IsInitialBlockDownload() && !fFlushed)
+        return;
+
+    int64_t nStart      = GetTimeMicros();
+    auto spSnapshot     = std::make_shared<CChainStateSnapshot>();
+    spSnapshot->version = spLastSnapshot ? spLastSnapshot->version + 1 : 1;
+    if (chainActive.Tip() != nullptr) {
+        spSnapshot->height    = chainActive.Height();
+        spSnapshot->blockHash = chainActive.Tip()->GetBlockHash();
+    }
+    // Right after the writing, the global caches are empty and cheap to copy, and the copy drops the old layers.
+    if (spTipLayer && spLastSnapshot && !fFlushed && spLastSnapshot->layers < MAX_CHAIN_STATE_LAYERS) {
+        spSnapshot->spCw   = spTipLayer;
+        spSnapshot->layers = spLastSnapshot->layers + 1;
+    } else {
+        spSnapshot->spCw = CCacheWrapper::NewSnapshotFrom(pCdMan);
+        nSnapshotFlushes = nChainStateFlushes;
+    }
+
+    std::atomic_store(&spChainStateSnapshot, std::shared_ptr<const CChainStateSnapshot>(spSnapshot));
+    if (SysCfg().IsBenchmark())
+        LogPrint(BCLog::INFO, "- Publish chain state snapshot: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
+}
+
+void ReleaseChainStateSnapshot() {
+    std::atomic_store(&spChainStateSnapshot, std::shared_ptr<const CChainStateSnapshot>());
+}
+
+std::shared_ptr<const CChainStateSnapshot> GetChainStateSnapshot() {
+    return std::atomic_load(&spChainStateSnapshot);
+}
+
 // Update the on-disk chain state.
 bool static WriteChainState(CValidationState &state) {
     static int64_t nLastWrite = 0;
@@ -1313,8 +1352,16 @@ bool static WriteChainState(CValidationState &state) {
         pCdMan->pLogCache->GetCacheSize() +
         pCdMan->pReceiptCache->GetCacheSize();
 
-    if (!IsInitialBlockDownload() || cacheSize > SysCfg().GetCacheSize() ||
-        GetTimeMicros() > nLastWrite + 60 * 1000000) {
+    // Outside of IBD, the chain state is written every few blocks in the background. After a crash, a writing cut
+    // off between the dbs is completed from the flush journal, and the blocks not written yet are connected again
+    // from the block files, as the best block in db falls behind them.
+    static int32_t nUnflushedBlocks = 0;
+    static int32_t nMaxUnflushedBlocks =
+        std::max<int32_t>(1, SysCfg().GetArg("-dbflushblocks", DEFAULT_DB_FLUSH_BLOCKS));
+    ++nUnflushedBlocks;
+
+    if ((!IsInitialBlockDownload() && nUnflushedBlocks >= nMaxUnflushedBlocks) ||
+        cacheSize > SysCfg().GetCacheSize() || GetTimeMicros() > nLastWrite + 60 * 1000000) {
         // Typical CCoins structures on disk are around 100 bytes in size.
         // Pushing a new one to the database can cause it to be written
         // twice (once in the log, and once in the tables). This is already
@@ -1324,10 +1371,20 @@ bool static WriteChainState(CValidationState &state) {
             return state.Error("out of disk space");
 
         FlushBlockFile();
+        // The mem caches are written now and then too, so a restart after a crash rarely rebuilds them.
+        static int64_t nLastMemCacheWrite = GetTime();
+        if (fMemCachesLoaded && GetTime() > nLastMemCacheWrite + MEM_CACHE_FILE_WRITE_INTERVAL) {
+            CMemCacheFile().Write(pCdMan->pBlockCache->GetBestBlockHash(), *pCdMan->pTxCache, *pCdMan->pPpCache);
+            nLastMemCacheWrite = GetTime();
+        }
         // pCdMan->pBlockCache->Sync();
-        pCdMan->Flush();
+        if (!pCdMan->AsyncFlush())
+            return state.Abort(_("Failed to write chain state"));
+        ++nChainStateFlushes;
+
         mapForkCache.clear();
-        nLastWrite = GetTimeMicros();
+        nLastWrite       = GetTimeMicros();
+        nUnflushedBlocks = 0;
     }
     return true;
 }
@@ -1377,12 +1434,15 @@ bool static DisconnectTip(CValidationState &state) {
         return state.Abort(_("Failed to read blocks from disk."));
     // Apply the block atomically to the chain state.
     int64_t nStart = GetTimeMicros();
+    set<string> changedDbKeys;
+    std::shared_ptr<CCacheWrapper> spTipLayer;
     {
         auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
 
-        if (!DisconnectBlock(block, *spCW, pIndexDelete, state))
+        if (!DisconnectBlock(block, *spCW, pIndexDelete, state, nullptr, &changedDbKeys))
             return ERRORMSG("DisconnectTip() : DisconnectBlock %s failed", pIndexDelete->GetBlockHash().ToString());
 
+        spTipLayer = NewChainStateLayer(*spCW);
         // Need to re-sync all to global cache layer.
         spCW->Flush();
 
@@ -1402,6 +1462,8 @@ bool static DisconnectTip(CValidationState &state) {
         return false;
     // Update chainActive and related variables.
     UpdateTip(pIndexDelete->pprev, block);
+    PublishChainStateSnapshot(spTipLayer);
+    mempool.AddChangedDbKeys(changedDbKeys);
     // Resurrect mempool transactions from the disconnected block.
     for (const auto &pTx : block.vptx) {
         list<std::shared_ptr<CBaseTx> > removed;
@@ -1428,11 +1490,13 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
 
     // Apply the block automatically to the chain state.
     int64_t nStart = GetTimeMicros();
+    set<string> changedDbKeys;
+    std::shared_ptr<CCacheWrapper> spTipLayer;
     {
         CInv inv(MSG_BLOCK, pIndexNew->GetBlockHash());
 
         auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
-        if (!ConnectBlock(block, *spCW, pIndexNew, state)) {
+        if (!ConnectBlock(block, *spCW, pIndexNew, state, false, &changedDbKeys)) {
             if (state.IsInvalid()) {
                 InvalidBlockFound(pIndexNew, state);
             }
@@ -1444,6 +1508,7 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
             mapBlockSource.erase(inv.hash);
         }
 
+        spTipLayer = NewChainStateLayer(*spCW);
         // Need to re-sync all to global cache layer.
         spCW->Flush();
     }
@@ -1457,10 +1522,10 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
 
     // Update chainActive & related variables.
     UpdateTip(pIndexNew, block);
+    PublishChainStateSnapshot(spTipLayer);
 
-    for (auto &pTxItem : block.vptx) {
-        mempool.memPoolTxs.erase(pTxItem->GetHash());
-    }
+    mempool.AddChangedDbKeys(changedDbKeys);
+    mempool.RemoveConfirmedTxs(block);
     return true;
 }
 
@@ -1491,7 +1556,7 @@ void static FindMostWorkChain() {
         while (pindexTest && !chainActive.Contains(pindexTest)) {
             if (pindexTest->nStatus & BLOCK_FAILED_MASK) {
                 // Candidate has an invalid ancestor, remove entire chain from the set.
-                if (pIndexBestInvalid == nullptr || pIndexNew->nChainWork > pIndexBestInvalid->nChainWork)
+                if (pIndexBestInvalid == nullptr || pIndexNew->height > pIndexBestInvalid->height)
                     pIndexBestInvalid = pIndexNew;
                 CBlockIndex *pindexFailed = pIndexNew;
                 while (pindexTest != pindexFailed) {
@@ -1641,10 +1706,10 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
         LOCK(cs_nBlockSequenceId);
         pIndexNew->nSequenceId = nBlockSequenceId++;
     }
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
+    BlockMap::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
     // LogPrint(BCLog::INFO, "in map hash:%s map size:%d\n", hash.GetHex(), mapBlockIndex.size());
     pIndexNew->pBlockHash                        = &((*mi).first);
-    map<uint256, CBlockIndex *>::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
+    BlockMap::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
     if (miPrev != mapBlockIndex.end()) {
         pIndexNew->pprev  = (*miPrev).second;
         pIndexNew->height = pIndexNew->pprev->height + 1;
@@ -1656,7 +1721,6 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
     else
         pIndexNew->miner = block.vptx[0]->txUid.get<CRegID>();
     pIndexNew->nTx        = block.vptx.size();
-    pIndexNew->nChainWork = pIndexNew->height;
     pIndexNew->nChainTx   = (pIndexNew->pprev ? pIndexNew->pprev->nChainTx : 0) + pIndexNew->nTx;
     pIndexNew->nFile      = pos.nFile;
     pIndexNew->nDataPos   = pos.nPos;
@@ -1794,9 +1858,15 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
         LogPrint(BCLog::INFO, "ProcessForkedChain() : found [%d]: %s in cache\n",
             pPreBlockIndex->height, forkChainTipBlockHash.GetHex());
     } else {
-        spCW                     = CCacheWrapper::NewCopyFrom(pCdMan);
+        // The forked chain state is a child of the frozen chain state at the tip, it only owns the data changed by
+        // the disconnected blocks.
         int64_t beginTime        = GetTimeMillis();
         CBlockIndex *pBlockIndex = chainActive.Tip();
+        auto spSnapshot          = GetChainStateSnapshot();
+        if (spSnapshot && spSnapshot->blockHash == pBlockIndex->GetBlockHash())
+            spCW = CCacheWrapper::NewChildOf(spSnapshot->spCw);
+        else
+            spCW = CCacheWrapper::NewChildOf(CCacheWrapper::NewSnapshotFrom(pCdMan));
 
         while (pPreBlockIndex != pBlockIndex) {
             LogPrint(BCLog::INFO, "ProcessForkedChain() : disconnect block [%d]: %s\n", pBlockIndex->height,
@@ -1886,6 +1956,38 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
     return true;
 }
 
+// Verify the signatures of block txs on the signature check queue in advance, so the serial CheckTx() only hits
+// the signature cache. The invalid signatures are not cached, and CheckTx() will reject them.
+static void PreVerifyBlockSignatures(const CBlock &block, CCacheWrapper &cw) {
+    int64_t nStart = GetTimeMicros();
+
+    vector<CSignatureCheck> checks;
+    checks.reserve(block.vptx.size());
+    for (const auto &pBaseTx : block.vptx) {
+        if (pBaseTx->signature.empty() || pBaseTx->txUid.IsEmpty())
+            continue;
+
+        CPubKey pubKey;
+        if (pBaseTx->txUid.is<CPubKey>()) {
+            pubKey = pBaseTx->txUid.get<CPubKey>();
+        } else {
+            CAccount account;
+            if (!cw.accountCache.GetAccount(pBaseTx->txUid, account))
+                continue;
+
+            pubKey = account.owner_pubkey;
+        }
+
+        if (pubKey.IsValid())
+            checks.emplace_back(pBaseTx->GetHash(), pBaseTx->signature, pubKey);
+    }
+
+    signatureCheckQueue.Verify(checks);
+
+    if (SysCfg().IsBenchmark())
+        LogPrint(BCLog::INFO, "- Verify %u signatures: %.2fms\n", checks.size(), 0.001 * (GetTimeMicros() - nStart));
+}
+
 bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw, bool fCheckTx, bool fCheckMerkleRoot) {
     if (block.vptx.empty() || block.vptx.size() > MAX_BLOCK_SIZE ||
         ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION) > MAX_BLOCK_SIZE)
@@ -1915,6 +2017,10 @@ bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw,
     // but catching it earlier avoids a potential DoS attack:
     set<uint256> uniqueTx;
     uint32_t priceMedianTxCount = 0;
+
+    if (fCheckTx && signatureCheckQueue.IsEnabled())
+        PreVerifyBlockSignatures(block, cw);
+
     for (uint32_t i = 0; i < block.vptx.size(); i++) {
         uniqueTx.insert(block.GetTxid(i));
 
@@ -1980,7 +2086,7 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex *pPrevBlockIndex = nullptr;
     int32_t height = 0;
     if (block.GetHeight() != 0 || blockHash != SysCfg().GetGenesisBlockHash()) {
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
+        BlockMap::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
         if (mi == mapBlockIndex.end())
             return state.DoS(10, ERRORMSG("AcceptBlock() : prev block not found"), 0, "bad-prevblk");
 
@@ -2039,11 +2145,19 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex* pTip = chainActive.Tip() ;
     if (pTip->GetBlockHash() == blockHash) {
         {
+            // the peers rebuild the produced block from their mempool, the old peers get it in full
+            std::unique_ptr<CCompactBlock> pCmpctBlock;
+            if (mining)
+                pCmpctBlock.reset(new CCompactBlock(block));
+
             LOCK(cs_vNodes);
             for (auto pNode : vNodes) {
                 //p2p_xiaoyu_20191116
                 if (mining) {
-                    pNode->PushMessage(NetMsgType::BLOCK, block);
+                    if (pNode->fCompactBlock)
+                        pNode->PushMessage(NetMsgType::CMPCTBLOCK, *pCmpctBlock);
+                    else
+                        pNode->PushMessage(NetMsgType::BLOCK, block);
                     continue;
                 }
                 if (chainActive.Height() > (pNode->nStartingHeight != -1 ? pNode->nStartingHeight - 2000 : 0))
@@ -2243,7 +2357,14 @@ bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBl
                      pBlock->GetHeight(), pBlock->GetHash().GetHex(), success ? "keep" : "abandon",
                      chainActive.Height(), chainActive.Tip()->GetBlockHash().GetHex(), mapOrphanBlocksByPrev.size());
 
-            PushGetBlocksOnCondition(pFrom, chainActive.Tip(), GetOrphanRoot(blockHash));
+            // the blocks of the sync headers arrive out of order, their parents are being downloaded
+            bool isSyncHeader;
+            {
+                LOCK(cs_mapNodeState);
+                isSyncHeader = IsSyncHeader(blockHash);
+            }
+            if (!isSyncHeader)
+                PushGetBlocksOnCondition(pFrom, chainActive.Tip(), GetOrphanRoot(blockHash));
         }
         return true;
     }
@@ -2309,27 +2430,18 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes) {
 }
 
 bool static LoadBlockIndexDB() {
-    if (!pCdMan->pBlockIndexDb->LoadBlockIndexes())
+    vector<CBlockIndex *> vSortedByHeight;
+    if (!pCdMan->pBlockIndexDb->LoadBlockIndexes(vSortedByHeight))
         return ERRORMSG("%s(), LoadBlockIndexes from db failed", __FUNCTION__);
 
     boost::this_thread::interruption_point();
 
-    // Calculate nChainWork
-    vector<pair<int32_t, CBlockIndex *> > vSortedByHeight;
-    vSortedByHeight.reserve(mapBlockIndex.size());
-    for (const auto &item : mapBlockIndex) {
-        CBlockIndex *pIndex = item.second;
-        vSortedByHeight.push_back(make_pair(pIndex->height, pIndex));
-    }
-    sort(vSortedByHeight.begin(), vSortedByHeight.end());
-    for (const auto &item : vSortedByHeight) {
-        CBlockIndex *pIndex = item.second;
-        pIndex->nChainWork  = pIndex->height;
-        pIndex->nChainTx    = (pIndex->pprev ? pIndex->pprev->nChainTx : 0) + pIndex->nTx;
+    // Calculate nChainTx, the ancestors go first in height order
+    for (CBlockIndex *pIndex : vSortedByHeight) {
+        pIndex->nChainTx = (pIndex->pprev ? pIndex->pprev->nChainTx : 0) + pIndex->nTx;
         if ((pIndex->nStatus & BLOCK_VALID_MASK) >= BLOCK_VALID_TRANSACTIONS && !(pIndex->nStatus & BLOCK_FAILED_MASK))
             setBlockIndexValid.insert(pIndex);
-        if (pIndex->nStatus & BLOCK_FAILED_MASK &&
-            (!pIndexBestInvalid || pIndex->nChainWork > pIndexBestInvalid->nChainWork))
+        if (pIndex->nStatus & BLOCK_FAILED_MASK && (!pIndexBestInvalid || pIndex->height > pIndexBestInvalid->height))
             pIndexBestInvalid = pIndex;
         if (pIndex->pprev)
             pIndex->BuildSkip();
@@ -2517,7 +2629,7 @@ void PrintBlockTree() {
     AssertLockHeld(cs_main);
     // pre-compute tree structure
     map<CBlockIndex *, vector<CBlockIndex *> > mapNext;
-    for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+    for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
         CBlockIndex *pIndex = (*mi).second;
         mapNext[pIndex->pprev].push_back(pIndex);
     }
@@ -2697,9 +2809,11 @@ class CMainCleanup {
     CMainCleanup() {}
     ~CMainCleanup() {
         // block headers
-        map<uint256, CBlockIndex *>::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
+        BlockMap::iterator it1 = mapBlockIndex.begin();
+        for (; it1 != mapBlockIndex.end(); it1++) {
+            if (!blockIndexArena.Owns((*it1).second))
+                delete (*it1).second;
+        }
         mapBlockIndex.clear();
 
         // orphan blocks
@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
 #include <exception>
 #include <map>
 #include <set>
@@ -43,15 +44,19 @@ extern CCriticalSection cs_main;
 /** The currently-connected chain of blocks. */
 extern CChain chainActive;
 extern CSignatureCache signatureCache;
+extern CSignatureCheckQueue signatureCheckQueue;
 
 extern CTxMemPool mempool;
-extern map<uint256, CBlockIndex *> mapBlockIndex;
+extern BlockMap mapBlockIndex;
+extern CBlockIndexArena blockIndexArena;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
 extern const string strMessageMagic;
 extern bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) ;
+extern bool ReadBlockFromDisk(const CBlockIndex *pIndex, std::shared_ptr<const CBlock> &pBlock);
 
 extern bool mining;     // could be changed due to vote change
+extern std::atomic<bool> fMemCachesLoaded;  // the mem caches of the recent blocks are loaded at startup
 extern CKeyID minerKeyId;  // miner accout keyId
 extern CKeyID nodeKeyId;   // first keyId of the node
 
@@ -214,10 +219,14 @@ protected:
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  In case pfClean is provided, operation will try to be tolerant about errors, and *pfClean
  *  will be true if no problems were found. Otherwise, the return value will be false in case
- *  of problems. Note that in any case, coins may be modified. */
-bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool *pfClean = nullptr);
-// Apply the effects of this block (with given index) on the UTXO set represented by coins
-bool ConnectBlock   (CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck = false);
+ *  of problems. Note that in any case, coins may be modified.
+ *  In case pChangedDbKeys is provided, the db keys restored by the undo data are added to it. */
+bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool *pfClean = nullptr,
+                     set<string> *pChangedDbKeys = nullptr);
+// Apply the effects of this block (with given index) on the UTXO set represented by coins,
+// the db keys changed by the block are added to pChangedDbKeys if provided
+bool ConnectBlock   (CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck = false,
+                     set<string> *pChangedDbKeys = nullptr);
 
 // Add this block to the block index, and if necessary, switch the active block chain to this
 bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos &pos);
@@ -263,4 +272,26 @@ bool ActivateBestChain(CValidationState &state, CBlockIndex* pNewIndex = nullptr
 /** Remove invalidity status from a block and its descendants. */
 bool ReconsiderBlock(CValidationState &state, CBlockIndex *pIndex);
 
+/**
+ * An immutable snapshot of the chain state at the tip, published after each block connected or disconnected. The
+ * read only RPCs read it without holding cs_main, each through its own child cache wrapper of spCw.
+ */
+struct CChainStateSnapshot {
+    uint64_t version = 0;  // increased by each published snapshot
+    int32_t height   = -1;
+    uint256 blockHash;
+    std::shared_ptr<CCacheWrapper> spCw;  // see CCacheWrapper::NewSnapshotFrom() and NewSnapshotLayer()
+    uint32_t layers = 0;                  // the layers of the block changes above the copy of the global caches
+};
+
+/**
+ * Publish the snapshot of the current chain state. The changes of the tip block are layered on the last snapshot
+ * if spTipLayer is given, see NewChainStateLayer().
+ */
+void PublishChainStateSnapshot(const std::shared_ptr<CCacheWrapper> &spTipLayer = nullptr);
+/** Release the published snapshot, it must be done before closing the dbs */
+void ReleaseChainStateSnapshot();
+/** Get the latest published snapshot, nullptr before the chain state is loaded */
+std::shared_ptr<const CChainStateSnapshot> GetChainStateSnapshot();
+
 #endif
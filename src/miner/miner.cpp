@@ -82,28 +82,42 @@ uint32_t GetElementForBurn(CBlockIndex *pIndex) {
     return newFuelRate;
 }
 
-// Sort transactions by priority and fee to decide priority orders to process transactions.
-void GetPriorityTx(int32_t height, set<TxPriority> &txPriorities, const int32_t nFuelRate) {
-    static TokenSymbol feeSymbol;
-    static uint64_t fee    = 0;
-    static uint32_t txSize = 0;
-    static double feePerKb = 0;
-    static double priority = 0;
-
-    for (map<uint256, CTxMemPoolEntry>::iterator mi = mempool.memPoolTxs.begin(); mi != mempool.memPoolTxs.end(); ++mi) {
-        CBaseTx *pBaseTx = mi->second.GetTransaction().get();
-        if (!pBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HaveTx(pBaseTx->GetHash())) {
-            feeSymbol = std::get<0>(mi->second.GetFees());
-            fee       = std::get<1>(mi->second.GetFees());
-            txSize    = mi->second.GetTxSize();
-            feePerKb  = double(fee - pBaseTx->GetFuel(height, nFuelRate)) / txSize * 1000.0;
-            priority  = mi->second.GetPriority();
-
-            txPriorities.emplace(TxPriority(priority, feePerKb, mi->second.GetTransaction()));
+// Walk the memory pool txs in packing order by the mempool priority index, and merge in the txs created by the
+// miner by their priority level. Only the txs taken are looked at, no sort of the whole pool is needed.
+class CPriorityTxQueue {
+public:
+    CPriorityTxQueue() : itor(mempool.priorityIndex.rbegin()) {}
+
+    void Push(const std::shared_ptr<CBaseTx> &pBaseTx, double priority) {
+        minerTxs.emplace(int32_t(priority / TRANSACTION_PRIORITY_CEILING), pBaseTx);
+    }
+
+    // Return nullptr if no tx is left.
+    std::shared_ptr<CBaseTx> Pop() {
+        while (true) {
+            if (!minerTxs.empty() &&
+                (itor == mempool.priorityIndex.rend() || minerTxs.rbegin()->first >= itor->priorityLevel)) {
+                auto it                          = std::prev(minerTxs.end());
+                std::shared_ptr<CBaseTx> pBaseTx = it->second;
+                minerTxs.erase(it);
+                return pBaseTx;
+            }
+
+            if (itor == mempool.priorityIndex.rend())
+                return nullptr;
+
+            auto mi = mempool.memPoolTxs.find((itor++)->txid);
+            assert(mi != mempool.memPoolTxs.end());
+            std::shared_ptr<CBaseTx> pBaseTx = mi->second.GetTransaction();
+            if (!pBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HaveTx(pBaseTx->GetHash()))
+                return pBaseTx;
         }
     }
-}
 
+private:
+    set<CTxMemPoolPriorityKey>::const_reverse_iterator itor;
+    multimap<int32_t, std::shared_ptr<CBaseTx>> minerTxs;  // priority level -> tx
+};
 
 bool GetCurrentDelegate(const int64_t currentTime, const int32_t currHeight, const VoteDelegateVector &delegates,
                                VoteDelegate &delegate) {
@@ -176,6 +190,35 @@ void ShuffleDelegates(const int32_t curHeight, const int64_t blockTime, VoteDele
 }
 
 
+bool VerifyBlockProducer(const CBlockHeader &header, CCacheWrapper &cw) {
+    VoteDelegateVector delegates;
+    if (!cw.delegateCache.GetActiveDelegates(delegates) || delegates.empty())
+        return ERRORMSG("VerifyBlockProducer() : failed to get active delegates");
+
+    ShuffleDelegates(header.GetHeight(), header.GetTime(), delegates);
+
+    VoteDelegate delegate;
+    if (!GetCurrentDelegate(header.GetTime(), header.GetHeight(), delegates, delegate))
+        return ERRORMSG("VerifyBlockProducer() : failed to get current delegate");
+
+    CAccount account;
+    if (!cw.accountCache.GetAccount(delegate.regid, account))
+        return ERRORMSG("VerifyBlockProducer() : failed to get delegate's account, regId=%s",
+                        delegate.regid.ToString());
+
+    const auto &blockHash      = header.GetHash();
+    const auto &blockSignature = header.GetSignature();
+    if (blockSignature.size() == 0 || blockSignature.size() > MAX_SIGNATURE_SIZE)
+        return ERRORMSG("VerifyBlockProducer() : invalid block signature size, hash=%s", blockHash.ToString());
+
+    if (!VerifySignature(blockHash, blockSignature, account.owner_pubkey) &&
+        !VerifySignature(blockHash, blockSignature, account.miner_pubkey))
+        return ERRORMSG("VerifyBlockProducer() : verify signature error, hash=%s, delegate=%s", blockHash.ToString(),
+                        delegate.regid.ToString());
+
+    return true;
+}
+
 bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx, VoteDelegate &curDelegateOut, uint32_t& totalDelegateNumOut) {
     uint32_t maxNonce = SysCfg().GetBlockMaxNonce();
 
@@ -290,6 +333,41 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx,
     return true;
 }
 
+bool ExecuteTxToPack(CBaseTx *pBaseTx, CTxExecuteContext &context, uint64_t totalRunStep, bool &packed) {
+    // Execute the tx in the block cache directly, the data written by a tx not packed is rolled back.
+    CCacheWrapper &cw = *context.pCw;
+    cw.SetSavepoint();
+    packed = false;
+
+    try {
+        if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
+            LogPrint(BCLog::MINER, "ExecuteTxToPack() : failed to pack transaction: %s\n",
+                     pBaseTx->ToString(cw.accountCache));
+
+            pCdMan->pLogCache->SetExecuteFail(context.height, pBaseTx->GetHash(), context.pState->GetRejectCode(),
+                                              context.pState->GetRejectReason());
+        } else if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
+            // Run step limits
+            LogPrint(BCLog::MINER, "ExecuteTxToPack() : exceed max block run steps, txid: %s\n",
+                     pBaseTx->GetHash().GetHex());
+        } else {
+            packed = true;
+        }
+    } catch (std::exception &e) {
+        LogPrint(BCLog::ERROR, "ExecuteTxToPack() : unexpected exception: %s\n", e.what());
+    }
+
+    if (!packed) {
+        if (!cw.RollbackToSavepoint())
+            return ERRORMSG("ExecuteTxToPack() : failed to roll back transaction, txid: %s", pBaseTx->GetHash().GetHex());
+
+        return true;
+    }
+
+    cw.ReleaseSavepoint();
+    return true;
+}
+
 static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_ptr<CBlock> &pBlock) {
     pBlock->vptx.push_back(std::make_shared<CBlockRewardTx>());
 
@@ -313,16 +391,16 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
         uint64_t totalFuel      = 0;
         uint64_t reward         = 0;
 
-        // Calculate && sort transactions from memory pool.
-        set<TxPriority> txPriorities;
-        GetPriorityTx(height, txPriorities, fuelRate);
+        // Take transactions from memory pool in priority order.
+        CPriorityTxQueue txQueue;
 
-        LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
-                 txPriorities.size());
+        LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : got %lu transaction(s) in memory pool\n",
+                 mempool.priorityIndex.size());
 
         // Collect transactions into the block.
-        for (auto itor = txPriorities.rbegin(); itor != txPriorities.rend(); ++itor) {
-            CBaseTx *pBaseTx = itor->baseTx.get();
+        int64_t nStart = GetTimeMicros();
+        for (auto spBaseTx = txQueue.Pop(); spBaseTx; spBaseTx = txQueue.Pop()) {
+            CBaseTx *pBaseTx = spBaseTx.get();
 
             uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
             if (totalBlockSize + txSize >= nBlockMaxSize) {
@@ -331,34 +409,16 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
                 continue;
             }
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
-
-            try {
-                CValidationState state;
-                pBaseTx->nFuelRate = fuelRate;
-                uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
-                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, spCW.get(), &state, transaction_status_type::mining);
-                if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
-                    LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : failed to pack transaction, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
-
-                    pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                      state.GetRejectReason());
-                    continue;
-                }
-
-                // Run step limits
-                if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
-                    LogPrint(BCLog::MINER, "CreateNewBlockPreStableCoinRelease() : exceed max block run steps, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
-                    continue;
-                }
-            } catch (std::exception &e) {
-                LogPrint(BCLog::ERROR, "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
+            CValidationState state;
+            pBaseTx->nFuelRate = fuelRate;
+            uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
+            CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, &cwIn, &state, transaction_status_type::mining);
+            bool fPacked = false;
+            if (!ExecuteTxToPack(pBaseTx, context, totalRunStep, fPacked))
+                return false;
+
+            if (!fPacked)
                 continue;
-            }
-
-            spCW->Flush();
 
             auto fuel        = pBaseTx->GetFuel(height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
@@ -374,12 +434,16 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
 
             ++index;
 
-            pBlock->vptx.push_back(itor->baseTx);
+            pBlock->vptx.push_back(spBaseTx);
 
             LogPrint(BCLog::DEBUG, "miner total fuel fee:%d, tx fuel fee:%d, fuel:%d, fuelRate:%d, txid:%s\n", totalFuel,
                      pBaseTx->GetFuel(height, fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
         }
 
+        if (SysCfg().IsBenchmark())
+            LogPrint(BCLog::INFO, "- Pack %d transactions: %.2fms (%.3fms/tx)\n", index, 0.001 * (GetTimeMicros() - nStart),
+                     index > 0 ? 0.001 * (GetTimeMicros() - nStart) / index : 0.0);
+
         nLastBlockTx                   = index + 1;
         nLastBlockSize                 = totalBlockSize;
 
@@ -445,18 +509,18 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
         uint64_t totalFuel                 = 0;
         map<TokenSymbol, uint64_t> rewards = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
 
-        // Calculate && sort transactions from memory pool.
-        set<TxPriority> txPriorities;
-        GetPriorityTx(height, txPriorities, fuelRate);
+        // Take transactions from memory pool in priority order.
+        CPriorityTxQueue txQueue;
 
         // Push block price median transaction into queue.
-        txPriorities.emplace(TxPriority(PRICE_MEDIAN_TRANSACTION_PRIORITY, 0, std::make_shared<CBlockPriceMedianTx>(height)));
+        txQueue.Push(std::make_shared<CBlockPriceMedianTx>(height), PRICE_MEDIAN_TRANSACTION_PRIORITY);
 
-        LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
-                 txPriorities.size());
+        LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : got %lu transaction(s) in memory pool\n",
+                 mempool.priorityIndex.size());
 
         // Collect transactions into the block.
-        for (auto itor = txPriorities.rbegin(); itor != txPriorities.rend(); ++itor) {
+        int64_t nStart = GetTimeMicros();
+        for (auto spBaseTx = txQueue.Pop(); spBaseTx; spBaseTx = txQueue.Pop()) {
 
             if (!CheckPackBlockTime(startMiningMs, height)) {
                 LogPrint(BCLog::MINER, "%s() : no time left to pack more tx, ignore! height=%d, start_ms=%lld, tx_count=%u\n",
@@ -464,7 +528,7 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
                 break;
             }
 
-            CBaseTx *pBaseTx = itor->baseTx.get();
+            CBaseTx *pBaseTx = spBaseTx.get();
 
             uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
             if (totalBlockSize + txSize >= nBlockMaxSize) {
@@ -473,51 +537,32 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
                 continue;
             }
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
-
-            try {
-                CValidationState state;
-
-                pBaseTx->nFuelRate = fuelRate;
-
-                // Special case for price median tx,
-                if (pBaseTx->IsPriceMedianTx()) {
-                    CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)itor->baseTx.get();
+            CValidationState state;
 
-                    PriceMap medianPrices;
-                    if (!spCW->ppCache.CalcBlockMedianPrices(*spCW, height, medianPrices))
-                        return ERRORMSG("%s(), calculate block median prices error", __func__);
+            pBaseTx->nFuelRate = fuelRate;
 
-                    pPriceMedianTx->SetMedianPrices(medianPrices);
-                }
+            // Special case for price median tx,
+            if (pBaseTx->IsPriceMedianTx()) {
+                CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)pBaseTx;
 
-                LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : begin to pack transaction: %s\n",
-                         pBaseTx->ToString(spCW->accountCache));
+                PriceMap medianPrices;
+                if (!cwIn.ppCache.CalcBlockMedianPrices(cwIn, height, medianPrices))
+                    return ERRORMSG("%s(), calculate block median prices error", __func__);
 
-                uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
-                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, spCW.get(), &state, transaction_status_type::mining);
-                if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
-                    LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : failed to pack transaction: %s\n",
-                             pBaseTx->ToString(spCW->accountCache));
+                pPriceMedianTx->SetMedianPrices(medianPrices);
+            }
 
-                    pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                      state.GetRejectReason());
-                    continue;
-                }
+            LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : begin to pack transaction: %s\n",
+                     pBaseTx->ToString(cwIn.accountCache));
 
-                // Run step limits
-                if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
-                    LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : exceed max block run steps, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
-                    continue;
-                }
-            } catch (std::exception &e) {
-                LogPrint(BCLog::ERROR, "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
+            uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
+            CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, &cwIn, &state, transaction_status_type::mining);
+            bool fPacked = false;
+            if (!ExecuteTxToPack(pBaseTx, context, totalRunStep, fPacked))
+                return false;
 
+            if (!fPacked)
                 continue;
-            }
-
-            spCW->Flush();
 
             auto fuel        = pBaseTx->GetFuel(height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
@@ -533,13 +578,17 @@ static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper
 
             ++index;
 
-            pBlock->vptx.push_back(itor->baseTx);
+            pBlock->vptx.push_back(spBaseTx);
 
             LogPrint(BCLog::DEBUG, "miner total fuel fee:%d, tx fuel fee:%d, fuel:%d, fuelRate:%d, txid:%s\n", totalFuel,
                      pBaseTx->GetFuel(height, fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
 
         }
 
+        if (SysCfg().IsBenchmark())
+            LogPrint(BCLog::INFO, "- Pack %d transactions: %.2fms (%.3fms/tx)\n", index, 0.001 * (GetTimeMicros() - nStart),
+                     index > 0 ? 0.001 * (GetTimeMicros() - nStart) / index : 0.0);
+
         nLastBlockTx                   = index + 1;
         nLastBlockSize                 = totalBlockSize;
 
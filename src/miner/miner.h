@@ -18,6 +18,7 @@
 #include "tx/tx.h"
 
 class CBlock;
+class CBlockHeader;
 class CBlockIndex;
 class CWallet;
 class CBaseTx;
@@ -39,27 +40,6 @@ struct Miner {
     CKey key;
 };
 
-struct TxPriority {
-    double priority;
-    double feePerKb;
-    std::shared_ptr<CBaseTx> baseTx;
-
-    TxPriority(const double priorityIn, const double feePerKbIn, const std::shared_ptr<CBaseTx> &baseTxIn)
-        : priority(priorityIn), feePerKb(feePerKbIn), baseTx(baseTxIn) {}
-
-    bool operator<(const TxPriority &other) const {
-        if (fabs(this->priority - other.priority) <= 1000) {
-            if (fabs(this->feePerKb < other.feePerKb) <= 1e-8) {
-                return this->baseTx->GetHash() < other.baseTx->GetHash();
-            } else {
-                return this->feePerKb < other.feePerKb;
-            }
-        } else {
-            return this->priority < other.priority;
-        }
-    }
-};
-
 // mined block info
 class MinedBlockInfo {
 public:
@@ -87,14 +67,22 @@ void GenerateProduceBlockThread(bool fGenerate, CWallet *pWallet, int32_t nThrea
 
 bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx, VoteDelegate &curDelegateOut, uint32_t& totalDelegateNumOut);
 
+/** Verify the header is signed by the delegate of its DPoS slot, taken from the active delegates of the cache */
+bool VerifyBlockProducer(const CBlockHeader &header, CCacheWrapper &cw);
+
+/**
+ * Execute a tx in the cache of the block being packed. The tx runs under a savepoint of the cache, so the data written
+ * by a tx failing or exceeding the block run steps is rolled back, and the data of the txs packed before it is kept.
+ * Returns false only if the rollback failed.
+ */
+bool ExecuteTxToPack(CBaseTx *pBaseTx, CTxExecuteContext &context, uint64_t totalRunStep, bool &packed);
+
 /** Check mined block */
 bool CheckWork(CBlock *pBlock);
 
 /** Get burn element */
 uint32_t GetElementForBurn(CBlockIndex *pIndex);
 
-void GetPriorityTx(vector<TxPriority> &vecPriority, int32_t nFuelRate);
-
 void ShuffleDelegates(const int32_t nCurHeight, const int64_t blockTime,
         VoteDelegateVector &delegates);
 
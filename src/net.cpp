@@ -29,6 +29,10 @@
 #include <miniupnpc/upnperrors.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #include <sys/statvfs.h>
 #include <sys/sysinfo.h>
 #include <sys/utsname.h>
@@ -423,6 +427,63 @@ CNode* FindNode(const CService& addr) {
     return nullptr;
 }
 
+static list<CNode*> vNodesDisconnected;
+
+#ifdef USE_EPOLL
+static int32_t epollFd = -1;
+// the nodes whose sockets are registered to epoll, by node id. Protected by cs_vNodes.
+static map<NodeId, CNode*> mapEpollNodes;
+// tag of the epoll events of the listening sockets, the events of the nodes carry the node id
+static const uint64_t EPOLL_LISTEN_SOCKET_TAG = 1ULL << 32;
+// max. number of the events handled by one epoll_wait()
+static const int32_t MAX_EPOLL_EVENTS = 256;
+#endif
+
+// Wakes up ThreadMessageHandler when there is a complete or prechecked message received
+static boost::mutex mutexMsgProc;
+static boost::condition_variable condMsgProc;
+static bool fMsgProcWake = false;
+
+void WakeMessageHandler() {
+    {
+        boost::lock_guard<boost::mutex> lock(mutexMsgProc);
+        fMsgProcWake = true;
+    }
+    condMsgProc.notify_one();
+}
+
+static bool IsSelectableSocket(SOCKET hSocket) {
+#ifdef WIN32
+    return true;
+#else
+#ifdef USE_EPOLL
+    if (epollFd != -1)
+        return true;
+#endif
+    return hSocket < FD_SETSIZE;
+#endif
+}
+
+// Add the node to vNodes, and register its socket to epoll, once for its lifetime.
+static void AddNode(CNode* pNode) {
+    LOCK(cs_vNodes);
+    vNodes.push_back(pNode);
+
+#ifdef USE_EPOLL
+    if (epollFd != -1) {
+        struct epoll_event event;
+        event.events   = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = pNode->GetId();
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, pNode->hSocket, &event) == SOCKET_ERROR) {
+            LogPrint(BCLog::INFO, "socket[%s] epoll_ctl add failed, error %s\n", pNode->addr.ToString(),
+                     NetworkErrorString(errno));
+            pNode->CloseSocketDisconnect();
+        }
+        mapEpollNodes[pNode->GetId()] = pNode;
+    }
+#endif
+}
+
 CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
     if (pszDest == nullptr) {
         if (IsLocal(addrConnect))
@@ -445,6 +506,12 @@ CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
                 : ConnectSocket(addrConnect, hSocket)) {
         addrman.Attempt(addrConnect);
 
+        if (!IsSelectableSocket(hSocket)) {
+            LogPrint(BCLog::INFO, "Cannot create connection: non-selectable socket created (fd >= FD_SETSIZE ?)\n");
+            closesocket(hSocket);
+            return nullptr;
+        }
+
         LogPrint(BCLog::NET, "connected %s\n", pszDest ? pszDest : addrConnect.ToString());
 
         // Set to non-blocking
@@ -462,11 +529,7 @@ CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
         // Add node
         CNode* pNode = new CNode(hSocket, addrConnect, pszDest ? pszDest : "", false);
         pNode->AddRef();
-
-        {
-            LOCK(cs_vNodes);
-            vNodes.push_back(pNode);
-        }
+        AddNode(pNode);
 
         pNode->nTimeConnected = GetTime();
         return pNode;
@@ -475,70 +538,331 @@ CNode* ConnectNode(CAddress addrConnect, const char* pszDest) {
     }
 }
 
+static void DisconnectNodes(uint32_t& nPrevNodeCount) {
+    {
+        LOCK(cs_vNodes);
+        // Disconnect unused nodes
+        vector<CNode*> vNodesCopy = vNodes;
+        for (auto pNode : vNodesCopy) {
+            if (pNode->fDisconnect || (pNode->GetRefCount() <= 0 && pNode->vRecvMsg.empty() &&
+                                       pNode->nSendSize == 0 && pNode->ssSend.empty())) {
+                // remove from vNodes
+                vNodes.erase(remove(vNodes.begin(), vNodes.end(), pNode), vNodes.end());
+#ifdef USE_EPOLL
+                // the socket is removed from epoll when it's closed
+                mapEpollNodes.erase(pNode->GetId());
+#endif
 
-static list<CNode*> vNodesDisconnected;
+                // release outbound grant (if any)
+                pNode->grantOutbound.Release();
 
-void ThreadSocketHandler() {
-    uint32_t nPrevNodeCount = 0;
-    while (true) {
-        //
-        // Disconnect nodes
-        //
+                // close socket and cleanup
+                pNode->CloseSocketDisconnect();
+                pNode->Cleanup();
+
+                // hold in disconnected pool until all refs are released
+                if (pNode->fNetworkNode || pNode->fInbound)
+                    pNode->Release();
+                vNodesDisconnected.push_back(pNode);
+            }
+        }
+    }
+    {
+        // Delete disconnected nodes
+        list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
+        for (auto pNode : vNodesDisconnectedCopy) {
+            // wait until threads are done using it
+            if (pNode->GetRefCount() <= 0) {
+                bool fDelete = false;
+                {
+                    TRY_LOCK(pNode->cs_vSend, lockSend);
+                    if (lockSend) {
+                        TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+                        if (lockRecv) {
+                            TRY_LOCK(pNode->cs_inventory, lockInv);
+                            if (lockInv)
+                                fDelete = true;
+                        }
+                    }
+                }
+                if (fDelete) {
+                    vNodesDisconnected.remove(pNode);
+                    delete pNode;
+                }
+            }
+        }
+    }
+    if (vNodes.size() != nPrevNodeCount) {
+        nPrevNodeCount = vNodes.size();
+
+        LogPrint(BCLog::INFO, "Connections number changed, %d -> %d\n", nPrevNodeCount, vNodes.size());
+    }
+}
+
+static void AcceptConnection(SOCKET hListenSocket) {
+    struct sockaddr_storage sockaddr;
+    socklen_t len  = sizeof(sockaddr);
+    SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
+    CAddress addr;
+    int32_t nInbound = 0;
+
+    if (hSocket != INVALID_SOCKET)
+        if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
+            LogPrint(BCLog::INFO, "Warning: Unknown socket family\n");
+
+    {
+        LOCK(cs_vNodes);
+        for (auto pNode : vNodes)
+            if (pNode->fInbound)
+                nInbound++;
+    }
+
+    if (hSocket == INVALID_SOCKET) {
+        int32_t nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK)
+            LogPrint(BCLog::INFO, "socket[%s] error accept failed: %s\n", addr.ToString(), NetworkErrorString(nErr));
+    } else if (!IsSelectableSocket(hSocket)) {
+        LogPrint(BCLog::INFO, "connection from %s dropped: non-selectable socket\n", addr.ToString());
+        closesocket(hSocket);
+    } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
+        closesocket(hSocket);
+    } else if (CNode::IsBanned(addr)) {
+        LogPrint(BCLog::INFO, "connection from %s dropped (banned)\n", addr.ToString());
+        closesocket(hSocket);
+    } else {
+        LogPrint(BCLog::NET, "accepted connection %s\n", addr.ToString());
+#ifdef USE_EPOLL
+        // the sockets are read until they would block for the edge-triggered events
+        if (epollFd != -1 && fcntl(hSocket, F_SETFL, O_NONBLOCK) == SOCKET_ERROR)
+            LogPrint(BCLog::INFO, "AcceptConnection() : fcntl non-blocking setting failed, error %s\n",
+                     NetworkErrorString(errno));
+#endif
+        CNode* pNode = new CNode(hSocket, addr, "", true);
+        pNode->AddRef();
+        AddNode(pNode);
+    }
+}
+
+// Receive the data from the socket of the node, until it would block if fDrain. Return false if the data is left
+// for later, as the receive buffer is locked or full.
+static bool SocketRecvData(CNode* pNode, bool fDrain) {
+    TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+    if (!lockRecv)
+        return false;
+
+    bool fDone = true;
+    while (pNode->hSocket != INVALID_SOCKET) {
+        if (fDrain && pNode->GetTotalRecvSize() > ReceiveFloodSize()) {
+            fDone = false;
+            break;
+        }
+
+        // typical socket buffer is 8K-64K
+        char pchBuf[0x10000];
+        int32_t nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+        if (nBytes > 0) {
+            if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
+                pNode->CloseSocketDisconnect();
+            pNode->nLastRecv = GetTime();
+            pNode->nRecvBytes += nBytes;
+            pNode->RecordBytesRecv(nBytes);
+        } else if (nBytes == 0) {
+            // socket closed gracefully
+            if (!pNode->fDisconnect)
+                LogPrint(BCLog::NET, "socket[%s] closed\n", pNode->addr.ToString());
+            pNode->CloseSocketDisconnect();
+        } else if (nBytes < 0) {
+            // error
+            int32_t nErr = WSAGetLastError();
+            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS) {
+                if (!pNode->fDisconnect)
+                    LogPrint(BCLog::INFO, "socket[%s] recv error %s\n", pNode->addr.ToString(), NetworkErrorString(nErr));
+                pNode->CloseSocketDisconnect();
+            }
+            fDone = (nErr != WSAEINTR);
+            break;
+        }
+
+        if (!fDrain)
+            break;
+    }
+
+    if (!pNode->vRecvMsg.empty() && pNode->vRecvMsg.front().complete())
+        WakeMessageHandler();
+
+    return fDone;
+}
+
+static void InactivityCheck(CNode* pNode) {
+    if (pNode->vSendMsg.empty())
+        pNode->nLastSendEmpty = GetTime();
+    // p2p_xiaoyu_20191126
+    // if (GetTime() - pNode->nTimeConnected > 60) {
+    //     if (pNode->nLastRecv == 0 || pNode->nLastSend == 0) {
+    //         LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d\n", pNode->nLastRecv != 0,
+    //                  pNode->nLastSend != 0);
+    //         pNode->fDisconnect = true;
+    //     } else if (GetTime() - pNode->nLastSend > 90 * 60 && GetTime() - pNode->nLastSendEmpty > 90 * 60) {
+    //         LogPrint(BCLog::INFO, "socket not sending\n");
+    //         pNode->fDisconnect = true;
+    //     } else if (GetTime() - pNode->nLastRecv > 90 * 60) {
+    //         LogPrint(BCLog::INFO, "socket inactivity timeout\n");
+    //         pNode->fDisconnect = true;
+    //     }
+    // }
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime - pNode->nTimeConnected > DEFAULT_PEER_CONNECT_TIMEOUT)
+    {
+        if (pNode->nLastRecv == 0 || pNode->nLastSend == 0)
+        {
+            LogPrint(BCLog::NET, "socket no message in first %i seconds, %d %d from %d\n", DEFAULT_PEER_CONNECT_TIMEOUT, pNode->nLastRecv != 0, pNode->nLastSend != 0, pNode->GetId());
+            pNode->fDisconnect = true;
+        }
+        else if (nTime - pNode->nLastSend > TIMEOUT_INTERVAL)
         {
+            LogPrint(BCLog::NET, "socket sending timeout: %is\n", nTime - pNode->nLastSend);
+            pNode->fDisconnect = true;
+        }
+        else if (nTime - pNode->nLastRecv > TIMEOUT_INTERVAL )
+        {
+            LogPrint(BCLog::NET, "socket receive timeout: %is\n", nTime - pNode->nLastRecv);
+            pNode->fDisconnect = true;
+        }
+        else if (pNode->nPingNonceSent && pNode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            LogPrint(BCLog::NET, "ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pNode->nPingUsecStart));
+            pNode->fDisconnect = true;
+        }
+        else if (!pNode->fSuccessfullyConnected)
+        {
+            LogPrint(BCLog::NET, "version handshake timeout from %d\n", pNode->GetId());
+            pNode->fDisconnect = true;
+        }
+    }
+}
+
+#ifdef USE_EPOLL
+// The sockets are registered to epoll once with the edge-triggered events. An event of a node is pending until its
+// data is read until the socket would block, or until its send queue is flushed. The nodes are only visited for their
+// events, the disconnection and the inactivity of all the nodes are checked every 100 ms.
+static void ThreadSocketHandlerEpoll() {
+    uint32_t nPrevNodeCount   = 0;
+    int64_t nLastHousekeeping = 0;
+    set<NodeId> setPendingRecv;
+    set<NodeId> setPendingSend;
+    vector<struct epoll_event> vEvents(MAX_EPOLL_EVENTS);
+
+    while (true) {
+        int64_t nNow = GetTimeMillis();
+        if (nNow - nLastHousekeeping >= 100) {
+            nLastHousekeeping = nNow;
+            DisconnectNodes(nPrevNodeCount);
+
             LOCK(cs_vNodes);
-            // Disconnect unused nodes
-            vector<CNode*> vNodesCopy = vNodes;
-            for (auto pNode : vNodesCopy) {
-                if (pNode->fDisconnect || (pNode->GetRefCount() <= 0 && pNode->vRecvMsg.empty() &&
-                                           pNode->nSendSize == 0 && pNode->ssSend.empty())) {
-                    // remove from vNodes
-                    vNodes.erase(remove(vNodes.begin(), vNodes.end(), pNode), vNodes.end());
-
-                    // release outbound grant (if any)
-                    pNode->grantOutbound.Release();
-
-                    // close socket and cleanup
-                    pNode->CloseSocketDisconnect();
-                    pNode->Cleanup();
-
-                    // hold in disconnected pool until all refs are released
-                    if (pNode->fNetworkNode || pNode->fInbound)
-                        pNode->Release();
-                    vNodesDisconnected.push_back(pNode);
-                }
+            for (auto pNode : vNodes)
+                InactivityCheck(pNode);
+        }
+
+        int32_t nTimeout = (setPendingRecv.empty() && setPendingSend.empty()) ? 50 : 10;
+        int32_t nEvents  = epoll_wait(epollFd, vEvents.data(), vEvents.size(), nTimeout);
+        boost::this_thread::interruption_point();
+
+        if (nEvents == SOCKET_ERROR) {
+            if (errno != EINTR) {
+                LogPrint(BCLog::INFO, "socket epoll_wait error %s\n", NetworkErrorString(errno));
+                MilliSleep(nTimeout);
+            }
+            nEvents = 0;
+        }
+
+        for (int32_t i = 0; i < nEvents; i++) {
+            const struct epoll_event& event = vEvents[i];
+            if (event.data.u64 & EPOLL_LISTEN_SOCKET_TAG) {
+                AcceptConnection((SOCKET)(event.data.u64 & ~EPOLL_LISTEN_SOCKET_TAG));
+                continue;
             }
+
+            NodeId nodeId = (NodeId)event.data.u64;
+            if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                setPendingRecv.insert(nodeId);
+            if (event.events & EPOLLOUT)
+                setPendingSend.insert(nodeId);
         }
+
+        if (setPendingRecv.empty() && setPendingSend.empty())
+            continue;
+
+        vector<CNode*> vNodesPending;
         {
-            // Delete disconnected nodes
-            list<CNode*> vNodesDisconnectedCopy = vNodesDisconnected;
-            for (auto pNode : vNodesDisconnectedCopy) {
-                // wait until threads are done using it
-                if (pNode->GetRefCount() <= 0) {
-                    bool fDelete = false;
-                    {
-                        TRY_LOCK(pNode->cs_vSend, lockSend);
-                        if (lockSend) {
-                            TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                            if (lockRecv) {
-                                TRY_LOCK(pNode->cs_inventory, lockInv);
-                                if (lockInv)
-                                    fDelete = true;
-                            }
-                        }
+            LOCK(cs_vNodes);
+            for (auto pSet : {&setPendingRecv, &setPendingSend}) {
+                for (auto it = pSet->begin(); it != pSet->end();) {
+                    auto nodeIt = mapEpollNodes.find(*it);
+                    if (nodeIt == mapEpollNodes.end()) {
+                        it = pSet->erase(it);
+                        continue;
                     }
-                    if (fDelete) {
-                        vNodesDisconnected.remove(pNode);
-                        delete pNode;
+
+                    if (pSet == &setPendingRecv || !setPendingRecv.count(*it)) {
+                        nodeIt->second->AddRef();
+                        vNodesPending.push_back(nodeIt->second);
                     }
+                    ++it;
                 }
             }
         }
-        if (vNodes.size() != nPrevNodeCount) {
-            nPrevNodeCount = vNodes.size();
 
-            LogPrint(BCLog::INFO, "Connections number changed, %d -> %d\n", nPrevNodeCount, vNodes.size());
+        for (auto pNode : vNodesPending) {
+            boost::this_thread::interruption_point();
+
+            NodeId nodeId = pNode->GetId();
+            if (pNode->hSocket == INVALID_SOCKET) {
+                setPendingRecv.erase(nodeId);
+                setPendingSend.erase(nodeId);
+                continue;
+            }
+
+            //
+            // Receive
+            //
+            if (setPendingRecv.count(nodeId) && SocketRecvData(pNode, true))
+                setPendingRecv.erase(nodeId);
+
+            //
+            // Send, the writability is only of interest when the send queue is not empty
+            //
+            if (pNode->hSocket != INVALID_SOCKET && setPendingSend.count(nodeId)) {
+                TRY_LOCK(pNode->cs_vSend, lockSend);
+                if (lockSend) {
+                    if (!pNode->vSendMsg.empty())
+                        pNode->SocketSendData();
+                    setPendingSend.erase(nodeId);
+                }
+            }
         }
 
+        {
+            LOCK(cs_vNodes);
+            for (auto pNode : vNodesPending)
+                pNode->Release();
+        }
+    }
+}
+#endif
+
+void ThreadSocketHandler() {
+#ifdef USE_EPOLL
+    if (epollFd != -1)
+        return ThreadSocketHandlerEpoll();
+#endif
+
+    uint32_t nPrevNodeCount = 0;
+    while (true) {
+        //
+        // Disconnect nodes
+        //
+        DisconnectNodes(nPrevNodeCount);
+
         //
         // Find which sockets have data to receive
         //
@@ -621,43 +945,8 @@ void ThreadSocketHandler() {
         // Accept new connections
         //
         for (auto hListenSocket : vhListenSocket)
-            if (hListenSocket != INVALID_SOCKET && FD_ISSET(hListenSocket, &fdsetRecv)) {
-                struct sockaddr_storage sockaddr;
-                socklen_t len  = sizeof(sockaddr);
-                SOCKET hSocket = accept(hListenSocket, (struct sockaddr*)&sockaddr, &len);
-                CAddress addr;
-                int32_t nInbound = 0;
-
-                if (hSocket != INVALID_SOCKET)
-                    if (!addr.SetSockAddr((const struct sockaddr*)&sockaddr))
-                        LogPrint(BCLog::INFO, "Warning: Unknown socket family\n");
-
-                {
-                    LOCK(cs_vNodes);
-                    for (auto pNode : vNodes)
-                        if (pNode->fInbound)
-                            nInbound++;
-                }
-
-                if (hSocket == INVALID_SOCKET) {
-                    int32_t nErr = WSAGetLastError();
-                    if (nErr != WSAEWOULDBLOCK)
-                        LogPrint(BCLog::INFO, "socket[%s] error accept failed: %s\n", addr.ToString(), NetworkErrorString(nErr));
-                } else if (nInbound >= nMaxConnections - MAX_OUTBOUND_CONNECTIONS) {
-                    closesocket(hSocket);
-                } else if (CNode::IsBanned(addr)) {
-                    LogPrint(BCLog::INFO, "connection from %s dropped (banned)\n", addr.ToString());
-                    closesocket(hSocket);
-                } else {
-                    LogPrint(BCLog::NET, "accepted connection %s\n", addr.ToString());
-                    CNode* pNode = new CNode(hSocket, addr, "", true);
-                    pNode->AddRef();
-                    {
-                        LOCK(cs_vNodes);
-                        vNodes.push_back(pNode);
-                    }
-                }
-            }
+            if (hListenSocket != INVALID_SOCKET && FD_ISSET(hListenSocket, &fdsetRecv))
+                AcceptConnection(hListenSocket);
 
         //
         // Service each socket
@@ -677,37 +966,8 @@ void ThreadSocketHandler() {
             //
             if (pNode->hSocket == INVALID_SOCKET)
                 continue;
-            if (FD_ISSET(pNode->hSocket, &fdsetRecv) || FD_ISSET(pNode->hSocket, &fdsetError)) {
-                TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
-                if (lockRecv) {
-                    {
-                        // typical socket buffer is 8K-64K
-                        char pchBuf[0x10000];
-                        int32_t nBytes = recv(pNode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                        if (nBytes > 0) {
-                            if (!pNode->ReceiveMsgBytes(pchBuf, nBytes))
-                                pNode->CloseSocketDisconnect();
-                            pNode->nLastRecv = GetTime();
-                            pNode->nRecvBytes += nBytes;
-                            pNode->RecordBytesRecv(nBytes);
-                        } else if (nBytes == 0) {
-                            // socket closed gracefully
-                            if (!pNode->fDisconnect)
-                                LogPrint(BCLog::NET, "socket[%s] closed\n", pNode->addr.ToString());
-                            pNode->CloseSocketDisconnect();
-                        } else if (nBytes < 0) {
-                            // error
-                            int32_t nErr = WSAGetLastError();
-                            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR &&
-                                nErr != WSAEINPROGRESS) {
-                                if (!pNode->fDisconnect)
-                                    LogPrint(BCLog::INFO, "socket[%s] recv error %s\n", pNode->addr.ToString(), NetworkErrorString(nErr));
-                                pNode->CloseSocketDisconnect();
-                            }
-                        }
-                    }
-                }
-            }
+            if (FD_ISSET(pNode->hSocket, &fdsetRecv) || FD_ISSET(pNode->hSocket, &fdsetError))
+                SocketRecvData(pNode, false);
 
             //
             // Send
@@ -723,53 +983,7 @@ void ThreadSocketHandler() {
             //
             // Inactivity checking
             //
-            if (pNode->vSendMsg.empty())
-                pNode->nLastSendEmpty = GetTime();
-            // p2p_xiaoyu_20191126
-            // if (GetTime() - pNode->nTimeConnected > 60) {
-            //     if (pNode->nLastRecv == 0 || pNode->nLastSend == 0) {
-            //         LogPrint(BCLog::NET, "socket no message in first 60 seconds, %d %d\n", pNode->nLastRecv != 0,
-            //                  pNode->nLastSend != 0);
-            //         pNode->fDisconnect = true;
-            //     } else if (GetTime() - pNode->nLastSend > 90 * 60 && GetTime() - pNode->nLastSendEmpty > 90 * 60) {
-            //         LogPrint(BCLog::INFO, "socket not sending\n");
-            //         pNode->fDisconnect = true;
-            //     } else if (GetTime() - pNode->nLastRecv > 90 * 60) {
-            //         LogPrint(BCLog::INFO, "socket inactivity timeout\n");
-            //         pNode->fDisconnect = true;
-            //     }
-            // }
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pNode->nTimeConnected > DEFAULT_PEER_CONNECT_TIMEOUT)
-            {
-                if (pNode->nLastRecv == 0 || pNode->nLastSend == 0)
-                {
-                    LogPrint(BCLog::NET, "socket no message in first %i seconds, %d %d from %d\n", DEFAULT_PEER_CONNECT_TIMEOUT, pNode->nLastRecv != 0, pNode->nLastSend != 0, pNode->GetId());
-                    pNode->fDisconnect = true;
-                }
-                else if (nTime - pNode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    LogPrint(BCLog::NET, "socket sending timeout: %is\n", nTime - pNode->nLastSend);
-                    pNode->fDisconnect = true;
-                }
-                else if (nTime - pNode->nLastRecv > TIMEOUT_INTERVAL )
-                {
-                    LogPrint(BCLog::NET, "socket receive timeout: %is\n", nTime - pNode->nLastRecv);
-                    pNode->fDisconnect = true;
-                }
-                else if (pNode->nPingNonceSent && pNode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    LogPrint(BCLog::NET, "ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pNode->nPingUsecStart));
-                    pNode->fDisconnect = true;
-                }
-                else if (!pNode->fSuccessfullyConnected)
-                {
-                    LogPrint(BCLog::NET, "version handshake timeout from %d\n", pNode->GetId());
-                    pNode->fDisconnect = true;
-                }
-            }
-
-
+            InactivityCheck(pNode);
         }
 
         {
@@ -1210,7 +1424,8 @@ void ThreadMessageHandler() {
 
                     if (pNode->nSendSize < SendBufferSize()) {
                         if (!pNode->vRecvGetData.empty() ||
-                            (!pNode->vRecvMsg.empty() && pNode->vRecvMsg[0].complete())) {
+                            (!pNode->vRecvMsg.empty() && pNode->vRecvMsg[0].complete() &&
+                             !pNode->vRecvMsg[0].IsPrecheckPending())) {
                             fSleep = false;
                         }
                     }
@@ -1234,8 +1449,14 @@ void ThreadMessageHandler() {
                 pNode->Release();
         }
 
-        if (fSleep)
-            MilliSleep(100);
+        if (fSleep) {
+            // wait for the socket thread to receive a complete message, the nodes are still polled every 100 ms
+            // to send their messages
+            boost::unique_lock<boost::mutex> lock(mutexMsgProc);
+            if (!fMsgProcWake)
+                condMsgProc.timed_wait(lock, boost::posix_time::milliseconds(100));
+            fMsgProcWake = false;
+        }
     }
 }
 
@@ -1407,6 +1628,25 @@ void StartNode(boost::thread_group& threadGroup) {
     MapPort(SysCfg().GetBoolArg("-upnp", USE_UPNP));
 #endif
 
+#ifdef USE_EPOLL
+    if (epollFd == -1) {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd == SOCKET_ERROR)
+            LogPrint(BCLog::INFO, "epoll_create1 failed, error %s, fall back to select\n", NetworkErrorString(errno));
+
+        for (auto hListenSocket : vhListenSocket) {
+            if (epollFd == -1 || hListenSocket == INVALID_SOCKET)
+                continue;
+
+            struct epoll_event event;
+            event.events   = EPOLLIN;
+            event.data.u64 = EPOLL_LISTEN_SOCKET_TAG | (uint64_t)hListenSocket;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, hListenSocket, &event) == SOCKET_ERROR)
+                LogPrint(BCLog::INFO, "epoll_ctl add listening socket failed, error %s\n", NetworkErrorString(errno));
+        }
+    }
+#endif
+
     // Send and receive from sockets, accept connections
     threadGroup.create_thread(boost::bind(&TraceThread<void (*)()>, "net", &ThreadSocketHandler));
 
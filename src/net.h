@@ -20,6 +20,11 @@
 #include <arpa/inet.h>
 #endif
 
+// The sockets are polled by epoll on Linux, which is not limited by FD_SETSIZE
+#ifdef __linux__
+#define USE_EPOLL
+#endif
+
 #include <openssl/rand.h>
 #include <boost/foreach.hpp>
 
@@ -51,6 +56,7 @@ uint16_t GetListenPort();
 bool BindListenPort(const CService& bindAddr, string& strError = REF(string()));
 void StartNode(boost::thread_group& threadGroup);
 bool StopNode();
+void WakeMessageHandler();
 
 enum {
     LOCAL_NONE,    // unknown
@@ -7,12 +7,16 @@
 #define CHAINMESSAGE_H
 
 #include "alert.h"
+#include "chain/blockdelegates.h"
 #include "commons/uint256.h"
 #include "commons/util/util.h"
 #include "main.h"
 #include "net.h"
+#include "miner/miner.h"
 #include "miner/pbftcontext.h"
 #include "miner/pbftmanager.h"
+#include "p2p/compactblock.h"
+#include "p2p/msgprecheck.h"
 #include "tx/einvalidtxtype.h"
 
 #include <string>
@@ -46,6 +50,9 @@ map<uint256, tuple<NodeId, list<uint256>::iterator, int64_t>> mapBlocksToDownloa
 // them, if processing happens afterwards. Protected by cs_main.
 map<uint256, NodeId> mapBlockSource;  // Remember who we got this block from.
 
+// The compact blocks waiting for their missing txs from the peer. Protected by cs_main.
+map<uint256, tuple<NodeId, CPartialBlock, int64_t>> mapPartialBlocks;
+
 
 // Requires cs_mapNodeState.
 void MarkBlockAsReceived(const uint256 &hash, NodeId nodeFrom = -1) {
@@ -71,6 +78,90 @@ void MarkBlockAsReceived(const uint256 &hash, NodeId nodeFrom = -1) {
     }
 }
 
+// Headers-first sync. The headers above the chain tip received from the sync peers, the blocks of the headers in a
+// moving window above the tip are downloaded from all the good peers in parallel. Protected by cs_mapNodeState.
+struct CSyncHeaders {
+    map<int32_t, uint256> hashes;   // height -> hash
+    map<uint256, int32_t> heights;  // hash -> height
+
+    // a header of another fork replaces the ones at and above its height
+    void Add(int32_t height, const uint256 &hash) {
+        auto it = hashes.find(height);
+        if (it != hashes.end()) {
+            if (it->second == hash)
+                return;
+
+            for (auto eraseIt = it; eraseIt != hashes.end(); ++eraseIt)
+                heights.erase(eraseIt->second);
+            hashes.erase(it, hashes.end());
+        }
+        hashes[height] = hash;
+        heights[hash]  = height;
+    }
+
+    // drop the headers at and below the tip
+    void Prune(int32_t tipHeight) {
+        auto end = hashes.upper_bound(tipHeight);
+        for (auto it = hashes.begin(); it != end; ++it)
+            heights.erase(it->second);
+        hashes.erase(hashes.begin(), end);
+    }
+} syncHeaders;
+
+// Requires cs_mapNodeState.
+void ReleaseStalledBlocks(NodeId nodeId, int64_t now) {
+    CNodeState *state = State(nodeId);
+    state->nStallingSince = now;
+
+    vector<uint256> vHashes;
+    for (const auto &entry : state->vBlocksInFlight)
+        vHashes.push_back(entry.hash);
+    for (const auto &hash : vHashes)
+        MarkBlockAsReceived(hash);
+
+    LogPrint(BCLog::NET, "peer %s is stalling the block download window, reassign its %u blocks in flight\n",
+             state->name, vHashes.size());
+}
+
+// Requires cs_main and cs_mapNodeState.
+// Pick the blocks of the download window for the peer, the blocks of the peer holding back the window are
+// reassigned when it stalls.
+void FindBlocksToDownload(CNode *pTo, CNodeState &state, vector<uint256> &vBlocks) {
+    int32_t tipHeight = chainActive.Height();
+    syncHeaders.Prune(tipHeight);
+
+    int64_t now = GetTimeMicros();
+    if (syncHeaders.hashes.empty() || now - state.nStallingSince < BLOCK_DOWNLOAD_TIMEOUT * 1000000)
+        return;
+
+    int32_t windowEnd = std::min(tipHeight + BLOCK_DOWNLOAD_WINDOW, pTo->nStartingHeight);
+    bool isFirstMissing = true;
+    for (auto it = syncHeaders.hashes.upper_bound(tipHeight); it != syncHeaders.hashes.end() && it->first <= windowEnd;
+         ++it) {
+        if (state.nBlocksInFlight + (int32_t)vBlocks.size() >= MAX_BLOCKS_IN_TRANSIT_PER_PEER)
+            break;
+
+        const uint256 &hash = it->second;
+        if (mapBlockIndex.count(hash) || mapOrphanBlocks.count(hash) || mapBlocksToDownload.count(hash))
+            continue;
+
+        auto flightIt = mapBlocksInFlight.find(hash);
+        if (flightIt != mapBlocksInFlight.end()) {
+            NodeId nodeId = std::get<0>(flightIt->second);
+            if (!isFirstMissing || nodeId == pTo->GetId() ||
+                now - std::get<2>(flightIt->second) < BLOCK_STALLING_TIMEOUT * 1000000) {
+                isFirstMissing = false;
+                continue;
+            }
+
+            ReleaseStalledBlocks(nodeId, now);
+        }
+
+        isFirstMissing = false;
+        vBlocks.push_back(hash);
+    }
+}
+
 }  // namespace
 
 struct COrphanBlock {
@@ -82,6 +173,55 @@ struct COrphanBlock {
 
 static CMedianFilter<int32_t> cPeerBlockCounts(8, 0);
 
+// Requires cs_mapNodeState.
+inline bool IsSyncHeader(const uint256 &hash) {
+    AssertLockHeld(cs_mapNodeState);
+    return syncHeaders.heights.count(hash) > 0;
+}
+
+// Requires cs_main.
+// The active delegates of the tip produce the blocks up to the height where the next delegates may be activated, on
+// any chain above the tip. The pending delegates are activated at the end of the block of their activation height.
+inline int32_t GetTipDelegatesEndHeight() {
+    int32_t tipHeight = chainActive.Height();
+    int32_t interval  = chain::GetActivateDelegateInterval(tipHeight + 1);
+
+    PendingDelegates pendingDelegates;
+    pCdMan->pDelegateCache->GetPendingDelegates(pendingDelegates);
+    if (pendingDelegates.state == VoteDelegateState::PENDING)
+        return std::max<int32_t>(pendingDelegates.counted_vote_height + interval, tipHeight + 1);
+
+    return tipHeight + 1 + interval;
+}
+
+// Requires cs_main.
+// A sync header is taken only when it is produced in time by the delegate of its slot. The producer is checked with the
+// active delegates of the tip, which is done for the headers up to endHeight only, the ones above are left to the
+// validation of their blocks.
+inline bool CheckSyncHeader(const CBlockHeader &header, int32_t endHeight) {
+    if (header.GetBlockTime() > GetAdjustedTime() + ::GetBlockInterval(header.GetHeight()) + 2)
+        return ERRORMSG("CheckSyncHeader() : header timestamp too far in the future, height=%d", header.GetHeight());
+
+    if ((int32_t)header.GetHeight() > endHeight)
+        return true;
+
+    CCacheWrapper cw(pCdMan);
+    return VerifyBlockProducer(header, cw);
+}
+
+// Requires cs_main and cs_mapNodeState.
+// Ask the peer for the headers following the last one we have.
+inline void PushGetHeaders(CNode *pNode) {
+    CBlockLocator locator = chainActive.GetLocator();
+    if (!syncHeaders.hashes.empty())
+        locator.vHave.insert(locator.vHave.begin(), syncHeaders.hashes.rbegin()->second);
+
+    pNode->PushMessage(NetMsgType::GETHEADERS, locator, uint256());
+    State(pNode->GetId())->fHeadersRequested = true;
+    LogPrint(BCLog::NET, "getheaders from peer %s, tip_height=%d, sync_headers=%u\n", pNode->addrName,
+             chainActive.Height(), syncHeaders.hashes.size());
+}
+
 inline void ProcessGetData(CNode *pFrom) {
     deque<CInv>::iterator it = pFrom->vRecvGetData.begin();
 
@@ -101,9 +241,9 @@ inline void ProcessGetData(CNode *pFrom) {
             boost::this_thread::interruption_point();
             it++;
 
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK) {
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK) {
                 bool send                                = false;
-                map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(inv.hash);
+                BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
                 if (mi != mapBlockIndex.end()) {
                     send = true;
                 } else {
@@ -118,6 +258,10 @@ inline void ProcessGetData(CNode *pFrom) {
                         LogPrint(BCLog::NET, "send block[%u]: %s to peer %s\n", block.GetHeight(), block.GetHash().GetHex(),
                                  pFrom->addr.ToString());
                         pFrom->PushMessage(NetMsgType::BLOCK, block);
+                    } else if (inv.type == MSG_CMPCT_BLOCK) {
+                        LogPrint(BCLog::NET, "send cmpctblock[%u]: %s to peer %s\n", block.GetHeight(),
+                                 block.GetHash().GetHex(), pFrom->addr.ToString());
+                        pFrom->PushMessage(NetMsgType::CMPCTBLOCK, CCompactBlock(block));
                     }
                     else  // MSG_FILTERED_BLOCK)
                     {
@@ -180,7 +324,7 @@ inline void ProcessGetData(CNode *pFrom) {
             // Track requests for our stuff.
             // g_signals.Inventory(inv.hash);
 
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK)
+            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK)
                 break;
         }
     }
@@ -479,13 +623,16 @@ inline bool ProcessAddrMessage(CNode *pFrom, CDataStream &vRecv) {
     return true;
 }
 
-inline bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv) {
-    std::shared_ptr<CBaseTx> pBaseTx;
-    try {
-        vRecv >> pBaseTx;
-    } catch(EInvalidTxType e) {
-        // TODO: record the misebehaving or ban the peer node.
-        return ERRORMSG("Unknown transaction type from peer %s, ignore! %s", pFrom->addr.ToString(), e.what());
+inline bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv, const CMessagePrecheck *pPrecheck) {
+    // the tx deserialized by the precheck
+    std::shared_ptr<CBaseTx> pBaseTx = pPrecheck != nullptr ? pPrecheck->pBaseTx : nullptr;
+    if (!pBaseTx) {
+        try {
+            vRecv >> pBaseTx;
+        } catch(EInvalidTxType e) {
+            // TODO: record the misebehaving or ban the peer node.
+            return ERRORMSG("Unknown transaction type from peer %s, ignore! %s", pFrom->addr.ToString(), e.what());
+        }
     }
 
     if (pBaseTx->IsBlockRewardTx() || pBaseTx->IsCoinRewardTx() || pBaseTx->IsPriceMedianTx()) {
@@ -539,7 +686,7 @@ inline bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
     CBlockIndex *pIndex = nullptr;
     if (locator.IsNull()) {
         // If locator is null, return the hashStop block
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hashStop);
+        BlockMap::iterator mi = mapBlockIndex.find(hashStop);
         if (mi == mapBlockIndex.end())
             return true;
 
@@ -553,7 +700,7 @@ inline bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
 
     // We must use CBlocks, as CBlockHeaders won't include the 0x00 nTx count at the end
     vector<CBlock> vHeaders;
-    int32_t nLimit = 2000;
+    int32_t nLimit = MAX_HEADERS_RESULTS;
     LogPrint(BCLog::NET, "getheaders %d to %s from peer %s\n", (pIndex ? pIndex->height : -1), hashStop.ToString(),
              pFrom->addr.ToString());
     for (; pIndex; pIndex = chainActive.Next(pIndex)) {
@@ -566,6 +713,102 @@ inline bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
     return false;
 }
 
+inline bool ProcessHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
+    vector<CBlock> vHeaders;
+    vRecv >> vHeaders;
+    if (vHeaders.size() > MAX_HEADERS_RESULTS) {
+        Misbehaving(pFrom->GetId(), 20);
+        return ERRORMSG("message headers size() = %u from peer %s", vHeaders.size(), pFrom->addrName);
+    }
+
+    LOCK2(cs_main, cs_mapNodeState);
+    CNodeState *state = State(pFrom->GetId());
+    if (!state->fHeadersRequested) {
+        Misbehaving(pFrom->GetId(), 20);
+        return ERRORMSG("recv headers not requested from peer %s", pFrom->addrName);
+    }
+
+    state->fHeadersRequested = false;
+    if (vHeaders.empty() || !state->fHeadersSync)
+        return true;
+
+    // The first header must follow a block or a header we have.
+    int32_t prevHeight   = -1;
+    uint256 prevHash     = vHeaders.front().GetPrevBlockHash();
+    auto blockIndexIt    = mapBlockIndex.find(prevHash);
+    auto syncHeaderIt    = syncHeaders.heights.find(prevHash);
+    if (blockIndexIt != mapBlockIndex.end())
+        prevHeight = blockIndexIt->second->height;
+    else if (syncHeaderIt != syncHeaders.heights.end())
+        prevHeight = syncHeaderIt->second;
+    else {
+        Misbehaving(pFrom->GetId(), 20);
+        return ERRORMSG("recv headers not connecting! prev_hash=%s, peer=%s", prevHash.GetHex(), pFrom->addrName);
+    }
+
+    // The peers of the earlier versions send the headers without the fuel, whose hashes do not link, the sync
+    // falls back to getblocks for them.
+    vector<uint256> vHashes;
+    vHashes.reserve(vHeaders.size());
+    for (const auto &header : vHeaders) {
+        if ((int32_t)header.GetHeight() != prevHeight + 1) {
+            Misbehaving(pFrom->GetId(), 20);
+            return ERRORMSG("recv headers with height %u following height %d! peer=%s", header.GetHeight(),
+                            prevHeight, pFrom->addrName);
+        }
+
+        if (header.GetPrevBlockHash() != prevHash) {
+            LogPrint(BCLog::NET, "recv headers not linked at height %d, fall back to getblocks! peer=%s\n",
+                     prevHeight + 1, pFrom->addrName);
+            state->fHeadersSync = false;
+            PushGetBlocks(pFrom, chainActive.Tip(), uint256());
+            return true;
+        }
+
+        prevHash   = header.GetHash();
+        prevHeight = header.GetHeight();
+        vHashes.push_back(prevHash);
+    }
+
+    // The hash of the last header is not confirmed by a following one yet, it's taken with the next headers.
+    // The headers on a fork below the tip are not produced by the delegates of the tip, they are left to the
+    // validation of their blocks. A header failing the check may come from a clock skew or a delegate change we do not
+    // see, the peer falls back to getblocks without a misbehavior score.
+    int32_t endHeight = -1;
+    if (blockIndexIt == mapBlockIndex.end() || chainActive.Contains(blockIndexIt->second))
+        endHeight = GetTipDelegatesEndHeight();
+
+    int32_t height = vHeaders.front().GetHeight();
+    for (size_t i = 0; i + 1 < vHashes.size(); ++i, ++height) {
+        if (height <= chainActive.Height() || mapBlockIndex.count(vHashes[i]))
+            continue;
+
+        if (!CheckSyncHeader(vHeaders[i], endHeight)) {
+            LogPrint(BCLog::NET, "recv headers not produced by the delegates at height %d, fall back to getblocks! "
+                     "peer=%s\n", height, pFrom->addrName);
+            state->fHeadersSync = false;
+            PushGetBlocks(pFrom, chainActive.Tip(), uint256());
+            return true;
+        }
+
+        syncHeaders.Add(height, vHashes[i]);
+    }
+
+    if (prevHeight > nSyncTipHeight)
+        nSyncTipHeight = prevHeight;
+
+    LogPrint(BCLog::NET, "recv headers! count=%u, end_height=%d, sync_headers=%u, peer=%s\n", vHeaders.size(),
+             prevHeight, syncHeaders.hashes.size(), pFrom->addrName);
+
+    state->fHeadersMore = (vHeaders.size() == MAX_HEADERS_RESULTS);
+    if (state->fHeadersMore && syncHeaders.hashes.size() < MAX_SYNC_HEADERS) {
+        state->fHeadersMore = false;
+        PushGetHeaders(pFrom);
+    }
+
+    return true;
+}
+
 inline void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv) {
     CBlockLocator locator;
     uint256 hashStop;
@@ -659,8 +902,18 @@ inline bool ProcessInvMessage(CNode *pFrom, CDataStream &vRecv) {
                              "tip_height=%d, tip_hash=%s, peer=%s\n",
                              orphanBlockIt->second->height, inv.hash.GetHex(), chainActive.Height(),
                              chainActive.Tip()->GetBlockHash().GetHex(), pFrom->addrName);
-                    PushGetBlocksOnCondition(pFrom, chainActive.Tip(), GetOrphanRoot(inv.hash));
+                    bool isSyncHeader;
+                    {
+                        LOCK(cs_mapNodeState);
+                        isSyncHeader = IsSyncHeader(inv.hash);
+                    }
+                    // the parents of the blocks of the sync headers are being downloaded
+                    if (!isSyncHeader)
+                        PushGetBlocksOnCondition(pFrom, chainActive.Tip(), GetOrphanRoot(inv.hash));
                     // TODO: should get the headmost block of this fork from current peer
+                } else if (mapPartialBlocks.count(inv.hash)) {
+                    // the missing txs of its compact block are being downloaded
+                    fAlreadyHave = true;
                 }
             }
         }
@@ -705,14 +958,8 @@ inline bool ProcessGetDataMessage(CNode *pFrom, CDataStream &vRecv) {
     return true;
 }
 
-inline void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
-    CBlock block;
-    vRecv >> block;
-
-    LogPrint(BCLog::NET, "recv block! time_ms=%lld, hash=%s, peer=%s\n", GetTimeMillis(),
-        block.GetHash().ToString(), pFrom->addr.ToString());
-    // block.Print();
-
+// Process a block received in full or rebuilt from a compact block
+inline void ProcessReceivedBlock(CNode *pFrom, CBlock &block) {
     CInv inv(MSG_BLOCK, block.GetHash());
     pFrom->AddInventoryKnown(inv);
 
@@ -737,6 +984,184 @@ inline void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
 
 }
 
+inline void ProcessBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlock block;
+    vRecv >> block;
+
+    LogPrint(BCLog::NET, "recv block! time_ms=%lld, hash=%s, peer=%s\n", GetTimeMillis(),
+        block.GetHash().ToString(), pFrom->addr.ToString());
+    // block.Print();
+
+    ProcessReceivedBlock(pFrom, block);
+}
+
+// Fall back to the full block when a compact block can't be rebuilt
+inline void RequestFullBlock(CNode *pFrom, const uint256 &hash) {
+    LogPrint(BCLog::NET, "request full block! hash=%s, peer=%s\n", hash.ToString(), pFrom->addr.ToString());
+    vector<CInv> vGetData;
+    vGetData.push_back(CInv(MSG_BLOCK, hash));
+    pFrom->PushMessage(NetMsgType::GETDATA, vGetData);
+}
+
+// Requires cs_main.
+// The compact blocks whose missing txs are not received in time are requested in full from the peer, the peer
+// which did not send the missing txs is asked last.
+inline void ExpirePartialBlocks(CNode *pTo) {
+    int64_t now = GetTimeMicros();
+    for (auto it = mapPartialBlocks.begin(); it != mapPartialBlocks.end();) {
+        const uint256 &hash = it->first;
+        int64_t waitTime    = now - std::get<2>(it->second);
+        bool fFromPeer      = std::get<0>(it->second) == pTo->GetId();
+        if (waitTime <= PARTIAL_BLOCK_TIMEOUT * 1000000 ||
+            (fFromPeer && waitTime <= 2 * PARTIAL_BLOCK_TIMEOUT * 1000000)) {
+            ++it;
+            continue;
+        }
+
+        if (!mapBlockIndex.count(hash) && !mapOrphanBlocks.count(hash)) {
+            LogPrint(BCLog::NET, "missing txs of compact block timeout! hash=%s, wait_ms=%lld\n", hash.ToString(),
+                     waitTime / 1000);
+            RequestFullBlock(pTo, hash);
+        }
+        it = mapPartialBlocks.erase(it);
+    }
+}
+
+inline void ProcessSendCompactMessage(CNode *pFrom, CDataStream &vRecv) {
+    bool fAnnounce   = false;
+    uint64_t version = 0;
+    vRecv >> fAnnounce >> version;
+
+    pFrom->fCompactBlock = fAnnounce && version == COMPACT_BLOCK_VERSION;
+}
+
+// Requires cs_main. Keep the partial block, and request its missing txs from the peer
+inline void RequestMissingTxs(CNode *pFrom, const uint256 &hash, const CPartialBlock &partialBlock) {
+    if (mapPartialBlocks.size() >= MAX_PARTIAL_BLOCKS) {
+        RequestFullBlock(pFrom, hash);
+        return;
+    }
+
+    mapPartialBlocks[hash] = std::make_tuple(pFrom->GetId(), partialBlock, GetTimeMicros());
+
+    CBlockTxnRequest request;
+    request.blockHash = hash;
+    request.indexes   = partialBlock.GetMissingIndexes();
+    pFrom->PushMessage(NetMsgType::GETBLOCKTXN, request);
+    LogPrint(BCLog::NET, "request missing txs of compact block! hash=%s, missing_txs=%u, peer=%s\n",
+             hash.ToString(), request.indexes.size(), pFrom->addr.ToString());
+}
+
+inline bool ProcessCompactBlockMessage(CNode *pFrom, CDataStream &vRecv) {
+    CCompactBlock cmpctBlock;
+    vRecv >> cmpctBlock;
+
+    uint256 hash = cmpctBlock.header.GetHash();
+    LogPrint(BCLog::NET, "recv cmpctblock! time_ms=%lld, hash=%s, txs=%u, prefilled_txs=%u, peer=%s\n",
+             GetTimeMillis(), hash.ToString(), cmpctBlock.GetTxCount(), cmpctBlock.prefilledTxs.size(),
+             pFrom->addr.ToString());
+    pFrom->AddInventoryKnown(CInv(MSG_BLOCK, hash));
+
+    CPartialBlock partialBlock;
+    {
+        LOCK(cs_main);
+        if (mapBlockIndex.count(hash) || mapOrphanBlocks.count(hash) || mapPartialBlocks.count(hash))
+            return true;
+
+        // the txs of the pool are expected to be valid on top of the tip only
+        if (!mapBlockIndex.count(cmpctBlock.header.GetPrevBlockHash())) {
+            RequestFullBlock(pFrom, hash);
+            return true;
+        }
+
+        CompactBlockStatus status = partialBlock.Init(cmpctBlock, mempool);
+        if (status == COMPACT_BLOCK_INVALID) {
+            Misbehaving(pFrom->GetId(), 100);
+            return ERRORMSG("invalid compact block %s from peer %s", hash.ToString(), pFrom->addr.ToString());
+        } else if (status == COMPACT_BLOCK_FAILED) {
+            RequestFullBlock(pFrom, hash);
+            return true;
+        }
+
+        if (!partialBlock.IsComplete()) {
+            RequestMissingTxs(pFrom, hash, partialBlock);
+            return true;
+        }
+    }
+
+    CBlock block;
+    if (partialBlock.GetBlock(block) != COMPACT_BLOCK_OK) {
+        RequestFullBlock(pFrom, hash);
+        return true;
+    }
+
+    ProcessReceivedBlock(pFrom, block);
+    return true;
+}
+
+inline bool ProcessGetBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxnRequest request;
+    vRecv >> request;
+
+    CBlock block;
+    {
+        LOCK(cs_main);
+        auto it = mapBlockIndex.find(request.blockHash);
+        if (it == mapBlockIndex.end() || !ReadBlockFromDisk(it->second, block)) {
+            LogPrint(BCLog::NET, "block %s of getblocktxn not found, peer=%s\n", request.blockHash.ToString(),
+                     pFrom->addr.ToString());
+            return true;
+        }
+    }
+
+    CBlockTxn response;
+    response.blockHash = request.blockHash;
+    response.txs.reserve(request.indexes.size());
+    for (uint32_t index : request.indexes) {
+        if (index >= block.vptx.size()) {
+            Misbehaving(pFrom->GetId(), 100);
+            return ERRORMSG("getblocktxn with out of range tx index from peer %s", pFrom->addr.ToString());
+        }
+        response.txs.push_back(block.vptx[index]);
+    }
+
+    pFrom->PushMessage(NetMsgType::BLOCKTXN, response);
+    return true;
+}
+
+inline bool ProcessBlockTxnMessage(CNode *pFrom, CDataStream &vRecv) {
+    CBlockTxn blockTxn;
+    vRecv >> blockTxn;
+
+    CPartialBlock partialBlock;
+    {
+        LOCK(cs_main);
+        auto it = mapPartialBlocks.find(blockTxn.blockHash);
+        if (it == mapPartialBlocks.end() || std::get<0>(it->second) != pFrom->GetId())
+            return true;
+
+        partialBlock = std::get<1>(it->second);
+        mapPartialBlocks.erase(it);
+    }
+
+    if (partialBlock.FillMissingTxs(blockTxn.txs) != COMPACT_BLOCK_OK) {
+        Misbehaving(pFrom->GetId(), 100);
+        return ERRORMSG("invalid blocktxn of block %s from peer %s", blockTxn.blockHash.ToString(),
+                        pFrom->addr.ToString());
+    }
+
+    CBlock block;
+    if (partialBlock.GetBlock(block) != COMPACT_BLOCK_OK) {
+        RequestFullBlock(pFrom, blockTxn.blockHash);
+        return true;
+    }
+
+    LogPrint(BCLog::NET, "rebuilt compact block with the missing txs! time_ms=%lld, hash=%s, missing_txs=%u, peer=%s\n",
+             GetTimeMillis(), blockTxn.blockHash.ToString(), blockTxn.txs.size(), pFrom->addr.ToString());
+    ProcessReceivedBlock(pFrom, block);
+    return true;
+}
+
 inline void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv) {
     LOCK2(cs_main, pFrom->cs_filter);
 
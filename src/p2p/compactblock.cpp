@@ -0,0 +1,127 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "compactblock.h"
+
+#include "commons/random.h"
+#include "crypto/hash.h"
+#include "crypto/siphash.h"
+#include "tx/txmempool.h"
+#include "tx/txserializer.h"
+
+#include <limits>
+#include <unordered_map>
+
+// a loose bound of the txs in a block, to limit the memory allocated for a malformed compact block
+static const uint32_t MAX_COMPACT_BLOCK_TXS = MAX_BLOCK_SIZE / 10;
+
+CCompactBlock::CCompactBlock(const CBlock &block)
+    : header(block.GetBlockHeader()), nonce(GetRand(std::numeric_limits<uint64_t>::max())) {
+    FillShortTxIdKey();
+
+    for (uint32_t i = 0; i < block.vptx.size(); i++) {
+        const std::shared_ptr<CBaseTx> &pTx = block.vptx[i];
+        if (pTx->IsBlockRewardTx() || pTx->IsCoinRewardTx() || pTx->IsPriceMedianTx())
+            prefilledTxs.emplace_back(i, pTx);
+        else
+            shortTxIds.push_back(GetShortTxId(pTx->GetHash()));
+    }
+}
+
+void CCompactBlock::FillShortTxIdKey() {
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << header << nonce;
+    uint256 hash = hasher.GetHash();
+    shortTxIdK0  = hash.GetUint64(0);
+    shortTxIdK1  = hash.GetUint64(1);
+}
+
+uint64_t CCompactBlock::GetShortTxId(const uint256 &txid) const {
+    return SipHashUint256(shortTxIdK0, shortTxIdK1, txid);
+}
+
+CompactBlockStatus CPartialBlock::Init(const CCompactBlock &cmpctBlock, CTxMemPool &pool) {
+    uint32_t txCount = cmpctBlock.GetTxCount();
+    if (txCount == 0 || txCount > MAX_COMPACT_BLOCK_TXS)
+        return COMPACT_BLOCK_INVALID;
+
+    header = cmpctBlock.header;
+    vptx.assign(txCount, nullptr);
+    missingIndexes.clear();
+
+    for (const auto &prefilledTx : cmpctBlock.prefilledTxs) {
+        if (prefilledTx.index >= txCount || vptx[prefilledTx.index] != nullptr || prefilledTx.pTx == nullptr)
+            return COMPACT_BLOCK_INVALID;
+
+        vptx[prefilledTx.index] = prefilledTx.pTx;
+    }
+
+    // the slots of the short txids are the ones left by the prefilled txs
+    std::unordered_map<uint64_t, uint32_t> shortTxIdIndexes;
+    shortTxIdIndexes.reserve(cmpctBlock.shortTxIds.size());
+    uint32_t index = 0;
+    for (uint64_t shortTxId : cmpctBlock.shortTxIds) {
+        while (vptx[index] != nullptr)
+            index++;
+
+        // the sender builds the block from distinct txids, a collision of their short txids is rebuilt from the
+        // full block
+        if (!shortTxIdIndexes.emplace(shortTxId, index++).second)
+            return COMPACT_BLOCK_FAILED;
+    }
+
+    // a short txid matching two txs of the pool is requested from the peer
+    std::vector<bool> collisions(txCount, false);
+    {
+        LOCK(pool.cs);
+        for (const auto &item : pool.memPoolTxs) {
+            auto it = shortTxIdIndexes.find(cmpctBlock.GetShortTxId(item.first));
+            if (it == shortTxIdIndexes.end() || collisions[it->second])
+                continue;
+
+            std::shared_ptr<CBaseTx> &pTx = vptx[it->second];
+            if (pTx == nullptr) {
+                pTx = item.second.GetTransaction();
+            } else {
+                pTx = nullptr;
+                collisions[it->second] = true;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < txCount; i++) {
+        if (vptx[i] == nullptr)
+            missingIndexes.push_back(i);
+    }
+
+    return COMPACT_BLOCK_OK;
+}
+
+CompactBlockStatus CPartialBlock::FillMissingTxs(const std::vector<std::shared_ptr<CBaseTx>> &txs) {
+    if (txs.size() != missingIndexes.size())
+        return COMPACT_BLOCK_INVALID;
+
+    for (uint32_t i = 0; i < txs.size(); i++) {
+        if (txs[i] == nullptr)
+            return COMPACT_BLOCK_INVALID;
+
+        vptx[missingIndexes[i]] = txs[i];
+    }
+    missingIndexes.clear();
+
+    return COMPACT_BLOCK_OK;
+}
+
+CompactBlockStatus CPartialBlock::GetBlock(CBlock &block) const {
+    assert(IsComplete());
+
+    block = CBlock(header);
+    block.vptx = vptx;
+
+    // a wrong tx of the pool matching a short txid or a wrong tx sent by the peer
+    if (block.BuildMerkleTree() != header.GetMerkleRootHash())
+        return COMPACT_BLOCK_FAILED;
+
+    return COMPACT_BLOCK_OK;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_COMPACTBLOCK_H
+#define P2P_COMPACTBLOCK_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "persistence/block.h"
+
+#include <memory>
+#include <vector>
+
+class CBaseTx;
+class CTxMemPool;
+
+/** Version of the compact block messages announced by sendcmpct */
+static const uint64_t COMPACT_BLOCK_VERSION = 1;
+
+/** A tx sent in full in the compact block, it can not be in the mempool of the peer, e.g. the reward txs */
+struct CPrefilledTx {
+    uint32_t index;  // the index of the tx in the block
+    std::shared_ptr<CBaseTx> pTx;
+
+    CPrefilledTx() : index(0) {}
+    CPrefilledTx(uint32_t indexIn, const std::shared_ptr<CBaseTx> &pTxIn) : index(indexIn), pTx(pTxIn) {}
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(index));
+        READWRITE(pTx);
+    )
+};
+
+/**
+ * The block header with the short txids of the txs expected in the mempool of the peer and the other txs in full.
+ * The short txid is the SipHash-2-4 of the txid keyed by the hash of the header and a random nonce, so that the
+ * collisions can not be forged before the block is produced.
+ */
+class CCompactBlock {
+public:
+    CBlockHeader header;
+    uint64_t nonce;
+    std::vector<uint64_t> shortTxIds;  // of the txs not prefilled, in the block order
+    std::vector<CPrefilledTx> prefilledTxs;
+
+public:
+    CCompactBlock() : nonce(0) {}
+    explicit CCompactBlock(const CBlock &block);
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(header);
+        READWRITE(nonce);
+        READWRITE(shortTxIds);
+        READWRITE(prefilledTxs);
+        if (fRead)
+            const_cast<CCompactBlock *>(this)->FillShortTxIdKey();
+    )
+
+    uint64_t GetShortTxId(const uint256 &txid) const;
+    uint32_t GetTxCount() const { return shortTxIds.size() + prefilledTxs.size(); }
+
+private:
+    void FillShortTxIdKey();
+
+    // memory only
+    uint64_t shortTxIdK0 = 0;
+    uint64_t shortTxIdK1 = 0;
+};
+
+/** Request of the txs missing to rebuild a compact block */
+class CBlockTxnRequest {
+public:
+    uint256 blockHash;
+    std::vector<uint32_t> indexes;  // of the txs in the block
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(indexes);
+    )
+};
+
+/** The txs requested by a CBlockTxnRequest */
+class CBlockTxn {
+public:
+    uint256 blockHash;
+    std::vector<std::shared_ptr<CBaseTx>> txs;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(blockHash);
+        READWRITE(txs);
+    )
+};
+
+enum CompactBlockStatus {
+    COMPACT_BLOCK_OK,
+    COMPACT_BLOCK_INVALID,  // the peer sent a malformed message
+    COMPACT_BLOCK_FAILED,   // it can't be rebuilt, e.g. a short txid collision, the full block is needed
+};
+
+/** A block being rebuilt from a compact block, the prefilled txs and the mempool */
+class CPartialBlock {
+public:
+    CBlockHeader header;
+
+    // Fill the txs found in the prefilled txs and the pool
+    CompactBlockStatus Init(const CCompactBlock &cmpctBlock, CTxMemPool &pool);
+    // Fill the missing txs with the txs received by a blocktxn message
+    CompactBlockStatus FillMissingTxs(const std::vector<std::shared_ptr<CBaseTx>> &txs);
+    // Build the block of the complete txs, fails if the txs don't match the merkle root of the header
+    CompactBlockStatus GetBlock(CBlock &block) const;
+
+    bool IsComplete() const { return missingIndexes.empty(); }
+    const std::vector<uint32_t> &GetMissingIndexes() const { return missingIndexes; }
+
+private:
+    std::vector<std::shared_ptr<CBaseTx>> vptx;
+    std::vector<uint32_t> missingIndexes;
+};
+
+#endif  // P2P_COMPACTBLOCK_H
@@ -0,0 +1,140 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "msgprecheck.h"
+
+#include "main.h"
+#include "net.h"
+#include "p2p/protocol.h"
+#include "persistence/cachewrapper.h"
+#include "tx/txserializer.h"
+
+CMessagePrecheckQueue messagePrecheckQueue;
+CMessageStats messageStats;
+
+const std::string CMessageStats::UNKNOWN_COMMAND = "unknown";
+
+bool CMessageStats::IsKnownCommand(const std::string &strCommand) {
+    const std::vector<std::string> &types = getAllNetMessageTypes();
+    return std::find(types.begin(), types.end(), strCommand) != types.end();
+}
+
+bool IsPrecheckCommand(const std::string &strCommand) {
+    return strCommand == NetMsgType::TX || strCommand == NetMsgType::CONFIRMBLOCK ||
+           strCommand == NetMsgType::FINALITYBLOCK;
+}
+
+// Read the account of the regid from the db without the pending changes of the block caches, which belong to the
+// message handler thread. A stale account only costs a signature cache miss on the handler thread.
+static bool PeekAccount(const CRegID &regid, CAccount &account) {
+    CDBAccess *pAccountDb = pCdMan->pAccountDb;
+    CKeyID keyId;
+    return pAccountDb->PeekData(dbk::REGID_KEYID, CRegIDKey(regid), keyId) &&
+           pAccountDb->PeekData(dbk::KEYID_ACCOUNT, keyId, account);
+}
+
+static void PrecheckTx(CMessagePrecheck &precheck) {
+    std::shared_ptr<CBaseTx> pBaseTx;
+    try {
+        precheck.vRecv >> pBaseTx;
+    } catch (std::exception &e) {
+        return;  // the handler thread reports the bad message
+    }
+    precheck.pBaseTx = pBaseTx;
+
+    CPubKey pubKey;
+    CAccount account;
+    if (pBaseTx->txUid.is<CPubKey>())
+        pubKey = pBaseTx->txUid.get<CPubKey>();
+    else if (pBaseTx->txUid.is<CRegID>() && PeekAccount(pBaseTx->txUid.get<CRegID>(), account))
+        pubKey = account.owner_pubkey;
+    else
+        return;
+
+    VerifySignature(pBaseTx->GetHash(), pBaseTx->signature, pubKey);
+}
+
+static void PrecheckPBFTMessage(CMessagePrecheck &precheck) {
+    CPBFTMessage msg;
+    try {
+        CDataStream vRecv(precheck.vRecv);
+        vRecv >> msg;
+    } catch (std::exception &e) {
+        return;
+    }
+
+    CAccount account;
+    if (!PeekAccount(msg.miner, account))
+        return;
+
+    uint256 messageHash = msg.GetHash();
+    if (!VerifySignature(messageHash, msg.vSignature, account.owner_pubkey))
+        VerifySignature(messageHash, msg.vSignature, account.miner_pubkey);
+}
+
+void CMessagePrecheckQueue::Start(int32_t nThreads) {
+    Stop();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    fQuit = false;
+    for (int32_t i = 0; i < nThreads; i++) {
+        threads.emplace_back([this]() {
+            RenameThread("coin-msgcheck");
+            Loop();
+        });
+    }
+}
+
+void CMessagePrecheckQueue::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fQuit = true;
+    }
+    condWorker.notify_all();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+
+    // the messages left are processed by the handler thread without the precheck
+    std::unique_lock<std::mutex> lock(mtx);
+    for (auto &pPrecheck : queue) {
+        pPrecheck->fDone = true;
+    }
+    queue.clear();
+}
+
+void CMessagePrecheckQueue::Push(const std::shared_ptr<CMessagePrecheck> &pPrecheck) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        queue.push_back(pPrecheck);
+    }
+    condWorker.notify_one();
+}
+
+void CMessagePrecheckQueue::Loop() {
+    while (true) {
+        std::shared_ptr<CMessagePrecheck> pPrecheck;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            condWorker.wait(lock, [this]() { return fQuit || !queue.empty(); });
+            if (fQuit)
+                return;
+
+            pPrecheck = queue.front();
+            queue.pop_front();
+        }
+
+        int64_t nStartTime = GetTimeMicros();
+        if (pPrecheck->strCommand == NetMsgType::TX)
+            PrecheckTx(*pPrecheck);
+        else
+            PrecheckPBFTMessage(*pPrecheck);
+        pPrecheck->nDuration = GetTimeMicros() - nStartTime;
+
+        pPrecheck->fDone = true;
+        WakeMessageHandler();
+    }
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_MSGPRECHECK_H
+#define P2P_MSGPRECHECK_H
+
+#include "commons/serialize.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CBaseTx;
+
+/** Default for -msgthreads, the number of threads prechecking the received messages, 0 disables the precheck */
+static const int32_t DEFAULT_MSG_PRECHECK_THREADS = 2;
+/** Max. number of threads prechecking the received messages */
+static const int32_t MAX_MSG_PRECHECK_THREADS = 16;
+
+/**
+ * The stateless work of a received message done ahead on the precheck workers: the tx is deserialized, and the
+ * signatures of the tx and the pbft messages are verified into the signature cache. The message handler thread
+ * still does all the work depending on or changing the chain state, in the order the peer sent the messages.
+ */
+struct CMessagePrecheck {
+    std::string strCommand;
+    CDataStream vRecv;                  // a copy of the message data
+    std::shared_ptr<CBaseTx> pBaseTx;   // the deserialized tx, null if it's not a valid tx
+    int64_t nDuration = 0;              // time used by the precheck in microseconds
+    std::atomic<bool> fDone{false};
+
+    CMessagePrecheck(const std::string &strCommandIn, const CDataStream &vRecvIn)
+        : strCommand(strCommandIn), vRecv(vRecvIn) {}
+};
+
+/** Whether the stateless work of the message command is worth being done ahead */
+bool IsPrecheckCommand(const std::string &strCommand);
+
+/**
+ * Queue of the messages to precheck on a pool of worker threads. The message handler thread wakes up when a
+ * precheck is done.
+ */
+class CMessagePrecheckQueue {
+private:
+    std::vector<std::thread> threads;
+
+    std::mutex mtx;
+    std::condition_variable condWorker;
+    std::deque<std::shared_ptr<CMessagePrecheck>> queue;
+    bool fQuit = false;
+
+public:
+    CMessagePrecheckQueue() {}
+    ~CMessagePrecheckQueue() { Stop(); }
+
+    void Start(int32_t nThreads);
+    void Stop();
+    bool IsEnabled() const { return !threads.empty(); }
+
+    void Push(const std::shared_ptr<CMessagePrecheck> &pPrecheck);
+
+private:
+    void Loop();
+};
+
+/** The processing time of the received messages by command, in microseconds */
+class CMessageStats {
+public:
+    struct CommandStats {
+        uint64_t count            = 0;
+        int64_t totalWaitTime     = 0;  // from the message completely received to the start of its processing
+        int64_t totalPrecheckTime = 0;
+        int64_t totalTime         = 0;  // the processing on the message handler thread
+        int64_t maxTime           = 0;
+    };
+
+    // the commands are chosen by the peers, the ones not of NetMsgType are counted under UNKNOWN_COMMAND
+    void Add(const std::string &strCommand, int64_t nWaitTime, int64_t nPrecheckTime, int64_t nTime) {
+        const std::string &command = IsKnownCommand(strCommand) ? strCommand : UNKNOWN_COMMAND;
+        std::unique_lock<std::mutex> lock(mtx);
+        CommandStats &stats = mapStats[command];
+        stats.count++;
+        stats.totalWaitTime += nWaitTime;
+        stats.totalPrecheckTime += nPrecheckTime;
+        stats.totalTime += nTime;
+        stats.maxTime = std::max(stats.maxTime, nTime);
+    }
+
+    std::map<std::string, CommandStats> GetStats() const {
+        std::unique_lock<std::mutex> lock(mtx);
+        return mapStats;
+    }
+
+    static const std::string UNKNOWN_COMMAND;
+
+private:
+    static bool IsKnownCommand(const std::string &strCommand);
+
+    mutable std::mutex mtx;
+    std::map<std::string, CommandStats> mapStats;
+};
+
+extern CMessagePrecheckQueue messagePrecheckQueue;
+extern CMessageStats messageStats;
+
+#endif  // P2P_MSGPRECHECK_H
@@ -5,6 +5,12 @@
 
 #include "netmessage.h"
 
+#include "p2p/msgprecheck.h"
+
+bool CNetMessage::IsPrecheckPending() const {
+    return pPrecheck != nullptr && !pPrecheck->fDone;
+}
+
 int32_t CNetMessage::readHeader(const char* pch, uint32_t nBytes) {
     // copy data to temporary parsing buffer
     uint32_t nRemaining = 24 - nHdrPos;
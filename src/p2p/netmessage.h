@@ -9,6 +9,10 @@
 #include "commons/serialize.h"
 #include "p2p/protocol.h"
 
+#include <memory>
+
+struct CMessagePrecheck;
+
 class CNetMessage {
 public:
     bool in_data;  // parsing header (false) or data (true)
@@ -20,11 +24,15 @@ public:
     CDataStream vRecv;  // received message data
     uint32_t nDataPos;
 
+    int64_t nTime;  // time in microseconds when the message is complete
+    std::shared_ptr<CMessagePrecheck> pPrecheck;  // the stateless work done ahead on the precheck workers
+
     CNetMessage(int32_t nTypeIn, int32_t nVersionIn) : hdrbuf(nTypeIn, nVersionIn), vRecv(nTypeIn, nVersionIn) {
         hdrbuf.resize(24);
         in_data  = false;
         nHdrPos  = 0;
         nDataPos = 0;
+        nTime    = 0;
     }
 
     bool complete() const {
@@ -38,6 +46,9 @@ public:
         vRecv.SetVersion(nVersionIn);
     }
 
+    // the message is waiting for its precheck to finish before it's processed
+    bool IsPrecheckPending() const;
+
     int32_t readHeader(const char* pch, uint32_t nBytes);
     int32_t readData(const char* pch, uint32_t nBytes);
 };
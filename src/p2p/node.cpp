@@ -241,6 +241,9 @@ bool CNode::ReceiveMsgBytes(const char* pch, uint32_t nBytes) {
         if (handled < 0)
             return false;
 
+        if (msg.complete())
+            msg.nTime = GetTimeMicros();
+
         pch += handled;
         nBytes -= handled;
     }
@@ -115,6 +115,10 @@ struct CNodeState {
     int32_t nBlocksToDownload;        // blocks number to be downloaded
     int64_t nLastBlockReceive;        // the latest receiving blocks time
     int64_t nLastBlockProcess;        // the latest processing blocks time
+    bool fHeadersSync;                // sync by the headers of the peer, false if it falls back to getblocks
+    bool fHeadersMore;                // the peer has more headers, to be asked for when the sync headers drain
+    bool fHeadersRequested;           // a getheaders is sent to the peer and the headers are not received yet
+    int64_t nStallingSince;           // the latest time it held back the download window
 
     CNodeState() {
         nMisbehavior      = 0;
@@ -123,6 +127,10 @@ struct CNodeState {
         nBlocksInFlight   = 0;
         nLastBlockReceive = 0;
         nLastBlockProcess = 0;
+        fHeadersSync      = true;
+        fHeadersMore      = false;
+        fHeadersRequested = false;
+        nStallingSince    = 0;
     }
 };
 
@@ -172,6 +180,7 @@ public:
     // b) the peer may tell us in their version message that we should not relay tx invs
     //    until they have initialized their bloom filter.
     bool fRelayTxes;
+    bool fCompactBlock;  // set by sendcmpct message, the peer rebuilds blocks from cmpctblock messages
     CSemaphoreGrant grantOutbound;
     CCriticalSection cs_filter;
     CBloomFilter* pFilter;
@@ -252,6 +261,7 @@ public:
         fStartSync               = false;
         fGetAddr                 = false;
         fRelayTxes               = false;
+        fCompactBlock            = false;
         setInventoryKnown.max_size(SendBufferSize() / 1000);
         setBlockConfirmMsgKnown.max_size(200);
         pFilter        = new CBloomFilter();
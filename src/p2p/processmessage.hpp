@@ -8,7 +8,7 @@
 
 #include "main.h"
 
-bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv) {
+bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv, const CMessagePrecheck *pPrecheck) {
     LogPrint(BCLog::NET, "received: %s (%u bytes) from peer %s\n", strCommand, vRecv.size(), pFrom->addr.ToString());
     // RandAddSeedPerfmon();
     // if (GetRand(atoi(SysCfg().GetArg("-dropmessagestest", "0"))) == 0) {
@@ -35,6 +35,8 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
 
     else if (strCommand == NetMsgType::VERACK) {
         pFrom->SetRecvVersion(min(pFrom->nVersion, PROTOCOL_VERSION));
+        // ask for the new blocks as compact blocks, the old peers ignore it
+        pFrom->PushMessage(NetMsgType::SENDCMPCT, true, COMPACT_BLOCK_VERSION);
     }
 
     else if (strCommand == NetMsgType::ADDR) {
@@ -61,8 +63,14 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
             return true;
     }
 
+    else if (strCommand == NetMsgType::HEADERS &&
+            !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessHeadersMessage(pFrom, vRecv))
+            return false;
+    }
+
     else if (strCommand == NetMsgType::TX) {
-        if (!ProcessTxMessage(pFrom, strCommand, vRecv))
+        if (!ProcessTxMessage(pFrom, strCommand, vRecv, pPrecheck))
             return false;
     }
 
@@ -72,6 +80,27 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
         ProcessBlockMessage(pFrom, vRecv);
     }
 
+    else if (strCommand == NetMsgType::SENDCMPCT) {
+        ProcessSendCompactMessage(pFrom, vRecv);
+    }
+
+    else if (strCommand == NetMsgType::CMPCTBLOCK &&
+            !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessCompactBlockMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == NetMsgType::GETBLOCKTXN) {
+        if (!ProcessGetBlockTxnMessage(pFrom, vRecv))
+            return false;
+    }
+
+    else if (strCommand == NetMsgType::BLOCKTXN &&
+            !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
+        if (!ProcessBlockTxnMessage(pFrom, vRecv))
+            return false;
+    }
+
     else if (strCommand == NetMsgType::GETADDR) {
         pFrom->vAddrToSend.clear();
         vector<CAddress> vAddr = addrman.GetAddr();
@@ -172,6 +201,20 @@ bool ProcessMessages(CNode *pFrom) {
     if (!pFrom->vRecvGetData.empty())
         return fOk;
 
+    // hand the stateless work of the complete messages to the precheck threads, the messages are still processed
+    // in order below, each waits for its precheck
+    if (messagePrecheckQueue.IsEnabled()) {
+        for (auto &msg : pFrom->vRecvMsg) {
+            if (!msg.complete())
+                break;
+
+            if (msg.pPrecheck == nullptr && msg.hdr.IsValid() && IsPrecheckCommand(msg.hdr.GetCommand())) {
+                msg.pPrecheck = std::make_shared<CMessagePrecheck>(msg.hdr.GetCommand(), msg.vRecv);
+                messagePrecheckQueue.Push(msg.pPrecheck);
+            }
+        }
+    }
+
     deque<CNetMessage>::iterator it = pFrom->vRecvMsg.begin();
     while (!pFrom->fDisconnect && it != pFrom->vRecvMsg.end()) {
         // Don't bother if send buffer is too full to respond anyway
@@ -192,6 +235,10 @@ bool ProcessMessages(CNode *pFrom) {
         if (!msg.complete())
             break;
 
+        // wait for the precheck, the handler thread is woken up when it's done
+        if (msg.IsPrecheckPending())
+            break;
+
         // at this point, any failure means we can delete the current message
         it++;
 
@@ -226,8 +273,9 @@ bool ProcessMessages(CNode *pFrom) {
 
         // Process message
         bool fRet = false;
+        int64_t nStartTime = GetTimeMicros();
         try {
-            fRet = ProcessMessage(pFrom, strCommand, vRecv);
+            fRet = ProcessMessage(pFrom, strCommand, vRecv, msg.pPrecheck.get());
             boost::this_thread::interruption_point();
         } catch (std::ios_base::failure &e) {
             pFrom->PushMessage(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, string("error parsing message"));
@@ -249,6 +297,9 @@ bool ProcessMessages(CNode *pFrom) {
             PrintExceptionContinue(nullptr, "ProcessMessages()");
         }
 
+        messageStats.Add(strCommand, nStartTime - msg.nTime, msg.pPrecheck ? msg.pPrecheck->nDuration : 0,
+                         GetTimeMicros() - nStartTime);
+
         if (!fRet)
             LogPrint(BCLog::INFO, "ProcessMessage(%s, %u bytes) FAILED\n", strCommand, nMessageSize);
 
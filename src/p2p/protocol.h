@@ -17,6 +17,7 @@
 
 #include <stdint.h>
 #include <string>
+#include <vector>
 
 /** Message header.
  * (4) message start.
@@ -131,7 +132,7 @@ extern const char *TX;
  * @since protocol version 31800.
  * @see https://bitcoin.org/en/developer-reference#headers
  */
-// extern const char *HEADERS;
+extern const char *HEADERS;
 /**
  * The block message transmits a single serialized block.
  * @see https://bitcoin.org/en/developer-reference#block
@@ -227,19 +228,19 @@ extern const char *FEEFILTER;
  */
 extern const char *SENDCMPCT;
 /**
- * Contains a CBlockHeaderAndShortTxIDs object - providing a header and
- * list of "short txids".
+ * Contains a CCompactBlock object - providing a header, a list of "short txids"
+ * and the prefilled txs.
  * @since protocol version 70014 as described by BIP 152
  */
 extern const char *CMPCTBLOCK;
 /**
- * Contains a BlockTransactionsRequest
+ * Contains a CBlockTxnRequest
  * Peer should respond with "blocktxn" message.
  * @since protocol version 70014 as described by BIP 152
  */
 extern const char *GETBLOCKTXN;
 /**
- * Contains a BlockTransactions.
+ * Contains a CBlockTxn.
  * Sent in response to a "getblocktxn" message.
  * @since protocol version 70014 as described by BIP 152
  */
@@ -255,6 +256,9 @@ extern const char *CONFIRMBLOCK ;
 extern const char *FINALITYBLOCK ;
 };
 
+/* Get a vector of all valid message types (see above) */
+const std::vector<std::string> &getAllNetMessageTypes();
+
 enum PBFTMsgType {
 
     CONFIRM_BLOCK =1 ,
@@ -383,6 +387,8 @@ enum
     // Nodes may always request a MSG_FILTERED_BLOCK in a getdata, however,
     // MSG_FILTERED_BLOCK should not appear in any invs except as a part of getdata.
     MSG_FILTERED_BLOCK,
+    // Requests a block as a cmpctblock message in a getdata, it should not appear in any invs.
+    MSG_CMPCT_BLOCK,
 };
 
 #endif // __INCLUDED_PROTOCOL_H__
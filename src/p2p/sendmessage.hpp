@@ -32,6 +32,8 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
         if (pTo->nVersion == 0)
             return true;
 
+        vector<CInv> vGetData;
+
         //
         // Message: ping
         //
@@ -120,10 +122,47 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
             if (pTo->fStartSync && !SysCfg().IsImporting() && !SysCfg().IsReindex()) {
                 pTo->fStartSync = false;
                 nSyncTipHeight  = pTo->nStartingHeight;
-                LogPrint(BCLog::NET, "start block sync lead to getblocks\n");
-                PushGetBlocks(pTo, chainActive.Tip(), uint256());
+
+                LOCK(cs_mapNodeState);
+                if (State(pTo->GetId())->fHeadersSync) {
+                    LogPrint(BCLog::NET, "start block sync lead to getheaders\n");
+                    PushGetHeaders(pTo);
+                } else {
+                    LogPrint(BCLog::NET, "start block sync lead to getblocks\n");
+                    PushGetBlocks(pTo, chainActive.Tip(), uint256());
+                }
             }
 
+            //
+            // Message: getdata (blocks of the download window)
+            //
+            if (!pTo->fDisconnect && !pTo->fClient && pTo->fSuccessfullyConnected && !SysCfg().IsImporting() &&
+                !SysCfg().IsReindex()) {
+                LOCK(cs_mapNodeState);
+                CNodeState *state = State(pTo->GetId());
+                vector<uint256> vBlocks;
+                FindBlocksToDownload(pTo, *state, vBlocks);
+                for (const auto &hash : vBlocks) {
+                    vGetData.push_back(CInv(MSG_BLOCK, hash));
+                    MarkBlockAsInFlight(hash, pTo->GetId());
+                }
+                if (!vBlocks.empty())
+                    LogPrint(BCLog::NET, "send MSG_BLOCK msg of download window! time_ms=%lld, count=%u, peer=%s, "
+                             "FlightBlocks=%d\n", GetTimeMillis(), vBlocks.size(), state->name, state->nBlocksInFlight);
+
+                // ask for more headers when the sync headers drain
+                if (state->fHeadersMore && syncHeaders.hashes.size() < MAX_SYNC_HEADERS / 2) {
+                    state->fHeadersMore = false;
+                    PushGetHeaders(pTo);
+                }
+            }
+
+            //
+            // Message: getdata (compact blocks missing their txs)
+            //
+            if (!pTo->fDisconnect && !pTo->fClient && pTo->fSuccessfullyConnected)
+                ExpirePartialBlocks(pTo);
+
             // Resend wallet transactions that haven't gotten in a block yet
             // Except during reindex, importing and IBD, when old wallet
             // transactions become unconfirmed and spams other nodes.
@@ -216,11 +255,12 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
         //
         // Message: getdata (blocks)
         //
-        vector<CInv> vGetData;
+        // the new blocks announced by the peers are rebuilt from their compact blocks and the mempool
+        bool fCompactBlock = pTo->fCompactBlock && !IsInitialBlockDownload();
         int32_t index = 0;
         while (!pTo->fDisconnect && state.nBlocksToDownload && state.nBlocksInFlight < MAX_BLOCKS_IN_TRANSIT_PER_PEER) {
             uint256 hash = state.vBlocksToDownload.front();
-            vGetData.push_back(CInv(MSG_BLOCK, hash));
+            vGetData.push_back(CInv(fCompactBlock ? MSG_CMPCT_BLOCK : MSG_BLOCK, hash));
             MarkBlockAsInFlight(hash, pTo->GetId());
             LogPrint(BCLog::NET, "send MSG_BLOCK msg! time_ms=%lld, hash=%s, peer=%s, FlightBlocks=%d, index=%d\n",
                 GetTimeMillis(), hash.ToString(), state.name, state.nBlocksInFlight, index++);
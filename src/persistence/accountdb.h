@@ -93,6 +93,18 @@ public:
         nickId2KeyIdCache.SetBase(&pBaseIn->nickId2KeyIdCache);
     };
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        accountCache.SetDbAccess(pDbAccessIn);
+        regId2KeyIdCache.SetDbAccess(pDbAccessIn);
+        nickId2KeyIdCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CAccountDBCache *pBaseIn) {
+        accountCache.SetFrozenBase(&pBaseIn->accountCache);
+        regId2KeyIdCache.SetFrozenBase(&pBaseIn->regId2KeyIdCache);
+        nickId2KeyIdCache.SetFrozenBase(&pBaseIn->nickId2KeyIdCache);
+    }
+
     uint64_t GetAccountFreeAmount(const CKeyID &keyId, const TokenSymbol &tokenSymbol);
 
     bool Flush();
@@ -103,6 +115,18 @@ public:
         nickId2KeyIdCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        accountCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        regId2KeyIdCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        nickId2KeyIdCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        accountCache.DiscardData(dbKeys);
+        regId2KeyIdCache.DiscardData(dbKeys);
+        nickId2KeyIdCache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         regId2KeyIdCache.RegisterUndoFunc(undoDataFuncMap);
         nickId2KeyIdCache.RegisterUndoFunc(undoDataFuncMap);
@@ -116,7 +140,7 @@ public:
     // <prefix$NickID -> KeyID>
     CCompositeKVCache< dbk::NICKID_KEYID,         CVarIntValue<uint64_t>,      std::pair<CVarIntValue<uint32_t>,CKeyID>>   nickId2KeyIdCache;
     // <prefix$KeyID -> Account>
-    CCompositeKVCache< dbk::KEYID_ACCOUNT,        CKeyID,       CAccount>        accountCache;
+    CHashKVCache<      dbk::KEYID_ACCOUNT,        CKeyID,       CAccount>        accountCache;
 
 };
 
@@ -70,11 +70,31 @@ public:
         assetTradingPairCache.SetBase(&pBaseIn->assetTradingPairCache);
     }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        assetCache.SetDbAccess(pDbAccessIn);
+        assetTradingPairCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CAssetDBCache *pBaseIn) {
+        assetCache.SetFrozenBase(&pBaseIn->assetCache);
+        assetTradingPairCache.SetFrozenBase(&pBaseIn->assetTradingPairCache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         assetCache.SetDbOpLogMap(pDbOpLogMapIn);
         assetTradingPairCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        assetCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        assetTradingPairCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        assetCache.DiscardData(dbKeys);
+        assetTradingPairCache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         assetCache.RegisterUndoFunc(undoDataFuncMap);
         assetTradingPairCache.RegisterUndoFunc(undoDataFuncMap);
@@ -10,6 +10,9 @@
 #include "main.h"
 #include "net.h"
 
+#include <deque>
+#include <unordered_map>
+
 uint256 CBlockHeader::GetHash() const {
     return ComputeSignatureHash();
 }
@@ -68,6 +71,16 @@ uint256 CBlock::CheckMerkleBranch(uint256 hash, const vector<uint256>& vMerkleBr
     return hash;
 }
 
+void CBlock::GetTxOffsets(vector<uint32_t> &offsets) const {
+    offsets.clear();
+    offsets.reserve(vptx.size());
+    uint32_t offset = GetSizeOfCompactSize(vptx.size());
+    for (const auto &pTx : vptx) {
+        offsets.push_back(offset);
+        offset += ::GetSerializeSize(pTx, SER_DISK, CLIENT_VERSION);
+    }
+}
+
 map<TokenSymbol, uint64_t> CBlock::GetFees() const {
     map<TokenSymbol, uint64_t> fees = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
     for (uint32_t i = 1; i < vptx.size(); ++i) {
@@ -129,6 +142,112 @@ std::tuple<bool, int> CBlock::GetTxIndex(const uint256& txid) const {
     return std::make_tuple(false, 0);
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// class CRecentBlockCache
+
+/**
+ * The LRU cache of the recently written or read blocks, bounded by their serialized size. The connecting of a
+ * block reads some recent blocks again, e.g. the mature block and the blocks leaving the tx and price point caches.
+ * The cached blocks are never changed, the txs of a block copied out are new instances.
+ */
+class CRecentBlockCache {
+public:
+    std::shared_ptr<const CBlock> Get(const uint256 &blockHash) {
+        LOCK(cs_cache);
+        auto it = mapBlocks.find(blockHash);
+        if (it == mapBlocks.end())
+            return nullptr;
+
+        lruHashes.splice(lruHashes.begin(), lruHashes, it->second.lruIt);
+        return it->second.pBlock;
+    }
+
+    void Add(const uint256 &blockHash, std::shared_ptr<const CBlock> pBlock, uint64_t blockSize) {
+        static const uint64_t maxSize = std::max<int64_t>(0, SysCfg().GetArg("-blockcache", DEFAULT_BLOCK_CACHE)) << 20;
+        if (blockSize > maxSize)
+            return;
+
+        LOCK(cs_cache);
+        if (mapBlocks.count(blockHash))
+            return;
+
+        lruHashes.push_front(blockHash);
+        mapBlocks[blockHash] = {pBlock, blockSize, lruHashes.begin()};
+        totalSize += blockSize;
+        while (totalSize > maxSize) {
+            auto it = mapBlocks.find(lruHashes.back());
+            totalSize -= it->second.size;
+            mapBlocks.erase(it);
+            lruHashes.pop_back();
+        }
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<const CBlock> pBlock;
+        uint64_t size;
+        list<uint256>::iterator lruIt;
+    };
+
+    CCriticalSection cs_cache;
+    map<uint256, Entry> mapBlocks;
+    list<uint256> lruHashes;  // the most recently used block is at the front
+    uint64_t totalSize = 0;
+};
+
+static CRecentBlockCache recentBlockCache;
+
+//////////////////////////////////////////////////////////////////////////////
+// class CBlockTxOffsets
+
+/**
+ * The side index of the tx offsets of the blocks, so that a tx located by its CTxCord is read from the block file
+ * alone, without deserializing the whole block. A block is indexed when it is written or read first. The index is
+ * kept in memory, bounded by the count of the offsets, and the oldest indexed blocks are dropped first.
+ */
+class CBlockTxOffsets {
+public:
+    std::shared_ptr<const vector<uint32_t>> Get(const uint256 &blockHash) {
+        LOCK(cs_offsets);
+        auto it = mapOffsets.find(blockHash);
+        return it != mapOffsets.end() ? it->second : nullptr;
+    }
+
+    void Add(const uint256 &blockHash, const CBlock &block) {
+        auto pOffsets = std::make_shared<vector<uint32_t>>();
+        block.GetTxOffsets(*pOffsets);
+
+        LOCK(cs_offsets);
+        if (!mapOffsets.emplace(blockHash, pOffsets).second)
+            return;
+
+        blockHashes.push_back(blockHash);
+        offsetCount += pOffsets->size();
+        while (offsetCount > MAX_BLOCK_TX_OFFSETS && blockHashes.size() > 1) {
+            auto it = mapOffsets.find(blockHashes.front());
+            offsetCount -= it->second->size();
+            mapOffsets.erase(it);
+            blockHashes.pop_front();
+        }
+    }
+
+private:
+    CCriticalSection cs_offsets;
+    unordered_map<uint256, std::shared_ptr<const vector<uint32_t>>, CUint256Hasher> mapOffsets;
+    deque<uint256> blockHashes;  // in the order indexed
+    uint64_t offsetCount = 0;
+};
+
+static CBlockTxOffsets blockTxOffsets;
+
+// copy the block with new instances of the txs, which may be changed when executed
+static void CopyBlock(const CBlock &from, CBlock &to) {
+    to = CBlock(from.GetBlockHeader());
+    to.vptx.reserve(from.vptx.size());
+    for (const auto &pTx : from.vptx)
+        to.vptx.push_back(pTx->GetNewInstance());
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // global functions
 
@@ -154,49 +273,98 @@ bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos) {
     if (!IsInitialBlockDownload())
         FileCommit(fileout);
 
+    // the block is to be connected soon
+    auto pCachedBlock = std::make_shared<CBlock>();
+    CopyBlock(block, *pCachedBlock);
+    recentBlockCache.Add(block.GetHash(), pCachedBlock, nSize);
+    blockTxOffsets.Add(block.GetHash(), block);
+
     return true;
 }
 
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block) {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein = CAutoFile(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (!filein)
-        return ERRORMSG("ReadBlockFromDisk : OpenBlockFile failed");
-
-    // Read block
-    try {
-        filein >> block;
-    } catch (std::exception &e) {
-        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
-    }
+    if (!ReadBlockFile(pos, [&](CBlockFileStream &stream) { stream >> block; }))
+        return ERRORMSG("ReadBlockFromDisk : read block file failed");
 
     return true;
 }
 
-bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
-    if (!ReadBlockFromDisk(pIndex->GetBlockPos(), block))
+bool ReadBlockFromDisk(const CBlockIndex *pIndex, std::shared_ptr<const CBlock> &pBlock) {
+    pBlock = recentBlockCache.Get(pIndex->GetBlockHash());
+    if (pBlock)
+        return true;
+
+    auto pNewBlock = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(pIndex->GetBlockPos(), *pNewBlock))
         return false;
 
-    if (block.GetHash() != pIndex->GetBlockHash())
+    if (pNewBlock->GetHash() != pIndex->GetBlockHash())
         return ERRORMSG("ReadBlockFromDisk(CBlock&, CBlockIndex*) : GetHash() doesn't match");
 
+    recentBlockCache.Add(pIndex->GetBlockHash(), pNewBlock, ::GetSerializeSize(*pNewBlock, SER_DISK, CLIENT_VERSION));
+    pBlock = pNewBlock;
     return true;
 }
 
+bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
+    std::shared_ptr<const CBlock> pBlock;
+    if (!ReadBlockFromDisk(pIndex, pBlock))
+        return false;
+
+    CopyBlock(*pBlock, block);
+    return true;
+}
+
+bool ReadTxFromBlockFile(const CDiskTxPos &txPos, std::shared_ptr<CBaseTx> &pTx, CBlockHeader *pHeader) {
+    CBlockHeader header;
+    CBlockHeader &headerOut = pHeader != nullptr ? *pHeader : header;
+    return ReadBlockFile(txPos, [&](CBlockFileStream &stream) {
+        stream >> headerOut;
+        stream.ignore(txPos.nTxOffset);
+        stream >> pTx;
+    });
+}
+
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx) {
-    auto pBlock = std::make_shared<CBlock>();
     const CBlockIndex* pBlockIndex = chainActive[ txCord.GetHeight() ];
     if (pBlockIndex == nullptr) {
         return ERRORMSG("ReadBaseTxFromDisk error, the height(%d) is exceed current best block height", txCord.GetHeight());
     }
-    if (!ReadBlockFromDisk(pBlockIndex, *pBlock)) {
+    const uint256 &blockHash = pBlockIndex->GetBlockHash();
+
+    std::shared_ptr<const CBlock> pCachedBlock = recentBlockCache.Get(blockHash);
+    if (pCachedBlock) {
+        if (txCord.GetIndex() >= pCachedBlock->vptx.size()) {
+            return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
+        }
+        pTx = pCachedBlock->vptx[txCord.GetIndex()]->GetNewInstance();
+        return true;
+    }
+
+    // read only the tx from the block file when the block has been indexed
+    std::shared_ptr<const vector<uint32_t>> pOffsets = blockTxOffsets.Get(blockHash);
+    if (pOffsets) {
+        if (txCord.GetIndex() >= pOffsets->size()) {
+            return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
+        }
+        CDiskTxPos txPos(pBlockIndex->GetBlockPos(), (*pOffsets)[txCord.GetIndex()]);
+        if (!ReadTxFromBlockFile(txPos, pTx)) {
+            return ERRORMSG("ReadBaseTxFromDisk error, read the tx(%s) from block file failed!", txCord.ToString());
+        }
+        return true;
+    }
+
+    CBlock block;
+    if (!ReadBlockFromDisk(pBlockIndex->GetBlockPos(), block)) {
         return ERRORMSG("ReadBaseTxFromDisk error, read the block at height(%d) failed!", txCord.GetHeight());
     }
-    if (txCord.GetIndex() >= pBlock->vptx.size()) {
+    blockTxOffsets.Add(blockHash, block);
+
+    if (txCord.GetIndex() >= block.vptx.size()) {
         return ERRORMSG("ReadBaseTxFromDisk error, the tx(%s) index exceed the tx count of block", txCord.ToString());
     }
-    pTx = pBlock->vptx.at(txCord.GetIndex())->GetNewInstance();
+    pTx = block.vptx[txCord.GetIndex()];
     return true;
 }
@@ -21,7 +21,9 @@
 
 
 #include <stdint.h>
+#include <functional>
 #include <memory>
+#include <unordered_map>
 
 class CBlockDBCache;
 class CDiskBlockPos;
@@ -176,6 +178,9 @@ public:
     vector<uint256> GetMerkleBranch(int32_t index) const;
     static uint256 CheckMerkleBranch(uint256 hash, const vector<uint256> &vMerkleBranch, int32_t index);
 
+    // the offsets of the txs in the serialized block after its header, as the nTxOffset of CDiskTxPos
+    void GetTxOffsets(vector<uint32_t> &offsets) const;
+
     map<TokenSymbol, uint64_t> GetFees() const;
     PriceMap GetBlockMedianPrice() const;
     CUserID GetMinerUserID() const;
@@ -211,9 +216,6 @@ public:
     // Byte offset within rev?????.dat where this block's undo data is stored
     uint32_t nUndoPos;
 
-    // (memory only) Total amount of work (expected number of hashes) in the chain up to and including this block
-    arith_uint256 nChainWork;
-
     // Number of transactions in this block.
     // Note: in a potential headers-first mode, this number cannot be relied upon
     uint32_t nTx;
@@ -230,9 +232,7 @@ public:
     // block header
     int32_t nVersion;
     uint256 merkleRootHash;
-    uint256 hashPos;
     uint32_t nTime;
-    uint32_t nBits;
     uint32_t nNonce;
     uint64_t nFuel;
     uint32_t nFuelRate;
@@ -248,7 +248,6 @@ public:
         nFile            = 0;
         nDataPos         = 0;
         nUndoPos         = 0;
-        nChainWork       = 0;
         nTx              = 0;
         nChainTx         = 0;
         nStatus          = 0;
@@ -256,9 +255,7 @@ public:
 
         nVersion       = 0;
         merkleRootHash = uint256();
-        hashPos        = uint256();
         nTime          = 0;
-        nBits          = 0;
         nNonce         = 0;
         nFuel          = 0;
         nFuelRate      = INIT_FUEL_RATES;
@@ -273,7 +270,6 @@ public:
         nFile            = 0;
         nDataPos         = 0;
         nUndoPos         = 0;
-        nChainWork       = 0;
         nTx              = 0;
         nChainTx         = 0;
         nStatus          = 0;
@@ -325,6 +321,8 @@ public:
         block.SetTime(nTime);
         block.SetNonce(nNonce);
         block.SetHeight(height);
+        block.SetFuel(nFuel);
+        block.SetFuelRate(nFuelRate);
         block.SetSignature(vSignature);
 
         return block;
@@ -332,6 +330,8 @@ public:
 
     uint256 GetBlockHash() const { return *pBlockHash; }
     int64_t GetBlockTime() const { return (int64_t)nTime; }
+    // Total amount of work in the chain up to and including this block, every block counts one
+    arith_uint256 GetChainWork() const { return arith_uint256(height); }
     bool CheckIndex() const { return true; }
 
     enum { nMedianTimeSpan = 11 };
@@ -360,7 +360,7 @@ public:
 
     string ToString() const {
         return strprintf("CBlockIndex(pprev=%p, height=%d, merkle=%s, blockHash=%s, chainWork=%s, regId=%s)", pprev, height,
-                         merkleRootHash.ToString(), GetBlockHash().ToString(), nChainWork.ToString(), miner.ToString());
+                         merkleRootHash.ToString(), GetBlockHash().ToString(), GetChainWork().ToString(), miner.ToString());
     }
 
     string GetIndentityString() const {
@@ -382,10 +382,13 @@ public:
 class CDiskBlockIndex : public CBlockIndex {
 public:
     uint256 hashPrev;
+    // unused since the pow era, not kept in memory
+    uint256 hashPos;
+    uint32_t nBits;
 
-    CDiskBlockIndex() : hashPrev(uint256()) {}
+    CDiskBlockIndex() : hashPrev(uint256()), hashPos(uint256()), nBits(0) {}
 
-    explicit CDiskBlockIndex(CBlockIndex *pIndex) : CBlockIndex(*pIndex) {
+    explicit CDiskBlockIndex(CBlockIndex *pIndex) : CBlockIndex(*pIndex), hashPos(uint256()), nBits(0) {
         hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
     }
 
@@ -445,6 +448,34 @@ public:
     }
 };
 
+typedef std::unordered_map<uint256, CBlockIndex *, CUint256Hasher> BlockMap;
+
+/**
+ * The block indexes loaded at startup are allocated together in height order, which saves the allocation overhead
+ * per index and keeps the passes over them in height order cache friendly. The indexes of the blocks accepted later
+ * are allocated one by one.
+ */
+class CBlockIndexArena {
+public:
+    CBlockIndex *Alloc(size_t count) {
+        chunks.emplace_back(std::unique_ptr<CBlockIndex[]>(new CBlockIndex[count]), count);
+        return chunks.back().first.get();
+    }
+
+    // the indexes allocated by the arena must not be deleted
+    bool Owns(const CBlockIndex *pIndex) const {
+        std::less<const CBlockIndex *> less;
+        for (const auto &chunk : chunks) {
+            if (!less(pIndex, chunk.first.get()) && less(pIndex, chunk.first.get() + chunk.second))
+                return true;
+        }
+        return false;
+    }
+
+private:
+    vector<pair<std::unique_ptr<CBlockIndex[]>, size_t>> chunks;
+};
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
@@ -469,7 +500,12 @@ struct CBlockLocator {
 bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos);
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block);
 bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block);
+// read the block shared with the recent block cache, which must not be changed
+bool ReadBlockFromDisk(const CBlockIndex *pIndex, std::shared_ptr<const CBlock> &pBlock);
+
 
+/** Read the tx at the tx pos of a block file, and the header of its block if pHeader is not null */
+bool ReadTxFromBlockFile(const CDiskTxPos &txPos, std::shared_ptr<CBaseTx> &pTx, CBlockHeader *pHeader = nullptr);
 
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx);
 
@@ -10,10 +10,17 @@
 #include "main.h"
 
 #include <stdint.h>
+#include <algorithm>
+#include <iterator>
+
+#include <boost/thread.hpp>
 
 using namespace std;
 
 
+// the max. number of threads reading the block indexes at startup
+static const int32_t MAX_BLOCK_INDEX_LOAD_THREADS = 8;
+
 /********************** CBlockIndexDB ********************************/
 bool CBlockIndexDB::WriteBlockIndex(const CDiskBlockIndex &blockIndex) {
     return Write(dbk::GenDbKey(dbk::BLOCK_INDEX, blockIndex.GetBlockHash()), blockIndex);
@@ -22,55 +29,94 @@ bool CBlockIndexDB::EraseBlockIndex(const uint256 &blockHash) {
     return Erase(dbk::GenDbKey(dbk::BLOCK_INDEX, blockHash));
 }
 
-bool CBlockIndexDB::LoadBlockIndexes() {
-    leveldb::Iterator *pCursor = NewIterator();
+bool CBlockIndexDB::LoadBlockIndexes(vector<CBlockIndex *> &sortedByHeight) {
+    // 1. Read the disk indexes on parallel threads. The keys are ordered by the block hash, so the key ranges split
+    // by the first byte of the hash are about the same size.
     const std::string &prefix = dbk::GetKeyPrefix(dbk::BLOCK_INDEX);
-
-    pCursor->Seek(prefix);
-
-    // Load mapBlockIndex
-    while (pCursor->Valid()) {
-        boost::this_thread::interruption_point();
+    int32_t threads = std::max<int32_t>(
+        1, std::min<int32_t>(boost::thread::hardware_concurrency(), MAX_BLOCK_INDEX_LOAD_THREADS));
+    vector<vector<pair<uint256, CDiskBlockIndex>>> rangeIndexes(threads);
+    vector<string> rangeErrors(threads);
+    const leveldb::Snapshot *pSnapshot = GetSnapshot();
+
+    auto loadRange = [&](int32_t range) {
+        const string beginKey = prefix + char(range * 256 / threads);
+        const string endKey   = prefix + char((range + 1) * 256 / threads);
+        bool isLastRange      = range == threads - 1;
+        std::unique_ptr<leveldb::Iterator> pCursor(NewIterator(pSnapshot));
         try {
-            leveldb::Slice slKey = pCursor->key();
-            if (slKey.starts_with(prefix)) {
+            for (pCursor->Seek(beginKey); pCursor->Valid(); pCursor->Next()) {
+                leveldb::Slice slKey = pCursor->key();
+                if (!slKey.starts_with(prefix) || (!isLastRange && slKey.compare(endKey) >= 0))
+                    break;
+
+                uint256 blockHash;
+                dbk::ParseDbKey(slKey, dbk::BLOCK_INDEX, blockHash);
                 leveldb::Slice slValue = pCursor->value();
                 CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-                CDiskBlockIndex diskIndex;
-                ssValue >> diskIndex;
-
-                // Construct block index object
-                CBlockIndex *pIndexNew    = InsertBlockIndex(diskIndex.GetBlockHash());
-                pIndexNew->pprev          = InsertBlockIndex(diskIndex.hashPrev);
-                pIndexNew->height         = diskIndex.height;
-                pIndexNew->nFile          = diskIndex.nFile;
-                pIndexNew->nDataPos       = diskIndex.nDataPos;
-                pIndexNew->nUndoPos       = diskIndex.nUndoPos;
-                pIndexNew->nVersion       = diskIndex.nVersion;
-                pIndexNew->merkleRootHash = diskIndex.merkleRootHash;
-                pIndexNew->hashPos        = diskIndex.hashPos;
-                pIndexNew->nTime          = diskIndex.nTime;
-                pIndexNew->nBits          = diskIndex.nBits;
-                pIndexNew->nNonce         = diskIndex.nNonce;
-                pIndexNew->nStatus        = diskIndex.nStatus;
-                pIndexNew->nTx            = diskIndex.nTx;
-                pIndexNew->nFuel          = diskIndex.nFuel;
-                pIndexNew->nFuelRate      = diskIndex.nFuelRate;
-                pIndexNew->vSignature     = diskIndex.vSignature;
-                pIndexNew->miner          = diskIndex.miner ;
-
-                if (!pIndexNew->CheckIndex())
-                    return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
-
-                pCursor->Next();
-            } else {
-                break;  // if shutdown requested or finished loading block index
+                rangeIndexes[range].emplace_back(blockHash, CDiskBlockIndex());
+                ssValue >> rangeIndexes[range].back().second;
             }
         } catch (std::exception &e) {
-            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+            rangeErrors[range] = e.what();
         }
+    };
+
+    boost::thread_group loaders;
+    for (int32_t range = 1; range < threads; ++range) {
+        loaders.create_thread([&, range]() {
+            RenameThread("coin-loadidx");
+            loadRange(range);
+        });
+    }
+    loadRange(0);
+    loaders.join_all();
+    ReleaseSnapshot(pSnapshot);
+
+    for (const auto &error : rangeErrors) {
+        if (!error.empty())
+            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, error);
+    }
+    boost::this_thread::interruption_point();
+
+    vector<pair<uint256, CDiskBlockIndex>> diskIndexes;
+    for (auto &indexes : rangeIndexes) {
+        if (diskIndexes.empty())
+            diskIndexes.swap(indexes);
+        else
+            std::move(indexes.begin(), indexes.end(), std::back_inserter(diskIndexes));
+        vector<pair<uint256, CDiskBlockIndex>>().swap(indexes);
+    }
+
+    vector<uint32_t> heightOrder(diskIndexes.size());
+    for (uint32_t i = 0; i < heightOrder.size(); ++i)
+        heightOrder[i] = i;
+    std::stable_sort(heightOrder.begin(), heightOrder.end(), [&](uint32_t a, uint32_t b) {
+        return diskIndexes[a].second.height < diskIndexes[b].second.height;
+    });
+
+    // 2. Construct the block indexes in height order in the arena, then link them by the hash lookup table.
+    CBlockIndex *pArena = blockIndexArena.Alloc(diskIndexes.size());
+    mapBlockIndex.reserve(mapBlockIndex.size() + diskIndexes.size());
+    sortedByHeight.reserve(diskIndexes.size());
+    for (uint32_t i = 0; i < heightOrder.size(); ++i) {
+        auto &item = diskIndexes[heightOrder[i]];
+        auto ret   = mapBlockIndex.emplace(item.first, &pArena[i]);
+
+        // the disk index holds the fields of the block index, and null pointers
+        CBlockIndex *pIndexNew = ret.first->second;
+        *pIndexNew             = std::move(static_cast<CBlockIndex &>(item.second));
+        pIndexNew->pBlockHash  = &ret.first->first;
+        sortedByHeight.push_back(pIndexNew);
+    }
+
+    for (uint32_t i = 0; i < heightOrder.size(); ++i) {
+        CBlockIndex *pIndexNew = sortedByHeight[i];
+        pIndexNew->pprev       = InsertBlockIndex(diskIndexes[heightOrder[i]].second.hashPrev);
+
+        if (!pIndexNew->CheckIndex())
+            return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
     }
-    delete pCursor;
 
     return true;
 }
@@ -87,7 +133,7 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
         return nullptr;
 
     // Return existing
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hash);
+    BlockMap::iterator mi = mapBlockIndex.find(hash);
     if (mi != mapBlockIndex.end())
         return (*mi).second;
 
@@ -31,7 +31,8 @@ public:
 public:
     bool WriteBlockIndex(const CDiskBlockIndex &blockindex);
     bool EraseBlockIndex(const uint256 &blockHash);
-    bool LoadBlockIndexes();
+    // Load the block indexes into mapBlockIndex, and output them in height order
+    bool LoadBlockIndexes(vector<CBlockIndex *> &sortedByHeight);
 
     bool ReadBlockFileInfo(int32_t nFile, CBlockFileInfo &fileinfo);
     bool WriteBlockFileInfo(int32_t nFile, const CBlockFileInfo &fileinfo);
@@ -81,6 +82,26 @@ public:
 
     };
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        txDiskPosCache.SetDbAccess(pDbAccessIn);
+        flagCache.SetDbAccess(pDbAccessIn);
+        bestBlockHashCache.SetDbAccess(pDbAccessIn);
+        lastBlockFileCache.SetDbAccess(pDbAccessIn);
+        medianPricesCache.SetDbAccess(pDbAccessIn);
+        reindexCache.SetDbAccess(pDbAccessIn);
+        finalityBlockCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CBlockDBCache *pBaseIn) {
+        txDiskPosCache.SetFrozenBase(&pBaseIn->txDiskPosCache);
+        flagCache.SetFrozenBase(&pBaseIn->flagCache);
+        bestBlockHashCache.SetFrozenBase(&pBaseIn->bestBlockHashCache);
+        lastBlockFileCache.SetFrozenBase(&pBaseIn->lastBlockFileCache);
+        medianPricesCache.SetFrozenBase(&pBaseIn->medianPricesCache);
+        reindexCache.SetFrozenBase(&pBaseIn->reindexCache);
+        finalityBlockCache.SetFrozenBase(&pBaseIn->finalityBlockCache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         txDiskPosCache.SetDbOpLogMap(pDbOpLogMapIn);
         flagCache.SetDbOpLogMap(pDbOpLogMapIn);
@@ -91,6 +112,26 @@ public:
         finalityBlockCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        txDiskPosCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        flagCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        bestBlockHashCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        lastBlockFileCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        medianPricesCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        reindexCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        finalityBlockCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        txDiskPosCache.DiscardData(dbKeys);
+        flagCache.DiscardData(dbKeys);
+        bestBlockHashCache.DiscardData(dbKeys);
+        lastBlockFileCache.DiscardData(dbKeys);
+        medianPricesCache.DiscardData(dbKeys);
+        reindexCache.DiscardData(dbKeys);
+        finalityBlockCache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         txDiskPosCache.RegisterUndoFunc(undoDataFuncMap);
         flagCache.RegisterUndoFunc(undoDataFuncMap);
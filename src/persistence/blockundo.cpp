@@ -30,8 +30,13 @@ bool CBlockUndo::WriteToDisk(CDiskBlockPos &pos, const uint256 &blockHash) {
     if (!fileout)
         return ERRORMSG("CBlockUndo::WriteToDisk : OpenUndoFile failed");
 
+    // Serialize the undo data once into a contiguous buffer, which is written and hashed as it is
+    CDataStream ssUndo(SER_DISK, CLIENT_VERSION);
+    ssUndo.reserve(GetSerializeSize(SER_DISK, CLIENT_VERSION));
+    ssUndo << *this;
+
     // Write index header
-    uint32_t nSize = fileout.GetSerializeSize(*this);
+    uint32_t nSize = ssUndo.size();
     fileout << FLATDATA(SysCfg().MessageStart()) << nSize;
 
     // Write undo data
@@ -39,12 +44,12 @@ bool CBlockUndo::WriteToDisk(CDiskBlockPos &pos, const uint256 &blockHash) {
     if (fileOutPos < 0)
         return ERRORMSG("CBlockUndo::WriteToDisk : ftell failed");
     pos.nPos = (uint32_t)fileOutPos;
-    fileout << *this;
+    fileout.write(&ssUndo[0], ssUndo.size());
 
     // calculate & write checksum
     CHashWriter hasher(SER_GETHASH, PROTOCOL_VERSION);
     hasher << blockHash;
-    hasher << *this;
+    hasher.write(&ssUndo[0], ssUndo.size());
 
     fileout << hasher.GetHash();
 
@@ -53,6 +53,12 @@ public:
 
     bool ReadFromDisk(const CDiskBlockPos &pos, const uint256 &blockHash);
 
+    // get the db keys changed by the block
+    void GetDbKeys(set<string> &dbKeys) const {
+        for (const auto &txUndo : vtxundo)
+            txUndo.dbOpLogMap.GetDbKeys(dbKeys);
+    }
+
     string ToString() const;
 };
 
@@ -69,7 +75,7 @@ public:
         cw.SetDbOpLogMap(&tx_undo.dbOpLogMap);
     }
     ~CTxUndoOpLogger() {
-        block_undo.vtxundo.push_back(tx_undo);
+        block_undo.vtxundo.push_back(std::move(tx_undo));
         cw.SetDbOpLogMap(nullptr);
     }
 };
@@ -6,14 +6,83 @@
 #include "cachewrapper.h"
 #include "main.h"
 #include "logging.h"
+#include "commons/random.h"
+#include "crypto/hash.h"
+
+#include <boost/filesystem.hpp>
 
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheWrapper
 
-std::shared_ptr<CCacheWrapper>CCacheWrapper::NewCopyFrom(CCacheDBManager* pCdMan) {
-    auto pNewCopy = make_shared<CCacheWrapper>();
-    pNewCopy->CopyFrom(pCdMan);
-    return pNewCopy;
+std::shared_ptr<CCacheWrapper> CCacheWrapper::NewSnapshotFrom(CCacheDBManager* pCdMan) {
+    auto pSnapshot = make_shared<CCacheWrapper>();
+    auto NewDbSnapshot = [&pSnapshot](CDBAccess *pDb) {
+        pSnapshot->snapshotDbs.push_back(pDb->NewSnapshot());
+        return pSnapshot->snapshotDbs.back().get();
+    };
+
+    pSnapshot->sysParamCache  = *pCdMan->pSysParamCache;
+    pSnapshot->blockCache     = *pCdMan->pBlockCache;
+    pSnapshot->accountCache   = *pCdMan->pAccountCache;
+    pSnapshot->assetCache     = *pCdMan->pAssetCache;
+    pSnapshot->contractCache  = *pCdMan->pContractCache;
+    pSnapshot->delegateCache  = *pCdMan->pDelegateCache;
+    pSnapshot->cdpCache       = *pCdMan->pCdpCache;
+    pSnapshot->closedCdpCache = *pCdMan->pClosedCdpCache;
+    pSnapshot->dexCache       = *pCdMan->pDexCache;
+    pSnapshot->txReceiptCache = *pCdMan->pReceiptCache;
+    pSnapshot->txUtxoCache    = *pCdMan->pUtxoCache;
+    pSnapshot->sysGovernCache = *pCdMan->pSysGovernCache;
+    pSnapshot->txCache        = *pCdMan->pTxCache;
+    pSnapshot->ppCache        = *pCdMan->pPpCache;
+
+    pSnapshot->sysParamCache.SetDbAccess(NewDbSnapshot(pCdMan->pSysParamDb));
+    pSnapshot->blockCache.SetDbAccess(NewDbSnapshot(pCdMan->pBlockDb));
+    pSnapshot->accountCache.SetDbAccess(NewDbSnapshot(pCdMan->pAccountDb));
+    pSnapshot->assetCache.SetDbAccess(NewDbSnapshot(pCdMan->pAssetDb));
+    pSnapshot->contractCache.SetDbAccess(NewDbSnapshot(pCdMan->pContractDb));
+    pSnapshot->delegateCache.SetDbAccess(NewDbSnapshot(pCdMan->pDelegateDb));
+    pSnapshot->cdpCache.SetDbAccess(NewDbSnapshot(pCdMan->pCdpDb));
+    pSnapshot->closedCdpCache.SetDbAccess(NewDbSnapshot(pCdMan->pClosedCdpDb));
+    pSnapshot->dexCache.SetDbAccess(NewDbSnapshot(pCdMan->pDexDb));
+    pSnapshot->txReceiptCache.SetDbAccess(NewDbSnapshot(pCdMan->pReceiptDb));
+    pSnapshot->txUtxoCache.SetDbAccess(NewDbSnapshot(pCdMan->pUtxoDb));
+    pSnapshot->sysGovernCache.SetDbAccess(NewDbSnapshot(pCdMan->pSysGovernDb));
+
+    return pSnapshot;
+}
+
+std::shared_ptr<CCacheWrapper> CCacheWrapper::NewSnapshotLayer(const std::shared_ptr<CCacheWrapper> &spBase,
+                                                               CCacheWrapper &cw) {
+    auto pLayer = make_shared<CCacheWrapper>();
+    *pLayer     = cw;
+
+    pLayer->sysParamCache.SetFrozenBase(&spBase->sysParamCache);
+    pLayer->blockCache.SetFrozenBase(&spBase->blockCache);
+    pLayer->accountCache.SetFrozenBase(&spBase->accountCache);
+    pLayer->assetCache.SetFrozenBase(&spBase->assetCache);
+    pLayer->contractCache.SetFrozenBase(&spBase->contractCache);
+    pLayer->delegateCache.SetFrozenBase(&spBase->delegateCache);
+    pLayer->cdpCache.SetFrozenBase(&spBase->cdpCache);
+    pLayer->closedCdpCache.SetFrozenBase(&spBase->closedCdpCache);
+    pLayer->dexCache.SetFrozenBase(&spBase->dexCache);
+    pLayer->txReceiptCache.SetFrozenBase(&spBase->txReceiptCache);
+    pLayer->txUtxoCache.SetFrozenBase(&spBase->txUtxoCache);
+    pLayer->sysGovernCache.SetFrozenBase(&spBase->sysGovernCache);
+
+    // the mem caches are never changed by reading them. The txids of the block replace the ones of the global tx cache
+    // when it's flushed, so the tx cache of the layer looks up no base.
+    pLayer->txCache.SetBaseViewPtr(nullptr);
+    pLayer->ppCache.SetBaseViewPtr(&spBase->ppCache);
+
+    pLayer->spFrozenBase = spBase;
+    return pLayer;
+}
+
+std::shared_ptr<CCacheWrapper> CCacheWrapper::NewChildOf(const std::shared_ptr<CCacheWrapper> &spFrozen) {
+    auto pChild          = make_shared<CCacheWrapper>(spFrozen.get());
+    pChild->spFrozenBase = spFrozen;
+    return pChild;
 }
 
 CCacheWrapper::CCacheWrapper() {}
@@ -54,24 +123,6 @@ CCacheWrapper::CCacheWrapper(CCacheDBManager* pCdMan) {
     sysGovernCache.SetBaseViewPtr(pCdMan->pSysGovernCache);
 }
 
-void CCacheWrapper::CopyFrom(CCacheDBManager* pCdMan){
-    sysParamCache  = *pCdMan->pSysParamCache;
-    blockCache     = *pCdMan->pBlockCache;
-    accountCache   = *pCdMan->pAccountCache;
-    assetCache     = *pCdMan->pAssetCache;
-    contractCache  = *pCdMan->pContractCache;
-    delegateCache  = *pCdMan->pDelegateCache;
-    cdpCache       = *pCdMan->pCdpCache;
-    closedCdpCache = *pCdMan->pClosedCdpCache;
-    dexCache       = *pCdMan->pDexCache;
-    txReceiptCache = *pCdMan->pReceiptCache;
-    txUtxoCache    = *pCdMan->pUtxoCache;
-
-    txCache = *pCdMan->pTxCache;
-    ppCache = *pCdMan->pPpCache;
-    sysGovernCache = *pCdMan->pSysGovernCache ;
-}
-
 CCacheWrapper& CCacheWrapper::operator=(CCacheWrapper& other) {
     if (this == &other)
         return *this;
@@ -112,7 +163,13 @@ void CCacheWrapper::Flush() {
     sysGovernCache.Flush();
 }
 
-void CCacheWrapper::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap) {
+void CCacheWrapper::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
+    assert(!hasSavepoint);
+    pDbOpLogMap = pDbOpLogMapIn;
+    SetCachesDbOpLogMap(pDbOpLogMapIn);
+}
+
+void CCacheWrapper::SetCachesDbOpLogMap(CDBOpLogMap *pDbOpLogMap) {
     sysParamCache.SetDbOpLogMap(pDbOpLogMap);
     blockCache.SetDbOpLogMap(pDbOpLogMap);
     accountCache.SetDbOpLogMap(pDbOpLogMap);
@@ -127,6 +184,80 @@ void CCacheWrapper::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap) {
     sysGovernCache.SetDbOpLogMap(pDbOpLogMap) ;
 }
 
+void CCacheWrapper::SetDbKeyTracker(CDBKeyTracker *pDbKeyTracker) {
+    sysParamCache.SetDbKeyTracker(pDbKeyTracker);
+    blockCache.SetDbKeyTracker(pDbKeyTracker);
+    accountCache.SetDbKeyTracker(pDbKeyTracker);
+    assetCache.SetDbKeyTracker(pDbKeyTracker);
+    contractCache.SetDbKeyTracker(pDbKeyTracker);
+    delegateCache.SetDbKeyTracker(pDbKeyTracker);
+    cdpCache.SetDbKeyTracker(pDbKeyTracker);
+    closedCdpCache.SetDbKeyTracker(pDbKeyTracker);
+    dexCache.SetDbKeyTracker(pDbKeyTracker);
+    txReceiptCache.SetDbKeyTracker(pDbKeyTracker);
+    txUtxoCache.SetDbKeyTracker(pDbKeyTracker);
+    sysGovernCache.SetDbKeyTracker(pDbKeyTracker);
+}
+
+void CCacheWrapper::DiscardData(const set<string> &dbKeys) {
+    sysParamCache.DiscardData(dbKeys);
+    blockCache.DiscardData(dbKeys);
+    accountCache.DiscardData(dbKeys);
+    assetCache.DiscardData(dbKeys);
+    contractCache.DiscardData(dbKeys);
+    delegateCache.DiscardData(dbKeys);
+    cdpCache.DiscardData(dbKeys);
+    closedCdpCache.DiscardData(dbKeys);
+    dexCache.DiscardData(dbKeys);
+    txReceiptCache.DiscardData(dbKeys);
+    txUtxoCache.DiscardData(dbKeys);
+    sysGovernCache.DiscardData(dbKeys);
+}
+
+void CCacheWrapper::SetSavepoint() {
+    assert(!hasSavepoint);
+    hasSavepoint = true;
+    savepointOpLogs.Clear();
+    // the price point cache has no op logs, and holds only the prices written through this cache wrapper
+    savepointPpCache = ppCache;
+    SetCachesDbOpLogMap(&savepointOpLogs);
+}
+
+bool CCacheWrapper::RollbackToSavepoint() {
+    assert(hasSavepoint);
+    hasSavepoint = false;
+    SetCachesDbOpLogMap(pDbOpLogMap);
+    ppCache = savepointPpCache;
+
+    const UndoDataFuncMap &undoDataFuncMap = GetUndoDataFuncMap();
+    for (const auto &opLogPair : savepointOpLogs.GetMap()) {
+        dbk::PrefixType prefixType = dbk::ParseKeyPrefixType(opLogPair.first);
+        auto funcMapIt             = undoDataFuncMap.find(prefixType);
+        if (funcMapIt == undoDataFuncMap.end())
+            return ERRORMSG("%s(), unfound prefix in db! prefix_type=%s", __FUNCTION__, opLogPair.first);
+
+        funcMapIt->second(opLogPair.second);
+    }
+    savepointOpLogs.Clear();
+
+    return true;
+}
+
+void CCacheWrapper::ReleaseSavepoint() {
+    assert(hasSavepoint);
+    hasSavepoint = false;
+    SetCachesDbOpLogMap(pDbOpLogMap);
+
+    if (pDbOpLogMap != nullptr) {
+        for (auto &opLogPair : savepointOpLogs.GetMap()) {
+            CDbOpLogs &dbOpLogs = pDbOpLogMap->GetMap()[opLogPair.first];
+            dbOpLogs.insert(dbOpLogs.end(), std::make_move_iterator(opLogPair.second.begin()),
+                            std::make_move_iterator(opLogPair.second.end()));
+        }
+    }
+    savepointOpLogs.Clear();
+}
+
 UndoDataFuncMap CCacheWrapper::GetUndoDataFuncMap() {
     UndoDataFuncMap undoDataFuncMap;
     sysParamCache.RegisterUndoFunc(undoDataFuncMap);
@@ -149,6 +280,11 @@ UndoDataFuncMap CCacheWrapper::GetUndoDataFuncMap() {
 
 CCacheDBManager::CCacheDBManager(bool fReIndex, bool fMemory) {
     const boost::filesystem::path& dbDir = GetDataDir() / "blocks";
+    // the journal is of the wiped dbs when reindexing
+    pathFlushJournal = dbDir / "flushjournal.dat";
+    if (fReIndex)
+        boost::filesystem::remove(pathFlushJournal);
+
     pSysParamDb     = new CDBAccess(dbDir, DBNameType::SYSPARAM, false, fReIndex);
     pSysParamCache  = new CSysParamDBCache(pSysParamDb);
 
@@ -190,12 +326,20 @@ CCacheDBManager::CCacheDBManager(bool fReIndex, bool fMemory) {
     pSysGovernDb    = new CDBAccess(dbDir, DBNameType::SYSGOVERN, false, fReIndex);
     pSysGovernCache = new CSysGovernDBCache(pSysGovernDb);
 
+    uint64_t readCacheSize = std::max<int64_t>(0, SysCfg().GetArg("-dbreadcache", DEFAULT_DB_READ_CACHE)) << 20;
+    for (auto pDb : {pSysParamDb, pAccountDb, pAssetDb, pContractDb, pDelegateDb, pCdpDb, pClosedCdpDb, pDexDb,
+                     pBlockDb, pLogDb, pReceiptDb, pUtxoDb, pSysGovernDb}) {
+        pDb->SetReadCacheSize(readCacheSize);
+    }
+
     // memory-only cache
     pTxCache        = new CTxMemCache();
     pPpCache        = new CPricePointMemCache();
 }
 
 CCacheDBManager::~CCacheDBManager() {
+    WaitForAsyncFlush();
+
     delete pSysParamCache;  pSysParamCache = nullptr;
     delete pAccountCache;   pAccountCache = nullptr;
     delete pAssetCache;     pAssetCache = nullptr;
@@ -231,6 +375,166 @@ CCacheDBManager::~CCacheDBManager() {
 }
 
 bool CCacheDBManager::Flush() {
+    return AsyncFlush() && WaitForAsyncFlush();
+}
+
+vector<CDBAccess *> CCacheDBManager::GetStateDbs() const {
+    return {pSysParamDb, pAccountDb, pAssetDb, pContractDb, pDelegateDb, pCdpDb, pClosedCdpDb,
+            pDexDb,      pLogDb,     pReceiptDb, pUtxoDb,   pSysGovernDb, pBlockDb};
+}
+
+// Write the deferred data of the dbs to the journal file, it is in place only when completely written.
+static bool WriteFlushJournal(const boost::filesystem::path &pathJournal, const vector<CDBAccess *> &dbs) {
+    CDataStream ssJournal(SER_DISK, CLIENT_VERSION);
+    ssJournal << FLATDATA(SysCfg().MessageStart());
+    for (auto pDb : dbs) {
+        auto pData = pDb->GetDeferredData();
+        if (pData)
+            ssJournal << (uint8_t)pDb->GetDbNameType() << pData->puts << pData->erases;
+    }
+    uint256 hash = Hash(ssJournal.begin(), ssJournal.end());
+    ssJournal << hash;
+
+    boost::filesystem::path pathTmp = pathJournal;
+    pathTmp += strprintf(".%04x", GetRand(0x10000));
+    FILE *file            = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout     = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    try {
+        fileout << ssJournal;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout);
+    fileout.fclose();
+
+    if (!RenameOver(pathTmp, pathJournal))
+        return ERRORMSG("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
+
+bool CCacheDBManager::RecoverFlushJournal() {
+    if (!boost::filesystem::exists(pathFlushJournal))
+        return true;
+
+    FILE *file       = fopen(pathFlushJournal.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathFlushJournal.string());
+
+    int64_t dataSize = boost::filesystem::file_size(pathFlushJournal) - sizeof(uint256);
+    if (dataSize < 0)
+        dataSize = 0;
+    vector<uint8_t> vchData(dataSize);
+    uint256 hashIn;
+    try {
+        filein.read((char *)vchData.data(), dataSize);
+        filein >> hashIn;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssJournal(vchData, SER_DISK, CLIENT_VERSION);
+    if (hashIn != Hash(ssJournal.begin(), ssJournal.end()))
+        return ERRORMSG("%s : Checksum mismatch, data corrupted", __func__);
+
+    map<DBNameType, CDBAccess *> dbs;
+    for (auto pDb : GetStateDbs()) {
+        dbs[pDb->GetDbNameType()] = pDb;
+    }
+
+    // the journal holds the final values of the keys, so replaying the dbs written before the crash is harmless
+    try {
+        uint8_t pchMsgTmp[4];
+        ssJournal >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)))
+            return ERRORMSG("%s : Invalid network magic number", __func__);
+
+        while (!ssJournal.empty()) {
+            uint8_t dbNameType;
+            map<string, string> puts;
+            set<string> erases;
+            ssJournal >> dbNameType >> puts >> erases;
+
+            auto it = dbs.find((DBNameType)dbNameType);
+            if (it == dbs.end())
+                return ERRORMSG("%s : Unknown db %u", __func__, dbNameType);
+
+            it->second->WriteSerializedBatch(puts, erases);
+            LogPrint(BCLog::INFO, "%s : Replayed %u puts and %u erases of db %s\n", __func__, puts.size(),
+                     erases.size(), ::GetDbName(it->first));
+        }
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    try {
+        boost::filesystem::remove(pathFlushJournal);
+    } catch (const boost::filesystem::filesystem_error &e) {
+        return ERRORMSG("%s : Failed to remove file %s - %s", __func__, pathFlushJournal.string(), e.what());
+    }
+
+    return true;
+}
+
+bool CCacheDBManager::AsyncFlush() {
+    if (!WaitForAsyncFlush())
+        return false;
+
+    // The block db holding the best block hash is written at last, so it never runs ahead of the chain state.
+    vector<CDBAccess *> dbs = GetStateDbs();
+    for (auto pDb : dbs) {
+        pDb->BeginDeferredWrite();
+    }
+
+    FlushCaches();
+
+    for (auto pDb : dbs) {
+        pDb->EndDeferredWrite();
+    }
+
+    // A crash between the writings of the dbs leaves the dbs at different blocks, so all the data is journaled
+    // before, and replayed by RecoverFlushJournal() at startup.
+    boost::filesystem::path pathJournal = pathFlushJournal;
+    asyncFlushResult = std::async(std::launch::async, [dbs, pathJournal]() {
+        RenameThread("coin-dbflush");
+        int64_t nStart = GetTimeMicros();
+        // the dbs are still written without the journal, for the readers waiting for the deferred data
+        bool fJournaled = WriteFlushJournal(pathJournal, dbs);
+        for (auto pDb : dbs) {
+            if (!pDb->WriteDeferred())
+                return false;
+        }
+        if (!fJournaled)
+            return false;
+
+        // a journal left behind would revert the later writings at startup
+        try {
+            boost::filesystem::remove(pathJournal);
+        } catch (const boost::filesystem::filesystem_error &e) {
+            return ERRORMSG("%s : Failed to remove file %s - %s", __func__, pathJournal.string(), e.what());
+        }
+
+        if (SysCfg().IsBenchmark())
+            LogPrint(BCLog::INFO, "- Write chain state: %.2fms\n", 0.001 * (GetTimeMicros() - nStart));
+        return true;
+    });
+
+    return true;
+}
+
+bool CCacheDBManager::WaitForAsyncFlush() {
+    if (!asyncFlushResult.valid())
+        return true;
+
+    return asyncFlushResult.get();
+}
+
+void CCacheDBManager::FlushCaches() {
     if (pSysParamCache) pSysParamCache->Flush();
 
     if (pAccountCache) pAccountCache->Flush();
@@ -264,6 +568,4 @@ bool CCacheDBManager::Flush() {
     //     pTxCache->Flush();
     // if (pPpCache)
     //     pPpCache->Flush();
-
-    return true;
 }
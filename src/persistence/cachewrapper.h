@@ -22,6 +22,8 @@
 #include "sysgoverndb.h"
 #include "logdb.h"
 
+#include <future>
+
 class CCacheDBManager;
 
 class CCacheWrapper {
@@ -42,7 +44,20 @@ public:
     CTxMemCache         txCache;
     CPricePointMemCache ppCache;
 public:
-    static std::shared_ptr<CCacheWrapper> NewCopyFrom(CCacheDBManager* pCdMan);
+    /**
+     * New a frozen copy of the chain state, which reads the data not cached from the snapshots of the dbs, see
+     * CDBAccess::NewSnapshot(). It is never changed, the readers on any thread read it through their own child
+     * cache wrapper.
+     */
+    static std::shared_ptr<CCacheWrapper> NewSnapshotFrom(CCacheDBManager* pCdMan);
+    /**
+     * New a frozen layer of the data cached by cw above the frozen chain state spBase, e.g. the data changed by a
+     * block above the chain state of its prev block. It costs a copy of the data cached by cw only.
+     */
+    static std::shared_ptr<CCacheWrapper> NewSnapshotLayer(const std::shared_ptr<CCacheWrapper> &spBase,
+                                                           CCacheWrapper &cw);
+    // New a child cache wrapper of the frozen chain state, which keeps the frozen chain state alive
+    static std::shared_ptr<CCacheWrapper> NewChildOf(const std::shared_ptr<CCacheWrapper> &spFrozen);
 public:
     CCacheWrapper();
 
@@ -51,17 +66,39 @@ public:
 
     CCacheWrapper& operator=(CCacheWrapper& other);
 
-    void CopyFrom(CCacheDBManager* pCdMan);
-
     void Flush();
 
     UndoDataFuncMap GetUndoDataFuncMap();
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap);
+
+    // record the db keys read or written through the db caches
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTracker);
+
+    // discard the cached data of the db keys from the db caches, they will be read from the base again
+    void DiscardData(const set<string> &dbKeys);
+
+    // Mark a savepoint. The data written after it is undone by RollbackToSavepoint(), or kept by
+    // ReleaseSavepoint(). It replaces a child cache wrapper when the writes of a tx may be thrown away,
+    // savepoints can not be nested.
+    void SetSavepoint();
+    bool RollbackToSavepoint();
+    void ReleaseSavepoint();
+private:
+    void SetCachesDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn);
+
 private:
     CCacheWrapper(const CCacheWrapper&) = delete;
     CCacheWrapper& operator=(const CCacheWrapper&) = delete;
 
+    CDBOpLogMap *pDbOpLogMap = nullptr;  // the op logs set by SetDbOpLogMap()
+    bool hasSavepoint        = false;
+    CDBOpLogMap savepointOpLogs;         // the old values of the data written since the savepoint
+    CPricePointMemCache savepointPpCache;
+
+    std::vector<std::shared_ptr<CDBAccess>> snapshotDbs;  // the db snapshots read by a frozen copy
+    std::shared_ptr<CCacheWrapper> spFrozenBase;            // the frozen base of a layer or a child
+
 };
 
 class CCacheDBManager {
@@ -117,6 +154,27 @@ public:
     ~CCacheDBManager();
 
     bool Flush();
+
+    // Flush the caches, and write the data to the dbs in a background thread. The flushed data is still
+    // readable through the dbs while being written.
+    bool AsyncFlush();
+
+    // Wait for the background writing of the last AsyncFlush(), return false if it failed.
+    bool WaitForAsyncFlush();
+
+    // Replay the flush journal left by a writing of the dbs interrupted by a crash, so the dbs are all at the best
+    // block again. It must be called before the dbs are read.
+    bool RecoverFlushJournal();
+
+private:
+    // the dbs of the chain state, the block db holding the best block hash is the last one
+    vector<CDBAccess *> GetStateDbs() const;
+    void FlushCaches();
+
+    // The data of all the dbs written by AsyncFlush() is saved to the journal in one file first, and the journal is
+    // removed after all the dbs are written.
+    boost::filesystem::path pathFlushJournal;
+    std::future<bool> asyncFlushResult;
 };  // CCacheDBManager
 
 #endif //PERSIST_CACHEWRAPPER_H
\ No newline at end of file
@@ -157,6 +157,22 @@ void CCdpDBCache::SetBaseViewPtr(CCdpDBCache *pBaseIn) {
     cdpRatioSortedCache.SetBase(&pBaseIn->cdpRatioSortedCache);
 }
 
+void CCdpDBCache::SetDbAccess(CDBAccess *pDbAccessIn) {
+    cdpGlobalDataCache.SetDbAccess(pDbAccessIn);
+    cdpCache.SetDbAccess(pDbAccessIn);
+    userCdpCache.SetDbAccess(pDbAccessIn);
+    cdpCoinPairsCache.SetDbAccess(pDbAccessIn);
+    cdpRatioSortedCache.SetDbAccess(pDbAccessIn);
+}
+
+void CCdpDBCache::SetFrozenBase(CCdpDBCache *pBaseIn) {
+    cdpGlobalDataCache.SetFrozenBase(&pBaseIn->cdpGlobalDataCache);
+    cdpCache.SetFrozenBase(&pBaseIn->cdpCache);
+    userCdpCache.SetFrozenBase(&pBaseIn->userCdpCache);
+    cdpCoinPairsCache.SetFrozenBase(&pBaseIn->cdpCoinPairsCache);
+    cdpRatioSortedCache.SetFrozenBase(&pBaseIn->cdpRatioSortedCache);
+}
+
 void CCdpDBCache::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
     cdpGlobalDataCache.SetDbOpLogMap(pDbOpLogMapIn);
     cdpCache.SetDbOpLogMap(pDbOpLogMapIn);
@@ -165,6 +181,22 @@ void CCdpDBCache::SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
     cdpRatioSortedCache.SetDbOpLogMap(pDbOpLogMapIn);
 }
 
+void CCdpDBCache::SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+    cdpGlobalDataCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    cdpCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    userCdpCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    cdpCoinPairsCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    cdpRatioSortedCache.SetDbKeyTracker(pDbKeyTrackerIn);
+}
+
+void CCdpDBCache::DiscardData(const set<string> &dbKeys) {
+    cdpGlobalDataCache.DiscardData(dbKeys);
+    cdpCache.DiscardData(dbKeys);
+    userCdpCache.DiscardData(dbKeys);
+    cdpCoinPairsCache.DiscardData(dbKeys);
+    cdpRatioSortedCache.DiscardData(dbKeys);
+}
+
 uint32_t CCdpDBCache::GetCacheSize() const {
     return cdpGlobalDataCache.GetCacheSize() + cdpCache.GetCacheSize() + userCdpCache.GetCacheSize() +
             cdpCoinPairsCache.GetCacheSize() + cdpRatioSortedCache.GetCacheSize();
@@ -52,7 +52,11 @@ public:
     map<CCdpCoinPair, CdpCoinPairStatus> GetCdpCoinPairMap();
 
     void SetBaseViewPtr(CCdpDBCache *pBaseIn);
+    void SetDbAccess(CDBAccess *pDbAccessIn);
+    void SetFrozenBase(CCdpDBCache *pBaseIn);
     void SetDbOpLogMap(CDBOpLogMap * pDbOpLogMapIn);
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn);
+    void DiscardData(const set<string> &dbKeys);
 
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         cdpGlobalDataCache.RegisterUndoFunc(undoDataFuncMap);
@@ -129,6 +133,16 @@ public:
         closedTxCdpCache.SetBase(&pBaseIn->closedTxCdpCache);
     }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        closedCdpTxCache.SetDbAccess(pDbAccessIn);
+        closedTxCdpCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CClosedCdpDBCache *pBaseIn) {
+        closedCdpTxCache.SetFrozenBase(&pBaseIn->closedCdpTxCache);
+        closedTxCdpCache.SetFrozenBase(&pBaseIn->closedTxCdpCache);
+    }
+
     void Flush() {
         closedCdpTxCache.Flush();
         closedTxCdpCache.Flush();
@@ -139,6 +153,16 @@ public:
         closedTxCdpCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        closedCdpTxCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        closedTxCdpCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        closedCdpTxCache.DiscardData(dbKeys);
+        closedTxCdpCache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         closedCdpTxCache.RegisterUndoFunc(undoDataFuncMap);
         closedTxCdpCache.RegisterUndoFunc(undoDataFuncMap);
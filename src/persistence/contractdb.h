@@ -105,6 +105,20 @@ public:
         contractTracesCache.SetBase(&pBaseIn->contractTracesCache);
     };
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        contractCache.SetDbAccess(pDbAccessIn);
+        contractDataCache.SetDbAccess(pDbAccessIn);
+        contractAccountCache.SetDbAccess(pDbAccessIn);
+        contractTracesCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CContractDBCache *pBaseIn) {
+        contractCache.SetFrozenBase(&pBaseIn->contractCache);
+        contractDataCache.SetFrozenBase(&pBaseIn->contractDataCache);
+        contractAccountCache.SetFrozenBase(&pBaseIn->contractAccountCache);
+        contractTracesCache.SetFrozenBase(&pBaseIn->contractTracesCache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         contractCache.SetDbOpLogMap(pDbOpLogMapIn);
         contractDataCache.SetDbOpLogMap(pDbOpLogMapIn);
@@ -112,6 +126,20 @@ public:
         contractTracesCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        contractCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        contractDataCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        contractAccountCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        contractTracesCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        contractCache.DiscardData(dbKeys);
+        contractDataCache.DiscardData(dbKeys);
+        contractAccountCache.DiscardData(dbKeys);
+        contractTracesCache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         contractCache.RegisterUndoFunc(undoDataFuncMap);
         contractDataCache.RegisterUndoFunc(undoDataFuncMap);
@@ -8,8 +8,12 @@
 
 #include "commons/uint256.h"
 #include "dbconf.h"
+#include "dbreadcache.h"
+#include "flathashmap.h"
 #include "leveldbwrapper.h"
 
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -264,23 +268,101 @@ namespace db_util {
 typedef void(UndoDataFunc)(const CDbOpLogs &pDbOpLogs);
 typedef std::map<dbk::PrefixType, std::function<UndoDataFunc>> UndoDataFuncMap;
 
+/**
+ * The data collected by a deferred write of a db, see CDBAccess::BeginDeferredWrite(). It is not changed once the
+ * collection ends, so the snapshots of the db taken before it is written share it.
+ */
+class CDbDeferredData {
+public:
+    map<string, string> puts;  // db key -> serialized value
+    set<string> erases;
+
+    // Wait for the data written, return the snapshot of the db right after the writing, or nullptr if it failed.
+    std::shared_ptr<const leveldb::Snapshot> WaitForWritten() const {
+        std::unique_lock<std::mutex> lock(cs_written);
+        cond_written.wait(lock, [this]() { return is_written; });
+        return pWrittenSnapshot;
+    }
+
+    void SetWritten(const std::shared_ptr<const leveldb::Snapshot> &pSnapshot) {
+        std::unique_lock<std::mutex> lock(cs_written);
+        pWrittenSnapshot = pSnapshot;
+        is_written       = true;
+        cond_written.notify_all();
+    }
+
+private:
+    mutable std::mutex cs_written;
+    mutable std::condition_variable cond_written;
+    bool is_written = false;
+    std::shared_ptr<const leveldb::Snapshot> pWrittenSnapshot;
+};
+
 class CDBAccess {
 public:
     CDBAccess(const boost::filesystem::path& dir, DBNameType dbNameTypeIn, bool fMemory, bool fWipe) :
               dbNameType(dbNameTypeIn),
-              db( dir / ::GetDbName(dbNameTypeIn), DBCacheSize[dbNameTypeIn], fMemory, fWipe ) {}
+              pDb(std::make_shared<CLevelDBWrapper>(dir / ::GetDbName(dbNameTypeIn), DBCacheSize[dbNameTypeIn],
+                                                    fMemory, fWipe)) {}
+
+    /**
+     * New a read only view of the db as of now, including the deferred data not written yet. It reads the leveldb
+     * snapshot, and has no read cache, so it can be read on any thread while the db is written. It is for the
+     * snapshot of the chain state, see CCacheWrapper::NewSnapshotFrom(), and must not be taken while collecting the
+     * deferred data.
+     */
+    std::shared_ptr<CDBAccess> NewSnapshot() const {
+        std::unique_lock<std::mutex> lock(cs_deferred);
+        assert(!is_deferring);
+        return std::shared_ptr<CDBAccess>(new CDBAccess(*this, NewDbSnapshot()));
+    }
+
+    bool IsSnapshot() const { return pSnapshot != nullptr; }
+
+    int64_t GetDbCount() const {
+        assert(!IsSnapshot());
+        WaitForDeferredWrite();
+        return pDb->GetDbCount();
+    }
+
+    // Set the memory budgets of the read cache for the key prefixes of the db by their shares of the size.
+    void SetReadCacheSize(uint64_t size) {
+        for (int32_t i = dbk::EMPTY + 1; i < dbk::PREFIX_COUNT; i++) {
+            dbk::PrefixType prefixType = (dbk::PrefixType)i;
+            if (dbk::GetDbNameEnumByPrefix(prefixType) == dbNameType)
+                readCache.SetBudget(prefixType, size * GetDbReadCacheShare(prefixType) / 1000);
+        }
+    }
+
+    CDbReadCache::PrefixStats GetReadCacheStats(dbk::PrefixType prefixType) const {
+        return readCache.GetStats(prefixType);
+    }
 
-    int64_t GetDbCount() const { return db.GetDbCount(); }
     template<typename KeyType, typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, const KeyType &key, ValueType &value) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Read(keyStr, value);
+        if (readCache.Get(prefixType, keyStr, value))
+            return true;
+
+        if (!ReadData(keyStr, value))
+            return false;
+
+        readCache.Put(prefixType, keyStr, value);
+        return true;
+    }
+
+    // Read the data without filling the read cache, for the readers on other threads than the one writing the db,
+    // which must not put a value older than the one written meanwhile into the read cache.
+    template<typename KeyType, typename ValueType>
+    bool PeekData(const dbk::PrefixType prefixType, const KeyType &key, ValueType &value) const {
+        string keyStr = dbk::GenDbKey(prefixType, key);
+        return readCache.Get(prefixType, keyStr, value) || ReadData(keyStr, value);
     }
 
     template<typename ValueType>
     bool GetData(const dbk::PrefixType prefixType, ValueType &value) const {
         const string prefix = dbk::GetKeyPrefix(prefixType);
-        return db.Read(prefix, value);
+        return ReadData(prefix, value);
     }
 
     template <typename KeyType>
@@ -447,55 +529,316 @@ public:
     template<typename KeyType, typename ValueType>
     bool HaveData(const dbk::PrefixType prefixType, const KeyType &key) const {
         string keyStr = dbk::GenDbKey(prefixType, key);
-        return db.Exists(keyStr);
-    }
+        {
+            std::unique_lock<std::mutex> lock(cs_deferred);
+            if (pDeferred) {
+                if (pDeferred->puts.count(keyStr))
+                    return true;
+                if (pDeferred->erases.count(keyStr))
+                    return false;
+            }
+        }
+        return pDb->Exists(keyStr, pSnapshot.get());
+    }
+
+    template<typename KeyType, typename ValueType, typename MapType = map<KeyType, ValueType>>
+    void BatchWrite(const dbk::PrefixType prefixType, const MapType &mapData) {
+        assert(!IsSnapshot());
+        if (is_deferring) {
+            std::unique_lock<std::mutex> lock(cs_deferred);
+            for (const auto &item : mapData) {
+                string key = dbk::GenDbKey(prefixType, item.first);
+                UpdateReadCache(prefixType, key, item.second);
+                AddDeferredData(key, item.second);
+            }
+            return;
+        }
 
-    template<typename KeyType, typename ValueType>
-    void BatchWrite(const dbk::PrefixType prefixType, const map<KeyType, ValueType> &mapData) {
+        WaitForDeferredWrite();
         CLevelDBBatch batch;
         for (auto item : mapData) {
             string key = dbk::GenDbKey(prefixType, item.first);
+            UpdateReadCache(prefixType, key, item.second);
             if (db_util::IsEmpty(item.second)) {
                 batch.Erase(key);
             } else {
                 batch.Write(key, item.second);
             }
         }
-        db.WriteBatch(batch, true);
+        pDb->WriteBatch(batch, true);
     }
 
     template<typename ValueType>
     void BatchWrite(const dbk::PrefixType prefixType, ValueType &value) {
-        CLevelDBBatch batch;
+        assert(!IsSnapshot());
         const string prefix = dbk::GetKeyPrefix(prefixType);
+        if (is_deferring) {
+            std::unique_lock<std::mutex> lock(cs_deferred);
+            AddDeferredData(prefix, value);
+            return;
+        }
 
+        WaitForDeferredWrite();
+        CLevelDBBatch batch;
         if (db_util::IsEmpty(value)) {
             batch.Erase(prefix);
         } else {
             batch.Write(prefix, value);
         }
-        db.WriteBatch(batch, true);
+        pDb->WriteBatch(batch, true);
+    }
+
+    /**
+     * Deferred write. Between BeginDeferredWrite() and EndDeferredWrite(), BatchWrite() only collects the
+     * data in memory, and WriteDeferred() writes them in one synced batch later, usually in a background
+     * thread. The collected data is readable by GetData() and HaveData() until written, and the iterators
+     * wait for the writing, so the readers always see the latest data.
+     */
+    void BeginDeferredWrite() {
+        WaitForDeferredWrite();
+        std::unique_lock<std::mutex> lock(cs_deferred);
+        is_deferring = true;
+    }
+
+    void EndDeferredWrite() {
+        std::unique_lock<std::mutex> lock(cs_deferred);
+        is_deferring = false;
+    }
+
+    bool WriteDeferred() {
+        std::shared_ptr<CDbDeferredData> pData;
+        {
+            std::unique_lock<std::mutex> lock(cs_deferred);
+            if (!pDeferred)
+                return true;
+
+            // the deferred data is not changed until written, it is safe to read it without lock
+            pData = pDeferred;
+        }
+
+        CLevelDBBatch batch;
+        for (const auto &item : pData->puts) {
+            batch.WriteSerialized(item.first, item.second);
+        }
+        for (const auto &key : pData->erases) {
+            batch.Erase(key);
+        }
+
+        try {
+            pDb->WriteBatch(batch, true);
+        } catch (std::exception &e) {
+            pData->SetWritten(nullptr);
+            std::unique_lock<std::mutex> lock(cs_deferred);
+            is_deferred_failed = true;
+            cond_deferred.notify_all();
+            return ERRORMSG("%s : write deferred data of db %s error - %s", __FUNCTION__,
+                            ::GetDbName(dbNameType), e.what());
+        }
+
+        // nothing else writes the db until the deferred data is cleared, the snapshots sharing the data iterate it
+        pData->SetWritten(NewDbSnapshot());
+
+        std::unique_lock<std::mutex> lock(cs_deferred);
+        pDeferred = nullptr;
+        cond_deferred.notify_all();
+        return true;
+    }
+
+    // The deferred data collected, nullptr if none. It is not changed until written.
+    std::shared_ptr<const CDbDeferredData> GetDeferredData() const {
+        std::unique_lock<std::mutex> lock(cs_deferred);
+        return pDeferred;
+    }
+
+    // Write the serialized data in one synced batch, bypassing the read cache. It is for replaying the flush journal
+    // at startup, before the db is read.
+    void WriteSerializedBatch(const map<string, string> &puts, const set<string> &erases) {
+        WaitForDeferredWrite();
+        CLevelDBBatch batch;
+        for (const auto &item : puts) {
+            batch.WriteSerialized(item.first, item.second);
+        }
+        for (const auto &key : erases) {
+            batch.Erase(key);
+        }
+        pDb->WriteBatch(batch, true);
+    }
+
+    void WaitForDeferredWrite() const {
+        std::unique_lock<std::mutex> lock(cs_deferred);
+        cond_deferred.wait(lock, [this]() { return !pDeferred || is_deferring || is_deferred_failed; });
     }
 
     DBNameType GetDbNameType() const { return dbNameType; }
 
     std::shared_ptr<leveldb::Iterator> NewIterator() {
-        return std::shared_ptr<leveldb::Iterator>(db.NewIterator());
+        if (IsSnapshot()) {
+            if (!pDeferred)
+                return std::shared_ptr<leveldb::Iterator>(pDb->NewIterator(pSnapshot.get()));
+
+            // the db with the deferred data written is the same as the snapshot, it is iterated instead of merging
+            // the deferred data into the iterator
+            auto pWrittenSnapshot = pDeferred->WaitForWritten();
+            if (!pWrittenSnapshot)
+                return std::shared_ptr<leveldb::Iterator>(leveldb::NewErrorIterator(
+                    leveldb::Status::IOError("write deferred data of db failed", ::GetDbName(dbNameType))));
+
+            return std::shared_ptr<leveldb::Iterator>(pDb->NewIterator(pWrittenSnapshot.get()));
+        }
+
+        WaitForDeferredWrite();
+        return std::shared_ptr<leveldb::Iterator>(pDb->NewIterator());
     }
+private:
+    // the snapshot view of the db, see NewSnapshot()
+    CDBAccess(const CDBAccess &other, const std::shared_ptr<const leveldb::Snapshot> &pSnapshotIn)
+        : dbNameType(other.dbNameType), pDb(other.pDb), pSnapshot(pSnapshotIn), pDeferred(other.pDeferred) {}
+
+    std::shared_ptr<const leveldb::Snapshot> NewDbSnapshot() const {
+        std::shared_ptr<CLevelDBWrapper> pSnapshotDb = pDb;
+        return std::shared_ptr<const leveldb::Snapshot>(
+            pSnapshotDb->GetSnapshot(),
+            [pSnapshotDb](const leveldb::Snapshot *pSnapshotIn) { pSnapshotDb->ReleaseSnapshot(pSnapshotIn); });
+    }
+
+    template<typename ValueType>
+    bool ReadData(const string &keyStr, ValueType &value) const {
+        {
+            std::unique_lock<std::mutex> lock(cs_deferred);
+            if (pDeferred) {
+                auto it = pDeferred->puts.find(keyStr);
+                if (it != pDeferred->puts.end()) {
+                    try {
+                        CDataStream ssValue(it->second.data(), it->second.data() + it->second.size(), SER_DISK, CLIENT_VERSION);
+                        ssValue >> value;
+                    } catch(std::exception &e) {
+                        return false;
+                    }
+                    return true;
+                }
+
+                if (pDeferred->erases.count(keyStr))
+                    return false;
+            }
+        }
+        return pDb->Read(keyStr, value, pSnapshot.get());
+    }
+
+    template<typename ValueType>
+    void UpdateReadCache(const dbk::PrefixType prefixType, const string &keyStr, const ValueType &value) {
+        if (db_util::IsEmpty(value))
+            readCache.Erase(prefixType, keyStr);
+        else
+            readCache.Put(prefixType, keyStr, value);
+    }
+
+    // must hold cs_deferred
+    template<typename ValueType>
+    void AddDeferredData(const string &keyStr, const ValueType &value) {
+        if (!pDeferred)
+            pDeferred = std::make_shared<CDbDeferredData>();
+
+        if (db_util::IsEmpty(value)) {
+            pDeferred->puts.erase(keyStr);
+            pDeferred->erases.insert(keyStr);
+        } else {
+            CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+            ssValue << value;
+            pDeferred->puts[keyStr] = ssValue.str();
+            pDeferred->erases.erase(keyStr);
+        }
+    }
+
 private:
     DBNameType dbNameType;
-    mutable CLevelDBWrapper db; // // TODO: remove the mutable declare
+    std::shared_ptr<CLevelDBWrapper> pDb;
+    std::shared_ptr<const leveldb::Snapshot> pSnapshot;  // only the snapshot view has it
+
+    mutable std::mutex cs_deferred;
+    mutable std::condition_variable cond_deferred;
+    bool is_deferring       = false;
+    bool is_deferred_failed = false;
+    std::shared_ptr<CDbDeferredData> pDeferred;  // the deferred data not written yet
+
+    mutable CDbReadCache readCache;
 };
 
-template<int32_t PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType>
+/**
+ * The negative cache of a db level cache, it keeps the keys known to be missing in the db, so that the repeated
+ * lookups of them need not to read the db. It is bounded by DB_CACHE_MAX_MISSING_KEYS and is cleared when full.
+ * A copy starts empty, because the copied cache may be not the one which writes the db later.
+ * The parallel tx executions look up the same db level cache at once, so the keys are guarded by a lock.
+ */
+template<typename KeyType>
+class CDbMissingKeys {
+public:
+    CDbMissingKeys() {}
+    CDbMissingKeys(const CDbMissingKeys &other) {}
+
+    CDbMissingKeys &operator=(const CDbMissingKeys &other) {
+        std::lock_guard<std::mutex> lock(cs_keys);
+        keys.clear();
+        return *this;
+    }
+
+    // lookup the key which is not in the cache data
+    bool IsMissing(const KeyType &key) const {
+        std::lock_guard<std::mutex> lock(cs_keys);
+        if (keys.count(key) > 0) {
+            ++hits;
+            return true;
+        }
+        return false;
+    }
+
+    // the lookup of the key read db and found nothing
+    void AddMissed(const KeyType &key) const {
+        ++misses;
+        SetMissing(key, true);
+    }
+
+    void SetMissing(const KeyType &key, bool isMissing) const {
+        std::lock_guard<std::mutex> lock(cs_keys);
+        if (!isMissing) {
+            keys.erase(key);
+            return;
+        }
+
+        if (keys.size() >= DB_CACHE_MAX_MISSING_KEYS)
+            keys.clear();
+        keys.insert(key);
+    }
+
+    uint64_t GetHits() const { return hits; }
+    uint64_t GetMisses() const { return misses; }
+    size_t GetKeyCount() const {
+        std::lock_guard<std::mutex> lock(cs_keys);
+        return keys.size();
+    }
+
+private:
+    mutable std::mutex cs_keys;
+    mutable set<KeyType> keys;
+    mutable std::atomic<uint64_t> hits{0};    // lookups answered by the missing keys
+    mutable std::atomic<uint64_t> misses{0};  // lookups which read the db and found nothing
+};
+
+/**
+ * The storage of the cached data is std::map by default. A cache which never iterates its data in key order can use
+ * CFlatHashMap instead, see CHashKVCache.
+ */
+template<int32_t PREFIX_TYPE_VALUE, typename __KeyType, typename __ValueType,
+         typename __MapType = std::map<__KeyType, __ValueType>>
 class CCompositeKVCache {
 public:
     static const dbk::PrefixType PREFIX_TYPE = (dbk::PrefixType)PREFIX_TYPE_VALUE;
 public:
     typedef __KeyType   KeyType;
     typedef __ValueType ValueType;
-    typedef typename std::map<KeyType, ValueType> Map;
-    typedef typename std::map<KeyType, ValueType>::iterator Iterator;
+    typedef __MapType   Map;
+    typedef typename Map::iterator Iterator;
+
+    static const bool IS_ORDERED = !IsFlatHashMap<Map>::value;
 
 public:
     /**
@@ -520,10 +863,55 @@ public:
         pBase = pBaseIn;
     };
 
+    // Read the data not cached from another view of the same db, e.g. its snapshot
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        assert(pBase == nullptr && pDbAccessIn != nullptr);
+        assert(pDbAccessIn->GetDbNameType() == GetDbNameEnumByPrefix(PREFIX_TYPE));
+        pDbAccess = pDbAccessIn;
+        is_frozen = pDbAccessIn->IsSnapshot();
+    }
+
+    // Freeze the cached data above a frozen base, e.g. the data of a block above the chain state of its prev block
+    void SetFrozenBase(CCompositeKVCache *pBaseIn) {
+        assert(pBaseIn != nullptr && pBaseIn->IsFrozen());
+        pBase         = pBaseIn;
+        pDbAccess     = nullptr;
+        pDbOpLogMap   = nullptr;
+        pDbKeyTracker = nullptr;
+        is_frozen     = true;
+    }
+
+    /**
+     * A frozen cache is a copy of the chain state read by many threads at once, i.e. a db level cache reading a db
+     * snapshot or a cache set by SetFrozenBase(). It never caches the data read, its child caches read it by
+     * PeekData() and cache the data themselves.
+     */
+    bool IsFrozen() const { return is_frozen; }
+
+    // Read the data of a frozen cache without caching it, the empty value of an erased key is found as well
+    bool PeekData(const KeyType &key, ValueType &value) const {
+        auto it = mapData.find(key);
+        if (it != mapData.end()) {
+            value = it->second;
+            return true;
+        }
+
+        if (pBase != nullptr)
+            return pBase->PeekData(key, value);
+        else if (pDbAccess != nullptr)
+            return pDbAccess->GetData(PREFIX_TYPE, key, value);
+
+        return false;
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         pDbOpLogMap = pDbOpLogMapIn;
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        pDbKeyTracker = pDbKeyTrackerIn;
+    }
+
     bool IsCalcSize() const { return is_calc_size; }
 
     uint32_t GetCacheSize() const {
@@ -531,6 +919,7 @@ public:
     }
 
     bool GetTopNElements(const uint32_t maxNum, set<KeyType> &keys) {
+        TrackRangeRead();
         // 1. Get all candidate elements.
         set<KeyType> expiredKeys;
         set<KeyType> candidateKeys;
@@ -553,6 +942,7 @@ public:
 
     // map<string, ValueType>
     bool GetAllElements(const KeyType &endKey, Map &elements) {
+        TrackRangeRead();
         set<KeyType> expiredKeys;
         if (!GetAllElements(endKey, elements, expiredKeys)) {
             // TODO: log
@@ -563,6 +953,7 @@ public:
     }
 
     bool GetAllElements(map<KeyType, ValueType> &elements) {
+        TrackRangeRead();
         set<KeyType> expiredKeys;
         if (!GetAllElements(expiredKeys, elements)) {
             // TODO: log
@@ -589,6 +980,7 @@ public:
             return false;
         }
         auto it = GetDataIt(key);
+        TrackWrite(key);
         if (it == mapData.end()) {
             auto pEmptyValue = db_util::MakeEmptyValue<ValueType>();
             AddOpLog(key, *pEmptyValue, &value);
@@ -615,6 +1007,7 @@ public:
         }
         Iterator it = GetDataIt(key);
         if (it != mapData.end() && !db_util::IsEmpty(it->second)) {
+            TrackWrite(key);
             DecDataSize(it->second);
             AddOpLog(key, it->second, nullptr);
             db_util::SetEmpty(it->second);
@@ -634,15 +1027,37 @@ public:
             assert(pDbAccess == nullptr);
             for (auto it : mapData) {
                 pBase->mapData[it.first] = it.second;
+                pBase->TrackWrite(it.first);
             }
         } else if (pDbAccess != nullptr) {
             assert(pBase == nullptr);
-            pDbAccess->BatchWrite<KeyType, ValueType>(PREFIX_TYPE, mapData);
+            pDbAccess->BatchWrite<KeyType, ValueType, Map>(PREFIX_TYPE, mapData);
+            // the empty value is erased from db
+            for (const auto &item : mapData) {
+                missingKeys.SetMissing(item.first, db_util::IsEmpty(item.second));
+            }
         }
 
         Clear();
     }
 
+    // Discard the cached data of the db keys, they will be read from the base again.
+    void DiscardData(const set<string> &dbKeys) {
+        const string &prefix = dbk::GetKeyPrefix(PREFIX_TYPE);
+        for (auto it = dbKeys.lower_bound(prefix); it != dbKeys.end() && it->compare(0, prefix.size(), prefix) == 0;
+             ++it) {
+            KeyType key;
+            if (it->size() == prefix.size() || !dbk::ParseDbKey(*it, PREFIX_TYPE, key))
+                continue;
+
+            auto dataIt = mapData.find(key);
+            if (dataIt != mapData.end()) {
+                DecDataSize(dataIt->first, dataIt->second);
+                mapData.erase(dataIt);
+            }
+        }
+    }
+
     void UndoData(const CDbOpLog &dbOpLog) {
         KeyType key;
         ValueType value;
@@ -676,15 +1091,35 @@ public:
         return pRet;
     }
 
-    CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType>* GetBasePtr() { return pBase; }
+    CCompositeKVCache* GetBasePtr() { return pBase; }
 
-    map<KeyType, ValueType>& GetMapData() { return mapData; };
+    Map& GetMapData() {
+        TrackRangeRead();
+        return mapData;
+    };
+
+    // only the db level cache has missing keys, see CDbMissingKeys
+    const CDbMissingKeys<KeyType>& GetMissingKeys() const { return missingKeys; }
 private:
     Iterator GetDataIt(const KeyType &key) const {
         Iterator it = mapData.find(key);
         if (it != mapData.end()) {
             return it;
-        } else if (pBase != nullptr) {
+        }
+
+        if (pDbKeyTracker != nullptr)
+            pDbKeyTracker->AddAccessedKey(dbk::GenDbKey(PREFIX_TYPE, key));
+
+        assert(!IsFrozen() && "the frozen cache must be read through a child cache");
+        if (pBase != nullptr) {
+            if (pBase->IsFrozen()) {
+                auto pBaseValue = db_util::MakeEmptyValue<ValueType>();
+                if (pBase->PeekData(key, *pBaseValue))
+                    return AddDataToMap(key, *pBaseValue);
+
+                return mapData.end();
+            }
+
             // find key-value at base cache
             auto baseIt = pBase->GetDataIt(key);
             if (baseIt != pBase->mapData.end()) {
@@ -692,11 +1127,15 @@ private:
                 return AddDataToMap(key, baseIt->second);
             }
         } else if (pDbAccess != NULL) {
-            // TODO: need to save the empty value to mapData for search performance?
+            // the missing keys are only valid while the key is not in mapData, the Flush() keeps them up to date
+            if (missingKeys.IsMissing(key))
+                return mapData.end();
+
             auto pDbValue = db_util::MakeEmptyValue<ValueType>();
             if (pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue)) {
                 return AddDataToMap(key, *pDbValue);
             }
+            missingKeys.AddMissed(key);
         }
 
         return mapData.end();
@@ -729,6 +1168,13 @@ private:
         }
     }
 
+    inline void DecDataSize(const KeyType &keyIn, const ValueType &valueIn) const {
+        if (is_calc_size) {
+            uint32_t sz = CalcDataSize(keyIn) + CalcDataSize(valueIn);
+            size = size > sz ? size - sz : 0;
+        }
+    }
+
     inline void UpdateDataSize(const ValueType &oldValue, const ValueType &newVvalue) const {
         if (is_calc_size) {
             size += CalcDataSize(newVvalue);
@@ -820,7 +1266,7 @@ private:
 
     inline void AddOpLog(const KeyType &key, const ValueType& oldValue, const ValueType *pNewValue) {
         if (pDbOpLogMap != nullptr) {
-            CDbOpLog dbOpLog;
+            CDbOpLog &dbOpLog = pDbOpLogMap->NewOpLog(PREFIX_TYPE);
             #ifdef DB_OP_LOG_NEW_VALUE
                 if (pNewValue != nullptr)
                     dbOpLog.Set(key, make_pair(oldValue, *pNewValue));
@@ -829,20 +1275,36 @@ private:
             #else
                 dbOpLog.Set(key, oldValue);
             #endif
-            pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
         }
 
     }
+
+    inline void TrackWrite(const KeyType &key) {
+        if (pDbKeyTracker != nullptr)
+            pDbKeyTracker->AddWrittenKey(dbk::GenDbKey(PREFIX_TYPE, key));
+    }
+
+    inline void TrackRangeRead() {
+        if (pDbKeyTracker != nullptr)
+            pDbKeyTracker->AddAccessedKey(dbk::GetKeyPrefix(PREFIX_TYPE));
+    }
 private:
-    mutable CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> *pBase = nullptr;
+    mutable CCompositeKVCache *pBase = nullptr;
     CDBAccess *pDbAccess = nullptr;
-    mutable map<KeyType, ValueType> mapData;
+    mutable Map mapData;
+    CDbMissingKeys<KeyType> missingKeys;
     CDBOpLogMap *pDbOpLogMap = nullptr;
+    CDBKeyTracker *pDbKeyTracker = nullptr;
     bool is_calc_size = false;
+    bool is_frozen = false;
     mutable uint32_t size = 0;
 };
 
 
+// The cache of a prefix whose keys are uniformly random hashes, and which needs no ordered iteration.
+template<int32_t PREFIX_TYPE_VALUE, typename KeyType, typename ValueType>
+using CHashKVCache = CCompositeKVCache<PREFIX_TYPE_VALUE, KeyType, ValueType, CFlatHashMap<KeyType, ValueType, CBlobHasher>>;
+
 template<int32_t PREFIX_TYPE_VALUE, typename __ValueType>
 class CSimpleKVCache {
 public:
@@ -878,6 +1340,8 @@ public:
             ptrData = make_shared<ValueType>(*other.ptrData);
         }
         pDbOpLogMap = other.pDbOpLogMap;
+        pDbKeyTracker = other.pDbKeyTracker;
+        is_frozen = other.is_frozen;
         return *this;
     }
 
@@ -887,10 +1351,49 @@ public:
         pBase = pBaseIn;
     }
 
+    // see CCompositeKVCache::SetDbAccess()
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        assert(pBase == nullptr && pDbAccessIn != nullptr);
+        pDbAccess = pDbAccessIn;
+        is_frozen = pDbAccessIn->IsSnapshot();
+    }
+
+    // see CCompositeKVCache::SetFrozenBase()
+    void SetFrozenBase(CSimpleKVCache *pBaseIn) {
+        assert(pBaseIn != nullptr && pBaseIn->IsFrozen());
+        pBase         = pBaseIn;
+        pDbAccess     = nullptr;
+        pDbOpLogMap   = nullptr;
+        pDbKeyTracker = nullptr;
+        is_frozen     = true;
+    }
+
+    // see CCompositeKVCache::IsFrozen()
+    bool IsFrozen() const { return is_frozen; }
+
+    // Read the data of a frozen cache without caching it
+    std::shared_ptr<ValueType> PeekDataPtr() const {
+        if (ptrData)
+            return ptrData;
+
+        if (pBase != nullptr) {
+            return pBase->PeekDataPtr();
+        } else if (pDbAccess != nullptr) {
+            auto ptrDbData = db_util::MakeEmptyValue<ValueType>();
+            if (pDbAccess->GetData(PREFIX_TYPE, *ptrDbData))
+                return ptrDbData;
+        }
+        return nullptr;
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         pDbOpLogMap = pDbOpLogMapIn;
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        pDbKeyTracker = pDbKeyTrackerIn;
+    }
+
     uint32_t GetCacheSize() const {
         if (!ptrData) {
             return 0;
@@ -912,6 +1415,7 @@ public:
         if (!ptrData) {
             ptrData = db_util::MakeEmptyValue<ValueType>();
         }
+        TrackWrite();
         AddOpLog(*ptrData);
         *ptrData = value;
         return true;
@@ -925,6 +1429,7 @@ public:
     bool EraseData() {
         auto ptr = GetDataPtr();
         if (ptr && !db_util::IsEmpty(*ptr)) {
+            TrackWrite();
             AddOpLog(*ptr);
             db_util::SetEmpty(*ptr);
         }
@@ -941,6 +1446,7 @@ public:
             if (pBase != nullptr) {
                 assert(pDbAccess == nullptr);
                 pBase->ptrData = ptrData;
+                pBase->TrackWrite();
             } else if (pDbAccess != nullptr) {
                 assert(pBase == nullptr);
                 pDbAccess->BatchWrite(PREFIX_TYPE, *ptrData);
@@ -956,6 +1462,12 @@ public:
         dbOpLog.Get(*ptrData);
     }
 
+    // Discard the cached data if the db keys contain it, it will be read from the base again.
+    void DiscardData(const set<string> &dbKeys) {
+        if (dbKeys.count(dbk::GetKeyPrefix(PREFIX_TYPE)))
+            ptrData = nullptr;
+    }
+
     void UndoDataList(const CDbOpLogs &dbOpLogs) {
         for (auto it = dbOpLogs.rbegin(); it != dbOpLogs.rend(); it++) {
             UndoData(*it);
@@ -972,8 +1484,14 @@ public:
 
         if (ptrData) {
             return ptrData;
-        } else if (pBase != nullptr){
-            auto ptr = pBase->GetDataPtr();
+        }
+
+        if (pDbKeyTracker != nullptr)
+            pDbKeyTracker->AddAccessedKey(dbk::GetKeyPrefix(PREFIX_TYPE));
+
+        assert(!IsFrozen() && "the frozen cache must be read through a child cache");
+        if (pBase != nullptr){
+            auto ptr = pBase->IsFrozen() ? pBase->PeekDataPtr() : pBase->GetDataPtr();
             if (ptr) {
                 ptrData = std::make_shared<ValueType>(*ptr);
                 return ptrData;
@@ -993,17 +1511,22 @@ public:
 private:
     inline void AddOpLog(const ValueType &oldValue) {
         if (pDbOpLogMap != nullptr) {
-            CDbOpLog dbOpLog;
-            dbOpLog.Set(oldValue);
-            pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+            pDbOpLogMap->NewOpLog(PREFIX_TYPE).Set(oldValue);
         }
 
     }
+
+    inline void TrackWrite() {
+        if (pDbKeyTracker != nullptr)
+            pDbKeyTracker->AddWrittenKey(dbk::GetKeyPrefix(PREFIX_TYPE));
+    }
 private:
     mutable CSimpleKVCache<PREFIX_TYPE, ValueType> *pBase;
     CDBAccess *pDbAccess;
     mutable std::shared_ptr<ValueType> ptrData = nullptr;
     CDBOpLogMap *pDbOpLogMap                   = nullptr;
+    CDBKeyTracker *pDbKeyTracker               = nullptr;
+    bool is_frozen                             = false;
 };
 
 #endif  // PERSIST_DB_ACCESS_H
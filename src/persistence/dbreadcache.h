@@ -0,0 +1,175 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_DBREADCACHE_H
+#define PERSIST_DBREADCACHE_H
+
+#include "dbconf.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+
+/**
+ * The share (in permille) of -dbreadcache for the data of the key prefix. The hot data read by the txs, e.g. the
+ * accounts, contract data and cdps, gets the most, the single value data is kept by the db caches and needs none.
+ */
+inline uint32_t GetDbReadCacheShare(dbk::PrefixType prefixType) {
+    switch (prefixType) {
+        case dbk::KEYID_ACCOUNT:    return 300;
+        case dbk::REGID_KEYID:      return 50;
+        case dbk::NICKID_KEYID:     return 10;
+        case dbk::CONTRACT_DEF:     return 100;
+        case dbk::CONTRACT_DATA:    return 200;
+        case dbk::CONTRACT_ACCOUNT: return 50;
+        case dbk::CDP:              return 100;
+        case dbk::USER_CDP:         return 50;
+        case dbk::DEX_ACTIVE_ORDER: return 50;
+        case dbk::ASSET:            return 10;
+        case dbk::TXID_DISKINDEX:   return 20;
+        case dbk::TX_RECEIPT:       return 10;
+        case dbk::TX_UTXO:          return 10;
+        default:                    return 0;
+    }
+}
+
+/**
+ * The LRU cache of the deserialized values read from or written to a db, so that the hot data stays decoded after
+ * the db caches are flushed. Each key prefix has its own memory budget, the size of an entry is approximated by
+ * its serialized size. A budget of 0 disables the cache of the prefix.
+ */
+class CDbReadCache {
+public:
+    struct PrefixStats {
+        uint64_t budget = 0;
+        uint64_t size   = 0;
+        uint64_t count  = 0;
+        uint64_t hits   = 0;
+        uint64_t misses = 0;
+    };
+
+public:
+    CDbReadCache() {}
+
+    void SetBudget(dbk::PrefixType prefixType, uint64_t budget) {
+        std::unique_lock<std::mutex> lock(cs_cache);
+        PrefixLru &lru = lrus[prefixType];
+        lru.budget     = budget;
+        Evict(lru);
+    }
+
+    template<typename ValueType>
+    bool Get(dbk::PrefixType prefixType, const std::string &keyStr, ValueType &value) const {
+        PrefixLru &lru = lrus[prefixType];
+        if (lru.budget == 0)
+            return false;
+
+        std::unique_lock<std::mutex> lock(cs_cache);
+        auto it = entries.find(keyStr);
+        if (it == entries.end() || *it->second.pType != typeid(ValueType)) {
+            ++lru.misses;
+            return false;
+        }
+
+        ++lru.hits;
+        lru.keys.splice(lru.keys.begin(), lru.keys, it->second.lruIt);
+        value = *std::static_pointer_cast<const ValueType>(it->second.pValue);
+        return true;
+    }
+
+    template<typename ValueType>
+    void Put(dbk::PrefixType prefixType, const std::string &keyStr, const ValueType &value) {
+        PrefixLru &lru = lrus[prefixType];
+        if (lru.budget == 0)
+            return;
+
+        uint64_t entrySize = ENTRY_OVERHEAD + keyStr.size() + ::GetSerializeSize(value, SER_DISK, CLIENT_VERSION);
+        std::shared_ptr<const void> pValue = std::make_shared<const ValueType>(value);
+
+        std::unique_lock<std::mutex> lock(cs_cache);
+        EraseEntry(keyStr);
+        if (entrySize > lru.budget)
+            return;
+
+        auto ret = entries.emplace(keyStr, Entry());
+        Entry &entry     = ret.first->second;
+        entry.pValue     = pValue;
+        entry.pType      = &typeid(ValueType);
+        entry.size       = entrySize;
+        entry.prefixType = prefixType;
+        lru.keys.push_front(&ret.first->first);
+        entry.lruIt = lru.keys.begin();
+        lru.size += entrySize;
+        Evict(lru);
+    }
+
+    void Erase(dbk::PrefixType prefixType, const std::string &keyStr) {
+        if (lrus[prefixType].budget == 0)
+            return;
+
+        std::unique_lock<std::mutex> lock(cs_cache);
+        EraseEntry(keyStr);
+    }
+
+    PrefixStats GetStats(dbk::PrefixType prefixType) const {
+        std::unique_lock<std::mutex> lock(cs_cache);
+        const PrefixLru &lru = lrus[prefixType];
+        PrefixStats stats;
+        stats.budget = lru.budget;
+        stats.size   = lru.size;
+        stats.count  = lru.keys.size();
+        stats.hits   = lru.hits;
+        stats.misses = lru.misses;
+        return stats;
+    }
+
+private:
+    // the memory used by an entry besides its key and value, approximately
+    static const uint32_t ENTRY_OVERHEAD = 96;
+
+    struct Entry {
+        std::shared_ptr<const void> pValue;
+        const std::type_info *pType = nullptr;
+        uint32_t size = 0;
+        dbk::PrefixType prefixType = dbk::EMPTY;
+        std::list<const std::string *>::iterator lruIt;
+    };
+
+    struct PrefixLru {
+        std::list<const std::string *> keys;  // the most recently used key is at the front
+        uint64_t budget = 0;
+        uint64_t size   = 0;
+        uint64_t hits   = 0;
+        uint64_t misses = 0;
+    };
+
+    // must hold cs_cache
+    void EraseEntry(const std::string &keyStr) {
+        auto it = entries.find(keyStr);
+        if (it == entries.end())
+            return;
+
+        PrefixLru &lru = lrus[it->second.prefixType];
+        lru.size -= it->second.size;
+        lru.keys.erase(it->second.lruIt);
+        entries.erase(it);
+    }
+
+    // must hold cs_cache
+    void Evict(PrefixLru &lru) {
+        while (lru.size > lru.budget && !lru.keys.empty()) {
+            EraseEntry(*lru.keys.back());
+        }
+    }
+
+private:
+    mutable std::mutex cs_cache;
+    std::unordered_map<std::string, Entry> entries;  // db key -> entry
+    mutable PrefixLru lrus[dbk::PREFIX_COUNT + 1];
+};
+
+#endif  // PERSIST_DBREADCACHE_H
@@ -71,6 +71,22 @@ public:
         active_delegates_cache.SetBase(&pBaseIn->active_delegates_cache);
     }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        voteRegIdCache.SetDbAccess(pDbAccessIn);
+        regId2VoteCache.SetDbAccess(pDbAccessIn);
+        last_vote_height_cache.SetDbAccess(pDbAccessIn);
+        pending_delegates_cache.SetDbAccess(pDbAccessIn);
+        active_delegates_cache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CDelegateDBCache *pBaseIn) {
+        voteRegIdCache.SetFrozenBase(&pBaseIn->voteRegIdCache);
+        regId2VoteCache.SetFrozenBase(&pBaseIn->regId2VoteCache);
+        last_vote_height_cache.SetFrozenBase(&pBaseIn->last_vote_height_cache);
+        pending_delegates_cache.SetFrozenBase(&pBaseIn->pending_delegates_cache);
+        active_delegates_cache.SetFrozenBase(&pBaseIn->active_delegates_cache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         voteRegIdCache.SetDbOpLogMap(pDbOpLogMapIn);
         regId2VoteCache.SetDbOpLogMap(pDbOpLogMapIn);
@@ -79,6 +95,22 @@ public:
         active_delegates_cache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        voteRegIdCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        regId2VoteCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        last_vote_height_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+        pending_delegates_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+        active_delegates_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        voteRegIdCache.DiscardData(dbKeys);
+        regId2VoteCache.DiscardData(dbKeys);
+        last_vote_height_cache.DiscardData(dbKeys);
+        pending_delegates_cache.DiscardData(dbKeys);
+        active_delegates_cache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         voteRegIdCache.RegisterUndoFunc(undoDataFuncMap);
         regId2VoteCache.RegisterUndoFunc(undoDataFuncMap);
@@ -143,6 +143,24 @@ public:
         operator_trade_pair_cache.SetBase(&pBaseIn->operator_trade_pair_cache);
     };
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        activeOrderCache.SetDbAccess(pDbAccessIn);
+        blockOrdersCache.SetDbAccess(pDbAccessIn);
+        operator_detail_cache.SetDbAccess(pDbAccessIn);
+        operator_owner_map_cache.SetDbAccess(pDbAccessIn);
+        operator_last_id_cache.SetDbAccess(pDbAccessIn);
+        operator_trade_pair_cache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CDexDBCache *pBaseIn) {
+        activeOrderCache.SetFrozenBase(&pBaseIn->activeOrderCache);
+        blockOrdersCache.SetFrozenBase(&pBaseIn->blockOrdersCache);
+        operator_detail_cache.SetFrozenBase(&pBaseIn->operator_detail_cache);
+        operator_owner_map_cache.SetFrozenBase(&pBaseIn->operator_owner_map_cache);
+        operator_last_id_cache.SetFrozenBase(&pBaseIn->operator_last_id_cache);
+        operator_trade_pair_cache.SetFrozenBase(&pBaseIn->operator_trade_pair_cache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         activeOrderCache.SetDbOpLogMap(pDbOpLogMapIn);
         blockOrdersCache.SetDbOpLogMap(pDbOpLogMapIn);
@@ -152,6 +170,24 @@ public:
         operator_trade_pair_cache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        activeOrderCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        blockOrdersCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        operator_detail_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+        operator_owner_map_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+        operator_last_id_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+        operator_trade_pair_cache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        activeOrderCache.DiscardData(dbKeys);
+        blockOrdersCache.DiscardData(dbKeys);
+        operator_detail_cache.DiscardData(dbKeys);
+        operator_owner_map_cache.DiscardData(dbKeys);
+        operator_last_id_cache.DiscardData(dbKeys);
+        operator_trade_pair_cache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         activeOrderCache.RegisterUndoFunc(undoDataFuncMap);
         blockOrdersCache.RegisterUndoFunc(undoDataFuncMap);
@@ -179,7 +215,7 @@ public:
 /*  ----------------   -----------------------------  ---------------------------  ------------------   ------------------------ */
     /////////// DexDB
     // order tx id -> active order
-    CCompositeKVCache< dbk::DEX_ACTIVE_ORDER,          uint256,                     dex::CDEXOrderDetail >     activeOrderCache;
+    CHashKVCache<      dbk::DEX_ACTIVE_ORDER,          uint256,                     dex::CDEXOrderDetail >     activeOrderCache;
     DEXBlockOrdersCache    blockOrdersCache;
     CCompositeKVCache< dbk::DEX_OPERATOR_DETAIL,       std::optional<CVarIntValue<DexID>> , DexOperatorDetail >   operator_detail_cache;
     CCompositeKVCache< dbk::DEX_OPERATOR_OWNER_MAP,    CRegIDKey,               std::optional<CVarIntValue<DexID>>> operator_owner_map_cache;
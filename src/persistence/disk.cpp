@@ -7,6 +7,18 @@
 #include "logging.h"
 #include "boost/filesystem.hpp"
 
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CBlockFileInfo
 
@@ -62,3 +74,103 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) {
     return OpenDiskFile(pos, "blk", fReadOnly);
 }
+
+#ifndef WIN32
+/** The max. count of the block files mapped at the same time */
+static const size_t MAX_MAPPED_BLOCK_FILES = 64;
+
+// The read-only memory map of a block file, unmapped when released by the last reader.
+class CMappedBlockFile {
+public:
+    CMappedBlockFile(void *pDataIn, size_t nSizeIn) : pData(pDataIn), nSize(nSizeIn) {}
+    ~CMappedBlockFile() { munmap(pData, nSize); }
+
+    const char *GetData() const { return (const char *)pData; }
+    size_t GetSize() const { return nSize; }
+
+private:
+    void *pData;
+    size_t nSize;
+};
+
+static std::mutex cs_mapped_files;
+static std::map<int32_t, std::shared_ptr<CMappedBlockFile>> mapMappedFiles;  // file num -> map
+static std::list<int32_t> lruMappedFiles;  // the most recently used file is at the front
+
+// Get the map of the block file which covers the min. size. The file is mapped again when it has grown, since the
+// last block file is appended.
+static std::shared_ptr<CMappedBlockFile> GetMappedBlockFile(int32_t nFile, size_t nMinSize) {
+    std::unique_lock<std::mutex> lock(cs_mapped_files);
+    auto it = mapMappedFiles.find(nFile);
+    if (it != mapMappedFiles.end() && it->second->GetSize() >= nMinSize) {
+        lruMappedFiles.remove(nFile);
+        lruMappedFiles.push_front(nFile);
+        return it->second;
+    }
+
+    boost::filesystem::path path = GetDataDir() / "blocks" / strprintf("blk%05u.dat", nFile);
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+
+    struct stat fileStat;
+    void *pData = MAP_FAILED;
+    if (fstat(fd, &fileStat) == 0 && (size_t)fileStat.st_size >= nMinSize && fileStat.st_size > 0)
+        pData = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pData == MAP_FAILED)
+        return nullptr;
+
+    // the readers of the old map keep it until they finish
+    auto pMappedFile      = std::make_shared<CMappedBlockFile>(pData, fileStat.st_size);
+    mapMappedFiles[nFile] = pMappedFile;
+    lruMappedFiles.remove(nFile);
+    lruMappedFiles.push_front(nFile);
+    while (lruMappedFiles.size() > MAX_MAPPED_BLOCK_FILES) {
+        mapMappedFiles.erase(lruMappedFiles.back());
+        lruMappedFiles.pop_back();
+    }
+    return pMappedFile;
+}
+#endif
+
+bool ReadBlockFile(const CDiskBlockPos &pos, const std::function<void(CBlockFileStream &)> &readFunc) {
+    if (pos.IsNull())
+        return ERRORMSG("ReadBlockFile : null position");
+
+#ifndef WIN32
+    std::shared_ptr<CMappedBlockFile> pMappedFile = GetMappedBlockFile(pos.nFile, (size_t)pos.nPos + 1);
+    if (pMappedFile) {
+        try {
+            CBlockFileStream stream(pMappedFile->GetData() + pos.nPos, pMappedFile->GetSize() - pos.nPos);
+            readFunc(stream);
+            return true;
+        } catch (std::exception &e) {
+            // the data may be written after mapped, try to map the file again
+            pMappedFile = GetMappedBlockFile(pos.nFile, pMappedFile->GetSize() + 1);
+        }
+    }
+
+    if (pMappedFile) {
+        try {
+            CBlockFileStream stream(pMappedFile->GetData() + pos.nPos, pMappedFile->GetSize() - pos.nPos);
+            readFunc(stream);
+            return true;
+        } catch (std::exception &e) {
+            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+    }
+#endif
+
+    FILE *file = OpenBlockFile(pos, true);
+    if (file == nullptr)
+        return ERRORMSG("ReadBlockFile : OpenBlockFile failed");
+
+    try {
+        CBlockFileStream stream(file);
+        readFunc(stream);
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    return true;
+}
@@ -8,6 +8,9 @@
 
 #include "commons/util/util.h"
 #include "commons/serialize.h"
+#include "config/version.h"
+
+#include <functional>
 
 struct CDiskBlockPos {
     int32_t nFile;
@@ -124,4 +127,77 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 /** Open a block file (blk?????.dat) */
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
+/**
+ * The stream reading a block file from a position, either in the memory map of the file or by the file handle.
+ */
+class CBlockFileStream {
+public:
+    int nType;
+    int nVersion;
+
+    // read the mapped data
+    CBlockFileStream(const char *pDataIn, size_t nSizeIn)
+        : nType(SER_DISK), nVersion(CLIENT_VERSION), file(nullptr), pData(pDataIn), nSize(nSizeIn), nReadPos(0) {}
+
+    // read the file, which is closed by the stream
+    CBlockFileStream(FILE *fileIn)
+        : nType(SER_DISK), nVersion(CLIENT_VERSION), file(fileIn), pData(nullptr), nSize(0), nReadPos(0) {}
+
+    ~CBlockFileStream() {
+        if (file != nullptr)
+            fclose(file);
+    }
+
+    CBlockFileStream &read(char *pch, size_t nCount) {
+        if (file != nullptr) {
+            if (fread(pch, 1, nCount, file) != nCount)
+                throw std::ios_base::failure(feof(file) ? "CBlockFileStream::read : end of file"
+                                                        : "CBlockFileStream::read : fread failed");
+            return *this;
+        }
+
+        if (nCount > nSize - nReadPos)
+            throw std::ios_base::failure("CBlockFileStream::read : end of mapped data");
+        memcpy(pch, pData + nReadPos, nCount);
+        nReadPos += nCount;
+        return *this;
+    }
+
+    // skip the data, e.g. the txs before the tx to read
+    CBlockFileStream &ignore(size_t nCount) {
+        if (file != nullptr) {
+            if (fseek(file, nCount, SEEK_CUR))
+                throw std::ios_base::failure("CBlockFileStream::ignore : fseek failed");
+            return *this;
+        }
+
+        if (nCount > nSize - nReadPos)
+            throw std::ios_base::failure("CBlockFileStream::ignore : end of mapped data");
+        nReadPos += nCount;
+        return *this;
+    }
+
+    template<typename T>
+    CBlockFileStream &operator>>(T &obj) {
+        ::Unserialize(*this, obj, nType, nVersion);
+        return *this;
+    }
+
+private:
+    CBlockFileStream(const CBlockFileStream &);
+    CBlockFileStream &operator=(const CBlockFileStream &);
+
+    FILE *file;
+    const char *pData;
+    size_t nSize;
+    size_t nReadPos;
+};
+
+/**
+ * Read a block file from the position by the reading function. The block files are mapped read-only into memory
+ * and the maps are shared by all the threads, so the reads of the historical blocks and txs need no file opening
+ * and no lock of the chain. It falls back to read the file by a handle when the file can not be mapped.
+ */
+bool ReadBlockFile(const CDiskBlockPos &pos, const std::function<void(CBlockFileStream &)> &readFunc);
+
 #endif //PERSIST_DISK_H
\ No newline at end of file
@@ -0,0 +1,227 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_FLATHASHMAP_H
+#define PERSIST_FLATHASHMAP_H
+
+#include "commons/uint256.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Hash of a key which is a uniformly random hash already, e.g. a txid or a key id. The first 8 bytes are taken as
+ * they are, CFlatHashMap mixes all the bits when it picks a slot.
+ */
+struct CBlobHasher {
+    template<unsigned int BITS>
+    size_t operator()(const base_blob<BITS> &key) const {
+        uint64_t result;
+        memcpy(&result, key.begin(), sizeof(result));
+        return result;
+    }
+};
+
+/**
+ * Open addressing hash map with linear probing, the entries are stored in one flat array.
+ * It supports the subset of the std::map interface used by the db caches, except the ordered iteration.
+ * Like std::unordered_map, an insertion may invalidate the iterators.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class CFlatHashMap {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<K, V> value_type;
+
+private:
+    enum SlotState : uint8_t { SLOT_EMPTY = 0, SLOT_USED = 1, SLOT_DELETED = 2 };
+
+    struct Slot {
+        uint8_t state = SLOT_EMPTY;
+        value_type kv;
+    };
+
+public:
+    template<bool IS_CONST>
+    class IteratorT {
+    public:
+        typedef typename std::conditional<IS_CONST, const CFlatHashMap, CFlatHashMap>::type MapType;
+        typedef typename std::conditional<IS_CONST, const value_type, value_type>::type ItemType;
+
+        IteratorT() : pMap(nullptr), pos(0) {}
+        IteratorT(MapType *pMapIn, size_t posIn) : pMap(pMapIn), pos(posIn) { SkipFreeSlots(); }
+        // convert iterator to const_iterator
+        template<bool C = IS_CONST, typename = typename std::enable_if<C>::type>
+        IteratorT(const IteratorT<false> &other) : pMap(other.pMap), pos(other.pos) {}
+
+        ItemType &operator*() const { return pMap->slots[pos].kv; }
+        ItemType *operator->() const { return &pMap->slots[pos].kv; }
+
+        IteratorT &operator++() {
+            ++pos;
+            SkipFreeSlots();
+            return *this;
+        }
+
+        IteratorT operator++(int) {
+            IteratorT ret = *this;
+            ++(*this);
+            return ret;
+        }
+
+        template<bool C>
+        bool operator==(const IteratorT<C> &other) const { return pos == other.pos; }
+        template<bool C>
+        bool operator!=(const IteratorT<C> &other) const { return pos != other.pos; }
+
+    private:
+        friend class CFlatHashMap;
+        template<bool C> friend class IteratorT;
+
+        void SkipFreeSlots() {
+            while (pos < pMap->slots.size() && pMap->slots[pos].state != SLOT_USED)
+                ++pos;
+        }
+
+        MapType *pMap;
+        size_t pos;
+    };
+
+    typedef IteratorT<false> iterator;
+    typedef IteratorT<true> const_iterator;
+
+public:
+    CFlatHashMap() {}
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, slots.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slots.size()); }
+
+    size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+
+    iterator find(const K &key) { return iterator(this, FindPos(key)); }
+    const_iterator find(const K &key) const { return const_iterator(this, FindPos(key)); }
+
+    size_t count(const K &key) const { return FindPos(key) != slots.size() ? 1 : 0; }
+
+    std::pair<iterator, bool> emplace(const K &key, const V &value) {
+        size_t pos = FindPos(key);
+        if (pos != slots.size())
+            return std::make_pair(iterator(this, pos), false);
+
+        if ((used + deleted + 1) * 4 > slots.size() * 3)
+            Rehash((used + 1) * 2 > slots.size() ? std::max<size_t>(MIN_CAPACITY, slots.size() * 2) : slots.size());
+
+        pos = InsertPos(key);
+        if (slots[pos].state == SLOT_DELETED)
+            --deleted;
+        slots[pos].state = SLOT_USED;
+        slots[pos].kv    = value_type(key, value);
+        ++used;
+        return std::make_pair(iterator(this, pos), true);
+    }
+
+    V &operator[](const K &key) {
+        size_t pos = FindPos(key);
+        if (pos != slots.size())
+            return slots[pos].kv.second;
+
+        return emplace(key, V()).first->second;
+    }
+
+    iterator erase(iterator it) {
+        Slot &slot = slots[it.pos];
+        slot.state = SLOT_DELETED;
+        slot.kv    = value_type();  // release the memory held by the value
+        --used;
+        ++deleted;
+        return ++it;
+    }
+
+    size_t erase(const K &key) {
+        size_t pos = FindPos(key);
+        if (pos == slots.size())
+            return 0;
+
+        erase(iterator(this, pos));
+        return 1;
+    }
+
+    void clear() {
+        slots.clear();
+        used    = 0;
+        deleted = 0;
+        shift   = 64;
+    }
+
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    // Fibonacci hashing, the high bits of the product depend on all the bits of the hash.
+    inline size_t SlotIndex(const K &key) const {
+        return (uint64_t(Hash()(key)) * 0x9E3779B97F4A7C15ULL) >> shift;
+    }
+
+    size_t FindPos(const K &key) const {
+        if (slots.empty())
+            return 0;
+
+        size_t mask = slots.size() - 1;
+        for (size_t pos = SlotIndex(key);; pos = (pos + 1) & mask) {
+            const Slot &slot = slots[pos];
+            if (slot.state == SLOT_EMPTY)
+                return slots.size();
+            if (slot.state == SLOT_USED && slot.kv.first == key)
+                return pos;
+        }
+    }
+
+    // the first free slot of the key, the key must not be in the map
+    size_t InsertPos(const K &key) const {
+        size_t mask = slots.size() - 1;
+        size_t pos  = SlotIndex(key);
+        while (slots[pos].state == SLOT_USED)
+            pos = (pos + 1) & mask;
+        return pos;
+    }
+
+    void Rehash(size_t capacity) {
+        std::vector<Slot> oldSlots(capacity);
+        oldSlots.swap(slots);
+        deleted = 0;
+        shift   = 64;
+        for (size_t n = capacity; n > 1; n >>= 1)
+            --shift;
+
+        for (auto &slot : oldSlots) {
+            if (slot.state != SLOT_USED)
+                continue;
+
+            size_t pos         = InsertPos(slot.kv.first);
+            slots[pos].state   = SLOT_USED;
+            slots[pos].kv      = std::move(slot.kv);
+        }
+    }
+
+private:
+    std::vector<Slot> slots;  // the capacity is a power of 2
+    size_t used    = 0;
+    size_t deleted = 0;
+    uint32_t shift = 64;  // 64 - log2(capacity)
+};
+
+template<typename MapType>
+struct IsFlatHashMap : std::false_type {};
+
+template<typename K, typename V, typename Hash>
+struct IsFlatHashMap<CFlatHashMap<K, V, Hash>> : std::true_type {};
+
+#endif  // PERSIST_FLATHASHMAP_H
@@ -18,6 +18,65 @@
 
 using namespace json_spirit;
 
+/**
+ * The stream which serializes to the end of a string, so that the serialized data needs no temporary buffer.
+ */
+class CStringWriter {
+public:
+    int nType;
+    int nVersion;
+
+    CStringWriter(string &strIn, int nTypeIn, int nVersionIn) : nType(nTypeIn), nVersion(nVersionIn), str(strIn) {}
+
+    CStringWriter &write(const char *pch, size_t nSize) {
+        str.append(pch, nSize);
+        return *this;
+    }
+
+    template<typename T>
+    CStringWriter &operator<<(const T &obj) {
+        ::Serialize(*this, obj, nType, nVersion);
+        return *this;
+    }
+
+private:
+    string &str;
+};
+
+/**
+ * The stream which deserializes from a string in place, without copying it.
+ */
+class CStringReader {
+public:
+    int nType;
+    int nVersion;
+
+    CStringReader(const string &strIn, int nTypeIn, int nVersionIn)
+        : nType(nTypeIn), nVersion(nVersionIn), str(strIn), nReadPos(0) {}
+
+    CStringReader &read(char *pch, size_t nSize) {
+        if (nSize > size())
+            throw std::ios_base::failure("CStringReader::read() : end of data");
+
+        memcpy(pch, str.data() + nReadPos, nSize);
+        nReadPos += nSize;
+        return *this;
+    }
+
+    // the size of the rest data
+    size_t size() const { return str.size() - nReadPos; }
+
+    template<typename T>
+    CStringReader &operator>>(T &obj) {
+        ::Unserialize(*this, obj, nType, nVersion);
+        return *this;
+    }
+
+private:
+    const string &str;
+    size_t nReadPos;
+};
+
 class CDbOpLog {
 private:
     string key;
@@ -28,39 +87,31 @@ public:
     // for key-value
     template<typename K, typename V>
     void Set(const K& keyIn, const V& valueIn){
+        key.clear();
+        CStringWriter(key, SER_DISK, CLIENT_VERSION) << keyIn;
 
-        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
-        ssKey << keyIn;
-        key = ssKey.str();
-
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-        ssValue << valueIn;
-        value = ssValue.str();
+        value.clear();
+        CStringWriter(value, SER_DISK, CLIENT_VERSION) << valueIn;
     }
 
     // for single value
     template<typename V>
     void Set(const V& valueIn){
-        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
-        ssValue << valueIn;
-        value = ssValue.str();
+        value.clear();
+        CStringWriter(value, SER_DISK, CLIENT_VERSION) << valueIn;
     }
 
     // for key-value
     template<typename K, typename V>
     void Get(K& keyOut, V& valueOut) const {
-        CDataStream ssKey(key, SER_DISK, CLIENT_VERSION);
-        ssKey >> keyOut;
-
-        CDataStream ssValue(value, SER_DISK, CLIENT_VERSION);
-        ssValue >> valueOut;
+        CStringReader(key, SER_DISK, CLIENT_VERSION) >> keyOut;
+        CStringReader(value, SER_DISK, CLIENT_VERSION) >> valueOut;
     }
 
     // for single value
     template<typename V>
     void Get(V& valueOut) const {
-        CDataStream ssValue(value, SER_DISK, CLIENT_VERSION);
-        ssValue >> valueOut;
+        CStringReader(value, SER_DISK, CLIENT_VERSION) >> valueOut;
     }
 
     const string& GetKey() const { return key; }
@@ -104,8 +155,24 @@ public:
         mapDbOpLogs[prefix].push_back(dbOpLogIn);
     }
 
+    // add an empty op log to be set in place
+    CDbOpLog& NewOpLog(dbk::PrefixType prefixType) {
+        assert(prefixType != dbk::EMPTY);
+        CDbOpLogs &dbOpLogs = mapDbOpLogs[dbk::GetKeyPrefix(prefixType)];
+        dbOpLogs.emplace_back();
+        return dbOpLogs.back();
+    }
+
     void Clear() { mapDbOpLogs.clear(); }
 
+    // get the db keys (prefix + key) of the op logs
+    void GetDbKeys(set<string> &dbKeys) const {
+        for (const auto &item : mapDbOpLogs) {
+            for (const auto &dbOpLog : item.second)
+                dbKeys.insert(item.first + dbOpLog.GetKey());
+        }
+    }
+
     std::string ToString() const;
 public:
     IMPLEMENT_SERIALIZE(
@@ -115,6 +182,28 @@ private:
     mutable map<string, CDbOpLogs> mapDbOpLogs; // dbName -> dbOpLogs
 };
 
+/**
+ * The db keys (prefix + key) read or written through a cache. A range read, e.g. by an iterator, records the
+ * key prefix only, which stands for all the keys with the prefix.
+ */
+class CDBKeyTracker {
+public:
+    set<string> accessedKeys;  // the keys read or written
+    set<string> writtenKeys;
+
+    void AddAccessedKey(const string &dbKey) { accessedKeys.insert(dbKey); }
+
+    void AddWrittenKey(const string &dbKey) {
+        accessedKeys.insert(dbKey);
+        writtenKeys.insert(dbKey);
+    }
+
+    void Clear() {
+        accessedKeys.clear();
+        writtenKeys.clear();
+    }
+};
+
 class leveldb_error : public runtime_error
 {
 public:
@@ -141,6 +230,11 @@ public:
         batch.Put(slKey, slValue);
     }
 
+    // write the value serialized already
+    void WriteSerialized(const std::string &key, const std::string &value) {
+        batch.Put(key, value);
+    }
+
     void Erase(const std::string &key) {
         batch.Delete(key);
     }
@@ -174,12 +268,15 @@ public:
     CLevelDBWrapper(const boost::filesystem::path &path, size_t nCacheSize, bool fMemory = false, bool fWipe = false);
     ~CLevelDBWrapper();
 
+    // read the db as of the snapshot if it's not null
     template<typename V>
-    bool Read(std::string key, V &value) {
+    bool Read(std::string key, V &value, const leveldb::Snapshot *pSnapshot = nullptr) {
     	leveldb::Slice slKey(key);
 
+        leveldb::ReadOptions options = readoptions;
+        options.snapshot = pSnapshot;
         string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(options, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -202,10 +299,12 @@ public:
         return WriteBatch(batch, fSync);
     }
 
-    bool Exists(const std::string &key) {
+    bool Exists(const std::string &key, const leveldb::Snapshot *pSnapshot = nullptr) {
     	leveldb::Slice slKey(key);
+        leveldb::ReadOptions options = readoptions;
+        options.snapshot = pSnapshot;
         string strValue;
-        leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        leveldb::Status status = pdb->Get(options, slKey, &strValue);
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -234,9 +333,15 @@ public:
     }
 
     // not exactly clean encapsulation, but it's easiest for now
-    leveldb::Iterator *NewIterator() {
-        return pdb->NewIterator(iteroptions);
+    leveldb::Iterator *NewIterator(const leveldb::Snapshot *pSnapshot = nullptr) {
+        leveldb::ReadOptions options = iteroptions;
+        options.snapshot = pSnapshot;
+        return pdb->NewIterator(options);
     }
+
+    // the snapshot must be released before the db is closed
+    const leveldb::Snapshot *GetSnapshot() { return pdb->GetSnapshot(); }
+    void ReleaseSnapshot(const leveldb::Snapshot *pSnapshot) { pdb->ReleaseSnapshot(pSnapshot); }
     int64_t GetDbCount();
    // Object ToJsonObj();
 };
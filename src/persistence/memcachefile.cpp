@@ -0,0 +1,116 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "memcachefile.h"
+
+#include "commons/random.h"
+#include "commons/serialize.h"
+#include "commons/util/util.h"
+#include "config/chainparams.h"
+#include "crypto/hash.h"
+#include "persistence/pricefeeddb.h"
+#include "persistence/txdb.h"
+
+#include <boost/filesystem.hpp>
+
+CMemCacheFile::CMemCacheFile() { pathFile = GetDataDir() / "memcache.dat"; }
+
+bool CMemCacheFile::Write(const uint256 &bestBlockHash, const CTxMemCache &txCache,
+                          const CPricePointMemCache &ppCache) {
+    UnorderedHashSet txids;
+    txCache.GetTxids(txids);
+    CoinBlockUserPriceMap coinBlockUserPrices;
+    ppCache.GetCoinBlockUserPrices(coinBlockUserPrices);
+
+    // serialize the caches, checksum data up to that point, then append csum
+    CDataStream ssCache(SER_DISK, CLIENT_VERSION);
+    ssCache << FLATDATA(SysCfg().MessageStart());
+    ssCache << MEM_CACHE_FILE_VERSION << bestBlockHash << SysCfg().GetTxCacheHeight();
+    ssCache << vector<uint256>(txids.begin(), txids.end());
+    ssCache << coinBlockUserPrices;
+    uint256 hash = Hash(ssCache.begin(), ssCache.end());
+    ssCache << hash;
+
+    // open temp output file, and associate with CAutoFile
+    boost::filesystem::path pathTmp = GetDataDir() / strprintf("memcache.dat.%04x", GetRand(0x10000));
+    FILE *file                      = fopen(pathTmp.string().c_str(), "wb");
+    CAutoFile fileout               = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!fileout)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathTmp.string());
+
+    try {
+        fileout << ssCache;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Serialize or I/O error - %s", __func__, e.what());
+    }
+    FileCommit(fileout);
+    fileout.fclose();
+
+    // replace existing memcache.dat, if any, with new memcache.dat.XXXX
+    if (!RenameOver(pathTmp, pathFile))
+        return ERRORMSG("%s : Rename-into-place failed", __func__);
+
+    return true;
+}
+
+bool CMemCacheFile::Read(const uint256 &bestBlockHash, CTxMemCache &txCache, CPricePointMemCache &ppCache) {
+    if (!boost::filesystem::exists(pathFile))
+        return false;
+
+    // open input file, and associate with CAutoFile
+    FILE *file       = fopen(pathFile.string().c_str(), "rb");
+    CAutoFile filein = CAutoFile(file, SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("%s : Failed to open file %s", __func__, pathFile.string());
+
+    // use file size to size memory buffer
+    int64_t dataSize = boost::filesystem::file_size(pathFile) - sizeof(uint256);
+    if (dataSize < 0)
+        dataSize = 0;
+    vector<uint8_t> vchData(dataSize);
+    uint256 hashIn;
+
+    // read data and checksum from file
+    try {
+        filein.read((char *)vchData.data(), dataSize);
+        filein >> hashIn;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+    filein.fclose();
+
+    CDataStream ssCache(vchData, SER_DISK, CLIENT_VERSION);
+    if (hashIn != Hash(ssCache.begin(), ssCache.end()))
+        return ERRORMSG("%s : Checksum mismatch, data corrupted", __func__);
+
+    uint8_t pchMsgTmp[4];
+    int32_t version;
+    uint256 blockHash;
+    int32_t txCacheHeight;
+    vector<uint256> txids;
+    CoinBlockUserPriceMap coinBlockUserPrices;
+    try {
+        ssCache >> FLATDATA(pchMsgTmp);
+        if (memcmp(pchMsgTmp, SysCfg().MessageStart(), sizeof(pchMsgTmp)))
+            return ERRORMSG("%s : Invalid network magic number", __func__);
+
+        ssCache >> version >> blockHash >> txCacheHeight;
+        if (version != MEM_CACHE_FILE_VERSION || blockHash != bestBlockHash ||
+            txCacheHeight != SysCfg().GetTxCacheHeight()) {
+            LogPrint(BCLog::INFO, "%s : Ignore the mem caches of version %d at block %s, tx cache height %d\n",
+                     __func__, version, blockHash.ToString(), txCacheHeight);
+            return false;
+        }
+
+        ssCache >> txids;
+        ssCache >> coinBlockUserPrices;
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    txCache.SetTxids(UnorderedHashSet(txids.begin(), txids.end()));
+    ppCache.SetCoinBlockUserPrices(coinBlockUserPrices);
+
+    return true;
+}
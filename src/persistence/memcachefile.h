@@ -0,0 +1,37 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_MEMCACHEFILE_H
+#define PERSIST_MEMCACHEFILE_H
+
+#include "commons/uint256.h"
+
+#include <boost/filesystem/path.hpp>
+
+class CTxMemCache;
+class CPricePointMemCache;
+
+/** Version of the mem cache file, a file of another version is ignored */
+static const int32_t MEM_CACHE_FILE_VERSION = 1;
+/** Seconds between the writes of the mem cache file along with the chain state */
+static const int64_t MEM_CACHE_FILE_WRITE_INTERVAL = 10 * 60;
+
+/**
+ * The memory caches of the recent blocks written to memcache.dat at shutdown and along with the chain state, tagged
+ * with the best block of the chain state. At startup they are read back when the best block matches, instead of
+ * being rebuilt from the latest blocks on disk.
+ */
+class CMemCacheFile {
+private:
+    boost::filesystem::path pathFile;
+
+public:
+    CMemCacheFile();
+
+    bool Write(const uint256 &bestBlockHash, const CTxMemCache &txCache, const CPricePointMemCache &ppCache);
+    // The caches are changed only when the file is intact and written at the best block
+    bool Read(const uint256 &bestBlockHash, CTxMemCache &txCache, CPricePointMemCache &ppCache);
+};
+
+#endif  // PERSIST_MEMCACHEFILE_H
@@ -9,13 +9,158 @@
 #include "main.h"
 #include "tx/pricefeedtx.h"
 
+void CMedianPriceSet::Insert(const uint64_t price) {
+    if (lower.empty() || price <= *lower.rbegin())
+        lower.insert(price);
+    else
+        upper.insert(price);
+
+    Rebalance();
+}
+
+void CMedianPriceSet::Erase(const uint64_t price) {
+    if (!lower.empty() && price <= *lower.rbegin()) {
+        auto it = lower.find(price);
+        assert(it != lower.end());
+        lower.erase(it);
+    } else {
+        auto it = upper.find(price);
+        assert(it != upper.end());
+        upper.erase(it);
+    }
+
+    Rebalance();
+}
+
+void CMedianPriceSet::Clear() {
+    lower.clear();
+    upper.clear();
+}
+
+void CMedianPriceSet::Rebalance() {
+    if (lower.size() > upper.size() + 1) {
+        auto it = prev(lower.end());
+        upper.insert(*it);
+        lower.erase(it);
+    } else if (upper.size() > lower.size()) {
+        auto it = upper.begin();
+        lower.insert(*it);
+        upper.erase(it);
+    }
+}
+
+uint64_t CMedianPriceSet::GetMedian() const {
+    if (lower.empty())
+        return 0;
+
+    return lower.size() > upper.size() ? *lower.rbegin() : (*lower.rbegin() + *upper.begin()) / 2;
+}
+
+uint64_t CMedianPriceSet::GetMedian(const vector<uint64_t> &erasedPrices,
+                                    const vector<uint64_t> &insertedPrices) const {
+    if (erasedPrices.empty() && insertedPrices.empty())
+        return GetMedian();
+
+    assert(GetSize() >= erasedPrices.size());
+    size_t size = GetSize() + insertedPrices.size() - erasedPrices.size();
+    if (size == 0)
+        return 0;
+
+    // Each change moves the median by at most one price, so the median of the changed prices is one of the
+    // prices near the median or one of the inserted prices.
+    size_t margin     = 2 * (erasedPrices.size() + insertedPrices.size()) + 2;
+    size_t lowerCount = std::min(margin, lower.size());
+    size_t upperCount = std::min(margin, upper.size());
+    vector<uint64_t> prices(prev(lower.end(), lowerCount), lower.end());
+    prices.insert(prices.end(), upper.begin(), next(upper.begin(), upperCount));
+    int64_t pricesBefore = lower.size() - lowerCount;  // count of the prices before the merged prices
+
+    if (prices.empty()) {
+        prices = insertedPrices;
+        sort(prices.begin(), prices.end());
+    } else {
+        uint64_t minPrice = prices.front();
+        uint64_t maxPrice = prices.back();
+        for (uint64_t price : erasedPrices) {
+            if (price < minPrice) {
+                pricesBefore--;
+            } else if (price <= maxPrice) {
+                auto it = lower_bound(prices.begin(), prices.end(), price);
+                if (it != prices.end() && *it == price)
+                    prices.erase(it);
+                else if (price == minPrice)  // the equal ones merged are erased, the rest are before them
+                    pricesBefore--;
+            }
+        }
+
+        for (uint64_t price : insertedPrices) {
+            if (price < minPrice)
+                pricesBefore++;
+            else if (price <= maxPrice)
+                prices.insert(upper_bound(prices.begin(), prices.end(), price), price);
+        }
+    }
+
+    int64_t lowIndex  = (size - 1) / 2 - pricesBefore;
+    int64_t highIndex = size / 2 - pricesBefore;
+    if (lowIndex < 0 || highIndex >= (int64_t)prices.size()) {
+        // never expected, sort all prices as a fallback
+        vector<uint64_t> allPrices(lower.begin(), lower.end());
+        allPrices.insert(allPrices.end(), upper.begin(), upper.end());
+        for (uint64_t price : erasedPrices) {
+            auto it = lower_bound(allPrices.begin(), allPrices.end(), price);
+            assert(it != allPrices.end() && *it == price);
+            allPrices.erase(it);
+        }
+        allPrices.insert(allPrices.end(), insertedPrices.begin(), insertedPrices.end());
+
+        return ComputeMedianNumber(allPrices);
+    }
+
+    return lowIndex == highIndex ? prices[lowIndex] : (prices[lowIndex] + prices[highIndex]) / 2;
+}
+
+uint64_t CMedianPriceSet::ComputeMedianNumber(vector<uint64_t> &numbers) {
+    int32_t size = numbers.size();
+    if (size < 2) {
+        return size == 0 ? 0 : numbers[0];
+    }
+    sort(numbers.begin(), numbers.end());
+    return (size % 2 == 0) ? (numbers[size / 2 - 1] + numbers[size / 2]) / 2 : numbers[size / 2];
+}
+
 void CConsecutiveBlockPrice::AddUserPrice(const int32_t blockHeight, const CRegID &regId, const uint64_t price) {
-    mapBlockUserPrices[blockHeight][regId] = price;
+    auto ret = mapBlockUserPrices[blockHeight].emplace(regId, price);
+    if (!ret.second) {
+        sortedPrices.Erase(ret.first->second);
+        ret.first->second = price;
+    }
+    sortedPrices.Insert(price);
+}
+
+void CConsecutiveBlockPrice::InsertUserPrice(const int32_t blockHeight, const CRegID &regId, const uint64_t price) {
+    if (mapBlockUserPrices[blockHeight].emplace(regId, price).second)
+        sortedPrices.Insert(price);
 }
 
 void CConsecutiveBlockPrice::DeleteUserPrice(const int32_t blockHeight) {
     // Marked the value empty, the base cache will delete it when Flush() is called.
-    mapBlockUserPrices[blockHeight].clear();
+    auto &userPrices = mapBlockUserPrices[blockHeight];
+    for (const auto &item : userPrices) {
+        sortedPrices.Erase(item.second);
+    }
+    userPrices.clear();
+}
+
+void CConsecutiveBlockPrice::EraseBlock(const int32_t blockHeight) {
+    auto it = mapBlockUserPrices.find(blockHeight);
+    if (it == mapBlockUserPrices.end())
+        return;
+
+    for (const auto &item : it->second) {
+        sortedPrices.Erase(item.second);
+    }
+    mapBlockUserPrices.erase(it);
 }
 
 bool CConsecutiveBlockPrice::ExistBlockUserPrice(const int32_t blockHeight, const CRegID &regId) {
@@ -99,17 +244,17 @@ bool CPricePointMemCache::DeleteBlockFromCache(const CBlock &block) { return Del
 
 void CPricePointMemCache::BatchWrite(const CoinPricePointMap &mapCoinPricePointCacheIn) {
     for (const auto &item : mapCoinPricePointCacheIn) {
+        CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[item.first /* CoinPricePair */];
         // map<int32_t /* block height */, map<CRegID, uint64_t /* price */>>
         const auto &mapBlockUserPrices = item.second.mapBlockUserPrices;
         for (const auto &userPrice : mapBlockUserPrices) {
             if (userPrice.second.empty()) {
-                mapCoinPricePointCache[item.first /* CoinPricePair */].mapBlockUserPrices.erase(userPrice.first /* height */);
+                cbp.EraseBlock(userPrice.first /* height */);
             } else {
                 // map<CRegID, uint64_t /* price */>;
                 for (const auto &priceItem : userPrice.second) {
-                    mapCoinPricePointCache[item.first /* CoinPricePair */]
-                        .mapBlockUserPrices[userPrice.first /* height */]
-                        .emplace(priceItem.first /* CRegID */, priceItem.second /* price */);
+                    cbp.InsertUserPrice(userPrice.first /* height */, priceItem.first /* CRegID */,
+                                        priceItem.second /* price */);
                 }
             }
         }
@@ -127,81 +272,76 @@ void CPricePointMemCache::Flush() {
     mapCoinPricePointCache.clear();
 }
 
-bool CPricePointMemCache::GetBlockUserPrices(const CoinPricePair &coinPricePair, set<int32_t> &expired,
-                                             BlockUserPriceMap &blockUserPrices) {
-    const auto &iter = mapCoinPricePointCache.find(coinPricePair);
-    if (iter != mapCoinPricePointCache.end()) {
-        const auto &mapBlockUserPrices = iter->second.mapBlockUserPrices;
-        for (const auto &item : mapBlockUserPrices) {
-            if (item.second.empty()) {
-                expired.insert(item.first);
-            } else if (expired.count(item.first) || blockUserPrices.count(item.first)) {
-                // TODO: log
-                continue;
-            } else {
-                // Got a valid item.
-                blockUserPrices[item.first] = item.second;
-            }
-        }
-    }
+void CPricePointMemCache::GetCoinBlockUserPrices(CoinBlockUserPriceMap &pricesOut) const {
+    assert(pBase == nullptr);
 
-    if (pBase != nullptr) {
-        return pBase->GetBlockUserPrices(coinPricePair, expired, blockUserPrices);
+    for (const auto &item : mapCoinPricePointCache) {
+        pricesOut.emplace(item.first, item.second.mapBlockUserPrices);
     }
-
-    return true;
 }
 
-bool CPricePointMemCache::GetBlockUserPrices(const CoinPricePair &coinPricePair, BlockUserPriceMap &blockUserPrices) {
-    set<int32_t /* block height */> expired;
-    if (!GetBlockUserPrices(coinPricePair, expired, blockUserPrices)) {
-        // TODO: log
-        return false;
-    }
+void CPricePointMemCache::SetCoinBlockUserPrices(const CoinBlockUserPriceMap &pricesIn) {
+    assert(pBase == nullptr);
 
-    return true;
-}
+    mapCoinPricePointCache.clear();
+    for (const auto &item : pricesIn) {
+        CConsecutiveBlockPrice &cbp = mapCoinPricePointCache[item.first];
+        for (const auto &userPrice : item.second) {
+            if (userPrice.second.empty()) {
+                cbp.DeleteUserPrice(userPrice.first);
+                continue;
+            }
 
-uint64_t CPricePointMemCache::ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                                      const CoinPricePair &coinPricePair) {
-    // 1. merge block user prices with base cache.
-    BlockUserPriceMap blockUserPrices;
-    if (!GetBlockUserPrices(coinPricePair, blockUserPrices) || blockUserPrices.empty()) {
-        return 0;
+            for (const auto &priceItem : userPrice.second) {
+                cbp.AddUserPrice(userPrice.first, priceItem.first, priceItem.second);
+            }
+        }
     }
-
-    // 2. compute block median price.
-    return ComputeBlockMedianPrice(blockHeight, slideWindow, blockUserPrices);
 }
 
 uint64_t CPricePointMemCache::ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                                      const BlockUserPriceMap &blockUserPrices) {
-    // for (const auto &item : blockUserPrices) {
-    //     string price;
-    //     for (const auto &userPrice : item.second) {
-    //         price += strprintf("{user:%s, price:%lld}", userPrice.first.ToString(), userPrice.second);
-    //     }
-
-    //     LogPrint(BCLog::PRICEFEED, "CPricePointMemCache::ComputeBlockMedianPrice, height: %d, userPrice: %s\n",
-    //              item.first, price);
-    // }
-
-    vector<uint64_t> prices;
+                                                      const CoinPricePair &coinPricePair) const {
     int32_t beginBlockHeight = std::max<int32_t>((blockHeight - slideWindow), 0);
-    for (int32_t height = blockHeight; height > beginBlockHeight; --height) {
-        const auto &iter = blockUserPrices.find(height);
-        if (iter != blockUserPrices.end()) {
-            for (const auto &userPrice : iter->second) {
-                prices.push_back(userPrice.second);
+    auto inWindow = [&](int32_t height) { return height > beginBlockHeight && height <= blockHeight; };
+
+    // 1. the block user prices of a child cache override the ones of the same height in its base caches, an empty
+    // one means the block has expired.
+    set<int32_t /* block height */> overridden;
+    vector<uint64_t> insertedPrices;
+    const CPricePointMemCache *pCache = this;
+    for (; pCache->pBase != nullptr; pCache = pCache->pBase) {
+        const auto &iter = pCache->mapCoinPricePointCache.find(coinPricePair);
+        if (iter == pCache->mapCoinPricePointCache.end())
+            continue;
+
+        for (const auto &item : iter->second.mapBlockUserPrices) {
+            if (!overridden.insert(item.first).second || !inWindow(item.first))
+                continue;
+
+            for (const auto &userPrice : item.second) {
+                insertedPrices.push_back(userPrice.second);
             }
         }
     }
 
-    // for (const auto &item : prices) {
-    //     LogPrint(BCLog::PRICEFEED, "CPricePointMemCache::ComputeBlockMedianPrice, found a candidate price: %llu\n", item);
-    // }
+    // 2. the sorted prices of the bottom cache without the overridden blocks and the blocks out of the slide window.
+    uint64_t medianPrice = 0;
+    const auto &iter     = pCache->mapCoinPricePointCache.find(coinPricePair);
+    if (iter == pCache->mapCoinPricePointCache.end()) {
+        medianPrice = CMedianPriceSet::ComputeMedianNumber(insertedPrices);
+    } else {
+        vector<uint64_t> erasedPrices;
+        for (const auto &item : iter->second.mapBlockUserPrices) {
+            if (!overridden.count(item.first) && inWindow(item.first))
+                continue;
+
+            for (const auto &userPrice : item.second) {
+                erasedPrices.push_back(userPrice.second);
+            }
+        }
+        medianPrice = iter->second.sortedPrices.GetMedian(erasedPrices, insertedPrices);
+    }
 
-    uint64_t medianPrice = ComputeMedianNumber(prices);
     LogPrint(BCLog::PRICEFEED,
              "CPricePointMemCache::ComputeBlockMedianPrice, blockHeight: %d, computed median number: %llu\n",
              blockHeight, medianPrice);
@@ -209,15 +349,6 @@ uint64_t CPricePointMemCache::ComputeBlockMedianPrice(const int32_t blockHeight,
     return medianPrice;
 }
 
-uint64_t CPricePointMemCache::ComputeMedianNumber(vector<uint64_t> &numbers) {
-    int32_t size = numbers.size();
-    if (size < 2) {
-        return size == 0 ? 0 : numbers[0];
-    }
-    sort(numbers.begin(), numbers.end());
-    return (size % 2 == 0) ? (numbers[size / 2 - 1] + numbers[size / 2]) / 2 : numbers[size / 2];
-}
-
 uint64_t CPricePointMemCache::GetMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
                                              const CoinPricePair &coinPricePair) {
     uint64_t medianPrice = ComputeBlockMedianPrice(blockHeight, slideWindow, coinPricePair);
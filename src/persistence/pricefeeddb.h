@@ -15,6 +15,7 @@
 #include "tx/tx.h"
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -24,17 +25,50 @@ class CConsecutiveBlockPrice;
 
 typedef map<int32_t /* block height */, map<CRegID, uint64_t /* price */>> BlockUserPriceMap;
 typedef map<CoinPricePair, CConsecutiveBlockPrice> CoinPricePointMap;
+typedef map<CoinPricePair, BlockUserPriceMap> CoinBlockUserPriceMap;
+
+/**
+ * The prices sorted into a lower and an upper half, so that the median is read in O(1) and a price is inserted or
+ * erased in O(log n).
+ */
+class CMedianPriceSet {
+public:
+    void Insert(const uint64_t price);
+    // erase one of the equal prices, the price must be in the set
+    void Erase(const uint64_t price);
+    void Clear();
+
+    size_t GetSize() const { return lower.size() + upper.size(); }
+    // the median computed the same as the sorted prices, 0 if the set is empty
+    uint64_t GetMedian() const;
+    // the median of the prices without the erased ones and with the inserted ones, it merges only the prices near
+    // the median with the changes, the erased prices must be in the set
+    uint64_t GetMedian(const vector<uint64_t> &erasedPrices, const vector<uint64_t> &insertedPrices) const;
+
+    static uint64_t ComputeMedianNumber(vector<uint64_t> &numbers);
+
+private:
+    void Rebalance();
+
+    multiset<uint64_t> lower;  // it has one more price than the upper half when the size is odd
+    multiset<uint64_t> upper;
+};
 
 // Price Points in 11 consecutive blocks
 class CConsecutiveBlockPrice {
 public:
     void AddUserPrice(const int32_t blockHeight, const CRegID &regId, const uint64_t price);
+    // add the user price if not existed, for merging the prices of a child cache
+    void InsertUserPrice(const int32_t blockHeight, const CRegID &regId, const uint64_t price);
     // delete user price by specific block height.
     void DeleteUserPrice(const int32_t blockHeight);
+    // erase the block user prices, unlike DeleteUserPrice() no empty mark is left
+    void EraseBlock(const int32_t blockHeight);
     bool ExistBlockUserPrice(const int32_t blockHeight, const CRegID &regId);
 
 public:
     BlockUserPriceMap mapBlockUserPrices;
+    CMedianPriceSet sortedPrices;  // all prices of mapBlockUserPrices
 };
 
 class CPricePointMemCache {
@@ -50,10 +84,17 @@ public:
     bool DeleteBlockFromCache(const CBlock &block);
 
     bool CalcBlockMedianPrices(CCacheWrapper &cw, const int32_t blockHeight, PriceMap &medianPrices);
+    // the median of the user prices in the slide window ending at the block height, 0 if there is no price
+    uint64_t ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
+                                     const CoinPricePair &coinPricePair) const;
 
     void SetBaseViewPtr(CPricePointMemCache *pBaseIn);
     void Flush();
 
+    // the block user prices of a cache without base, for the mem cache file
+    void GetCoinBlockUserPrices(CoinBlockUserPriceMap &pricesOut) const;
+    void SetCoinBlockUserPrices(const CoinBlockUserPriceMap &pricesIn);
+
 private:
     uint64_t GetMedianPrice(const int32_t blockHeight, const uint64_t slideWindow, const CoinPricePair &coinPricePair);
 
@@ -63,15 +104,6 @@ private:
 
     void BatchWrite(const CoinPricePointMap &mapCoinPricePointCacheIn);
 
-    bool GetBlockUserPrices(const CoinPricePair &coinPricePair, set<int32_t> &expired, BlockUserPriceMap &blockUserPrices);
-    bool GetBlockUserPrices(const CoinPricePair &coinPricePair, BlockUserPriceMap &blockUserPrices);
-
-    uint64_t ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                     const CoinPricePair &coinPricePair);
-    uint64_t ComputeBlockMedianPrice(const int32_t blockHeight, const uint64_t slideWindow,
-                                     const BlockUserPriceMap &blockUserPrices);
-    static uint64_t ComputeMedianNumber(vector<uint64_t> &numbers);
-
 private:
     CoinPricePointMap mapCoinPricePointCache;  // coinPriceType -> consecutiveBlockPrice
     CPricePointMemCache *pBase;
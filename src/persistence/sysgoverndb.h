@@ -46,12 +46,36 @@ public:
         secondsCache.SetBase(&pBaseIn->secondsCache);
     }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        governersCache.SetDbAccess(pDbAccessIn);
+        proposalsCache.SetDbAccess(pDbAccessIn);
+        secondsCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CSysGovernDBCache *pBaseIn) {
+        governersCache.SetFrozenBase(&pBaseIn->governersCache);
+        proposalsCache.SetFrozenBase(&pBaseIn->proposalsCache);
+        secondsCache.SetFrozenBase(&pBaseIn->secondsCache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) { 
         governersCache.SetDbOpLogMap(pDbOpLogMapIn);
         proposalsCache.SetDbOpLogMap(pDbOpLogMapIn);
         secondsCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        governersCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        proposalsCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        secondsCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        governersCache.DiscardData(dbKeys);
+        proposalsCache.DiscardData(dbKeys);
+        secondsCache.DiscardData(dbKeys);
+    }
+
 
     bool CheckIsGoverner(const CRegID &candidateRegId) {
         if (!governersCache.HaveData()) {
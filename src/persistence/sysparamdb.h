@@ -106,6 +106,24 @@ public:
         newBpCountCache.SetBase(&pBaseIn->newBpCountCache);
     }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) {
+        sysParamCache.SetDbAccess(pDbAccessIn);
+        minerFeeCache.SetDbAccess(pDbAccessIn);
+        cdpParamCache.SetDbAccess(pDbAccessIn);
+        cdpInterestParamChangesCache.SetDbAccess(pDbAccessIn);
+        currentBpCountCache.SetDbAccess(pDbAccessIn);
+        newBpCountCache.SetDbAccess(pDbAccessIn);
+    }
+
+    void SetFrozenBase(CSysParamDBCache *pBaseIn) {
+        sysParamCache.SetFrozenBase(&pBaseIn->sysParamCache);
+        minerFeeCache.SetFrozenBase(&pBaseIn->minerFeeCache);
+        cdpParamCache.SetFrozenBase(&pBaseIn->cdpParamCache);
+        cdpInterestParamChangesCache.SetFrozenBase(&pBaseIn->cdpInterestParamChangesCache);
+        currentBpCountCache.SetFrozenBase(&pBaseIn->currentBpCountCache);
+        newBpCountCache.SetFrozenBase(&pBaseIn->newBpCountCache);
+    }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         sysParamCache.SetDbOpLogMap(pDbOpLogMapIn);
         minerFeeCache.SetDbOpLogMap(pDbOpLogMapIn);
@@ -116,6 +134,24 @@ public:
 
     }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) {
+        sysParamCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        minerFeeCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        cdpParamCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        cdpInterestParamChangesCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        currentBpCountCache.SetDbKeyTracker(pDbKeyTrackerIn);
+        newBpCountCache.SetDbKeyTracker(pDbKeyTrackerIn);
+    }
+
+    void DiscardData(const set<string> &dbKeys) {
+        sysParamCache.DiscardData(dbKeys);
+        minerFeeCache.DiscardData(dbKeys);
+        cdpParamCache.DiscardData(dbKeys);
+        cdpInterestParamChangesCache.DiscardData(dbKeys);
+        currentBpCountCache.DiscardData(dbKeys);
+        newBpCountCache.DiscardData(dbKeys);
+    }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         sysParamCache.RegisterUndoFunc(undoDataFuncMap);
         minerFeeCache.RegisterUndoFunc(undoDataFuncMap);
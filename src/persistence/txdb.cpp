@@ -14,50 +14,111 @@
 
 #include <algorithm>
 
+// the min. number of the changed txids merged by Compact()
+static const size_t MIN_TX_CACHE_COMPACT_SIZE = 1000;
+
 bool CTxMemCache::AddBlockTx(const CBlock &block) {
     for (auto &ptx : block.vptx) {
-        txids.insert(ptx->GetHash());
+        removedTxids.erase(ptx->GetHash());
+        addedTxids.insert(ptx->GetHash());
     }
+    Compact();
     return true;
 }
 
 bool CTxMemCache::RemoveBlockTx(const CBlock &block) {
     for (auto &ptx : block.vptx) {
-        txids.erase(ptx->GetHash());
+        addedTxids.erase(ptx->GetHash());
+        removedTxids.insert(ptx->GetHash());
     }
+    Compact();
     return true;
 }
 
-bool CTxMemCache::HaveTx(const uint256 &txid) {
-    bool found = txids.count(txid) > 0;
-    if (found)
+bool CTxMemCache::HaveTx(const uint256 &txid) const {
+    if (addedTxids.count(txid))
         return true;
-    else if (pBase == nullptr) {
+    else if (removedTxids.count(txid))
         return false;
-    } else
-        return pBase->HaveTx(txid);
+    else if (spSharedTxids && spSharedTxids->count(txid))
+        return true;
+    else
+        return pBase != nullptr && !fBaseReplaced && pBase->HaveTx(txid);
 }
 
 void CTxMemCache::BatchWrite(const UnorderedHashSet &txidsIn) {
-    txids.clear();
+    // the txids of the child replace all the txids of the cache, the ones of its base are not looked up any more
+    Clear();
+    addedTxids    = txidsIn;
+    fBaseReplaced = true;
+    Compact();
+}
+
+void CTxMemCache::Compact() {
+    // the removed txids of a child cache hide the txids of its base
+    if (pBase != nullptr)
+        return;
+
+    size_t sharedSize = spSharedTxids ? spSharedTxids->size() : 0;
+    if (addedTxids.size() + removedTxids.size() < std::max(MIN_TX_CACHE_COMPACT_SIZE, sharedSize / 8))
+        return;
 
-    for (const auto &txid : txidsIn) {
-        txids.insert(txid);
+    auto spTxids = spSharedTxids ? std::make_shared<UnorderedHashSet>(*spSharedTxids)
+                                 : std::make_shared<UnorderedHashSet>();
+    for (const auto &txid : removedTxids) {
+        spTxids->erase(txid);
     }
+    spTxids->insert(addedTxids.begin(), addedTxids.end());
+
+    spSharedTxids = spTxids;
+    addedTxids.clear();
+    removedTxids.clear();
 }
 
 void CTxMemCache::Flush() {
-    assert(pBase);
+    assert(pBase && !spSharedTxids);
+
+    pBase->BatchWrite(addedTxids);
+    addedTxids.clear();
+    removedTxids.clear();
+}
 
-    pBase->BatchWrite(txids);
-    txids.clear();
+void CTxMemCache::Clear() {
+    spSharedTxids = nullptr;
+    addedTxids.clear();
+    removedTxids.clear();
 }
 
-void CTxMemCache::Clear() { txids.clear(); }
+void CTxMemCache::GetTxids(UnorderedHashSet &txidsOut) const {
+    if (pBase != nullptr && !fBaseReplaced)
+        pBase->GetTxids(txidsOut);
 
-uint64_t CTxMemCache::GetSize() { return txids.size(); }
+    if (spSharedTxids)
+        txidsOut.insert(spSharedTxids->begin(), spSharedTxids->end());
+
+    for (const auto &txid : removedTxids) {
+        txidsOut.erase(txid);
+    }
+    txidsOut.insert(addedTxids.begin(), addedTxids.end());
+}
+
+void CTxMemCache::SetTxids(const UnorderedHashSet &txidsIn) {
+    assert(pBase == nullptr);
+
+    Clear();
+    spSharedTxids = std::make_shared<UnorderedHashSet>(txidsIn);
+}
+
+uint64_t CTxMemCache::GetSize() const {
+    UnorderedHashSet txids;
+    GetTxids(txids);
+    return txids.size();
+}
 
 Object CTxMemCache::ToJsonObj() const {
+    UnorderedHashSet txids;
+    GetTxids(txids);
+
     Array txArray;
     for (auto &txid : txids) {
         txArray.push_back(txid.ToString());
@@ -20,13 +20,18 @@
 using namespace std;
 using namespace json_spirit;
 
+/**
+ * The txids of the recent blocks. The bulk of them is an immutable set shared by the copies of the cache, e.g. the
+ * snapshots of the chain state, so a copy only owns the txids added or removed since the shared set was built. A
+ * child cache owns the txids changed above its base, and writes them to the base by Flush().
+ */
 class CTxMemCache {
 public:
     CTxMemCache() : pBase(nullptr) {}
     CTxMemCache(CTxMemCache *pBaseIn) : pBase(pBaseIn) {}
 
 public:
-    bool HaveTx(const uint256 &txid);
+    bool HaveTx(const uint256 &txid) const;
 
     bool AddBlockTx(const CBlock &block);
     bool RemoveBlockTx(const CBlock &block);
@@ -36,16 +41,23 @@ public:
     void Flush();
 
     Object ToJsonObj() const;
-    uint64_t GetSize();
+    uint64_t GetSize() const;
+
+    void GetTxids(UnorderedHashSet &txidsOut) const;
+    // Replace the txids of a cache without base, e.g. by the ones read from the mem cache file
+    void SetTxids(const UnorderedHashSet &txidsIn);
 
 private:
-    bool HaveBlock(const uint256 &blockHash) const;
-    bool HaveBlock(const CBlock &block);
-    void BatchWrite(const UnorderedHashSet &mapBlockTxHashSetIn);
+    void BatchWrite(const UnorderedHashSet &txidsIn);
+    // Merge the changed txids into a new shared set once they are too many to be copied cheaply
+    void Compact();
 
 private:
-    UnorderedHashSet txids;
+    std::shared_ptr<const UnorderedHashSet> spSharedTxids;  // never changed once shared
+    UnorderedHashSet addedTxids;
+    UnorderedHashSet removedTxids;  // hide the txids of the shared set and the base
     CTxMemCache *pBase;
+    bool fBaseReplaced = false;     // a child is flushed, its txids replace the ones of the base
 };
 
 #endif // PERSIST_TXDB_H
\ No newline at end of file
@@ -33,8 +33,16 @@ public:
 
     void SetBaseViewPtr(CTxReceiptDBCache *pBaseIn) { txReceiptCache.SetBase(&pBaseIn->txReceiptCache); }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) { txReceiptCache.SetDbAccess(pDbAccessIn); }
+
+    void SetFrozenBase(CTxReceiptDBCache *pBaseIn) { txReceiptCache.SetFrozenBase(&pBaseIn->txReceiptCache); }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) { txReceiptCache.SetDbOpLogMap(pDbOpLogMapIn); }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) { txReceiptCache.SetDbKeyTracker(pDbKeyTrackerIn); }
+
+    void DiscardData(const set<string> &dbKeys) { txReceiptCache.DiscardData(dbKeys); }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         txReceiptCache.RegisterUndoFunc(undoDataFuncMap);
     }
@@ -43,7 +51,7 @@ public:
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
     /////////// SysParamDB
     // txid -> vector<CReceipt>
-    CCompositeKVCache< dbk::TX_RECEIPT,            TxID,                   vector<CReceipt> >     txReceiptCache;
+    CHashKVCache<      dbk::TX_RECEIPT,            TxID,                   vector<CReceipt> >     txReceiptCache;
 };
 
 #endif // PERSIST_RECEIPTDB_H
\ No newline at end of file
@@ -34,8 +34,16 @@ public:
 
     void SetBaseViewPtr(CTxUTXODBCache *pBaseIn) { txUtxoCache.SetBase(&pBaseIn->txUtxoCache); }
 
+    void SetDbAccess(CDBAccess *pDbAccessIn) { txUtxoCache.SetDbAccess(pDbAccessIn); }
+
+    void SetFrozenBase(CTxUTXODBCache *pBaseIn) { txUtxoCache.SetFrozenBase(&pBaseIn->txUtxoCache); }
+
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) { txUtxoCache.SetDbOpLogMap(pDbOpLogMapIn); }
 
+    void SetDbKeyTracker(CDBKeyTracker *pDbKeyTrackerIn) { txUtxoCache.SetDbKeyTracker(pDbKeyTrackerIn); }
+
+    void DiscardData(const set<string> &dbKeys) { txUtxoCache.DiscardData(dbKeys); }
+
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         txUtxoCache.RegisterUndoFunc(undoDataFuncMap);
     }
@@ -244,6 +244,14 @@ Object SubmitTx(const CKeyID &keyid, CBaseTx &tx) {
     return obj;
 }
 
+std::shared_ptr<const CChainStateSnapshot> GetRpcChainStateSnapshot() {
+    auto spSnapshot = GetChainStateSnapshot();
+    if (!spSnapshot)
+        throw JSONRPCError(RPC_MISC_ERROR, "The chain state is not loaded yet");
+
+    return spSnapshot;
+}
+
 string RegIDToAddress(CUserID &userId) {
     CKeyID keyId;
     if (pCdMan->pAccountCache->GetKeyId(userId, keyId))
@@ -261,13 +269,11 @@ Object GetTxDetailJSON(const uint256& txid) {
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos postx;
             if (pCdMan->pBlockCache->ReadTxIndex(txid, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
                 CBlockHeader header;
+                if (!ReadTxFromBlockFile(postx, pBaseTx, &header))
+                    throw runtime_error(tfm::format("%s : Deserialize or I/O error", __func__).c_str());
 
                 try {
-                    file >> header;
-                    fseek(file, postx.nTxOffset, SEEK_CUR);
-                    file >> pBaseTx;
                     //obj = pBaseTx->IsMultiSignSupport()?pBaseTx->ToJsonMultiSign(*database):pBaseTx->ToJson(*pCdMan->pAccountCache);
                     obj = pBaseTx->ToJson(*pCdMan->pAccountCache);
 
@@ -569,6 +575,15 @@ bool RPC_PARAM::GetKeyId(const Value &jsonValue, CKeyID& keyid, const bool sende
     return !keyid.IsEmpty();
 }
 
+CKeyID RPC_PARAM::GetKeyId(const CAccountDBCache &accountCache, const Value &jsonValue) {
+    auto pUserId = CUserID::ParseUserId(jsonValue.get_str(), accountCache);
+    CKeyID keyid;
+    if (!pUserId || !accountCache.GetKeyId(*pUserId, keyid) || keyid.IsEmpty())
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+
+    return keyid;
+}
+
 CKeyID RPC_PARAM::GetUserKeyId(const CUserID &uid) {
     CKeyID keyid;
     pCdMan->pAccountCache->GetKeyId(uid, keyid);
@@ -25,6 +25,10 @@ Array GetTxAddressDetail(std::shared_ptr<CBaseTx> pBaseTx);
 
 Object SubmitTx(const CKeyID &keyid, CBaseTx &tx);
 
+struct CChainStateSnapshot;
+// The chain state read by the thread safe RPCs without cs_main, it throws before the chain state is loaded
+std::shared_ptr<const CChainStateSnapshot> GetRpcChainStateSnapshot();
+
 namespace JSON {
     const Value& GetObjectFieldValue(const Value &jsonObj, const string &fieldName);
     bool  GetObjectFieldValue(const Value &jsonObj, const string &fieldName,Value& returnValue);
@@ -56,6 +60,8 @@ namespace RPC_PARAM {
     bool GetKeyId(const Value &jsonValue, CKeyID& keid, const bool senderUid = false );
 
     CKeyID GetUserKeyId(const CUserID &userId);
+    // resolve the uid to its keyid by the account cache, e.g. the one of a chain state snapshot
+    CKeyID GetKeyId(const CAccountDBCache &accountCache, const Value &jsonValue);
 
     uint64_t GetPrice(const Value &jsonValue);
 
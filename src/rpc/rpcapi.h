@@ -125,6 +125,7 @@ extern Value ping(const json_spirit::Array& params, bool fHelp);
 extern Value addnode(const json_spirit::Array& params, bool fHelp);
 extern Value getaddednodeinfo(const json_spirit::Array& params, bool fHelp);
 extern Value getnettotals(const json_spirit::Array& params, bool fHelp);
+extern Value getmsgstats(const json_spirit::Array& params, bool fHelp);
 extern Value getchaininfo(const json_spirit::Array& params, bool fHelp);
 
 extern Value dumpprivkey(const json_spirit::Array& params, bool fHelp); // in rpcdump.cpp
@@ -236,5 +237,6 @@ extern Value getminminerfee(const Array& params, bool fHelp) ;
 
 // debug
 Value dumpdb(const Array& params, bool fHelp);
+Value getdbcachestats(const Array& params, bool fHelp);
 
 #endif /* RPC_API_H_ */
@@ -28,6 +28,7 @@ static const CRPCCommand vRPCCommands[] =
     { "getaddednodeinfo",               &getaddednodeinfo,                  true,      true,        false   },
     { "getconnectioncount",             &getconnectioncount,                true,      false,       false   },
     { "getnettotals",                   &getnettotals,                      true,      true,        false   },
+    { "getmsgstats",                    &getmsgstats,                       true,      true,        false   },
     { "getpeerinfo",                    &getpeerinfo,                       true,      false,       false   },
     { "ping",                           &ping,                              true,      false,       false   },
     { "getchaininfo",                   &getchaininfo,                      true,      false,       false   },
@@ -52,7 +53,7 @@ static const CRPCCommand vRPCCommands[] =
     { "genmulsigtx",                    &genmulsigtx,                       true,      false,       false   },
     /* uses wallet if enabled */
     { "addmulsigaddr",                  &addmulsigaddr,                     false,     false,       true    },
-    { "getaccountinfo",                 &getaccountinfo,                    true,      false,       true    },
+    { "getaccountinfo",                 &getaccountinfo,                    true,      true,        true    },
     { "getnewaddr",                     &getnewaddr,                        false,     false,       true    },
     { "gettxdetail",                    &gettxdetail,                       true,      false,       true    },
     { "getclosedcdp",                   &getclosedcdp,                      true,      false,       true    },
@@ -74,9 +75,9 @@ static const CRPCCommand vRPCCommands[] =
     { "listtx",                         &listtx,                            true,      false,       true    },
     { "setgenerate",                    &setgenerate,                       true,      true,        false   },
     { "listcontracts",                  &listcontracts,                     true,      false,       true    },
-    { "getcontractinfo",                &getcontractinfo,                   true,      false,       true    },
+    { "getcontractinfo",                &getcontractinfo,                   true,      true,        true    },
     { "listtxcache",                    &listtxcache,                       true,      false,       true    },
-    { "getcontractdata",                &getcontractdata,                   true,      false,       true    },
+    { "getcontractdata",                &getcontractdata,                   true,      true,        true    },
     { "signmessage",                    &signmessage,                       false,     false,       true    },
     { "verifymessage",                  &verifymessage,                     true,      false,       false   },
     { "getcoinunitinfo",                &getcoinunitinfo,                   true,      false,       false   },
@@ -118,8 +119,8 @@ static const CRPCCommand vRPCCommands[] =
     { "submitcdpredeemtx",              &submitcdpredeemtx,                 false,      false,      true    },
     { "submitcdpliquidatetx",           &submitcdpliquidatetx,              false,      false,      true    },
     { "getscoininfo",                   &getscoininfo,                      true,       false,      false   },
-    { "getcdp",                         &getcdp,                            true,       false,      false   },
-    { "getusercdp",                     &getusercdp,                        true,       false,      false   },
+    { "getcdp",                         &getcdp,                            true,       true,       false   },
+    { "getusercdp",                     &getusercdp,                        true,       true,       false   },
     { "getcdpcoinpairs",                &getcdpcoinpairs,                   true,       false,      false   },
 
     { "getsysparam",                    &getsysparam,                       true,       false,      false   },
@@ -136,9 +137,9 @@ static const CRPCCommand vRPCCommands[] =
     { "submitdexcancelordertx",         &submitdexcancelordertx,            false,      false,      false   },
     { "submitdexoperatorregtx",         &submitdexoperatorregtx,            false,      false,      false   },
     { "submitdexoperatorupdatetx",      &submitdexoperatorupdatetx,         false,      false,      false   },
-    { "getdexorder",                    &getdexorder,                       true,       false,      false   },
+    { "getdexorder",                    &getdexorder,                       true,       true,       false   },
     { "getdexsysorders",                &getdexsysorders,                   true,       false,      false   },
-    { "getdexorders",                   &getdexorders,                      true,       false,      false   },
+    { "getdexorders",                   &getdexorders,                      true,       true,       false   },
     { "getdexoperator",                 &getdexoperator,                    true,       false,      false   },
     { "getdexoperatorbyowner",          &getdexoperatorbyowner,             true,       false,      false   },
     { "getdexorderfee",                 &getdexorderfee,                    true,       false,      false   },
@@ -171,6 +172,7 @@ static const CRPCCommand vRPCCommands[] =
 
     /* debug */
     { "dumpdb",                         &dumpdb,                            true,       true,       true    },
+    { "getdbcachestats",                &getdbcachestats,                   true,       true,       false   },
 };
 
 #endif //RPC_APICONF_H_
\ No newline at end of file
@@ -667,9 +667,10 @@ Value getdexorder(const Array& params, bool fHelp) {
     }
     const uint256 &orderId = RPC_PARAM::GetTxid(params[0], "order_id");
 
-    auto pDexCache = pCdMan->pDexCache;
+    auto spSnapshot = GetRpcChainStateSnapshot();
+    CCacheWrapper cw(spSnapshot->spCw.get());
     CDEXOrderDetail orderDetail;
-    if (!pDexCache->GetActiveOrder(orderId, orderDetail))
+    if (!cw.dexCache.GetActiveOrder(orderId, orderDetail))
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("The order not exists or inactive! order_id=%s", orderId.ToString()));
 
     Object obj;
@@ -739,7 +740,9 @@ extern Value getdexorders(const Array& params, bool fHelp) {
         );
     }
 
-    int64_t tipHeight = chainActive.Height();
+    // the orders getter only reads the frozen snapshot, it needs no child cache
+    auto spSnapshot   = GetRpcChainStateSnapshot();
+    int64_t tipHeight = spSnapshot->height;
     int64_t beginHeight = 0;
     if (params.size() > 0)
         beginHeight = params[0].get_int64();
@@ -766,7 +769,11 @@ extern Value getdexorders(const Array& params, bool fHelp) {
     DEXBlockOrdersCache::KeyType lastKey;
     if (params.size() > 3) {
         string lastPosInfo = RPC_PARAM::GetBinStrFromHex(params[3], "last_pos_info");
-        auto err = DEX_DB::ParseLastPos(lastPosInfo, lastKey);
+        shared_ptr<string> err;
+        {
+            LOCK(cs_main);  // only for the block index of the last position
+            err = DEX_DB::ParseLastPos(lastPosInfo, lastKey);
+        }
         if (err)
             throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("Invalid last_pos_info! %s", *err));
         uint32_t lastHeight = DEX_DB::GetHeight(lastKey);
@@ -777,7 +784,7 @@ extern Value getdexorders(const Array& params, bool fHelp) {
                                          beginHeight, endHeight));
     }
 
-    auto pGetter = pCdMan->pDexCache->CreateOrdersGetter();
+    auto pGetter = spSnapshot->spCw->dexCache.CreateOrdersGetter();
     if (!pGetter->Execute(beginHeight, endHeight, maxCount, lastKey)) {
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("get all active orders error! begin_height=%d, end_height=%d",
             beginHeight, endHeight));
@@ -785,7 +792,11 @@ extern Value getdexorders(const Array& params, bool fHelp) {
 
     string newLastPosInfo;
     if (pGetter->has_more) {
-        auto err = DEX_DB::MakeLastPos(pGetter->last_key, newLastPosInfo);
+        shared_ptr<string> err;
+        {
+            LOCK(cs_main);
+            err = DEX_DB::MakeLastPos(pGetter->last_key, newLastPosInfo);
+        }
         if (err)
             throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("Make new last_pos_info error! %s", *err));
     }
@@ -257,12 +257,22 @@ Value verifymessage(const Array& params, bool fHelp) {
     DEFINE( TX_UTXO,              pUtxoCache,   txUtxoCache)
 
 
-template<int32_t PREFIX_TYPE, typename KeyType, typename ValueType>
-string DbCacheToString(CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> &cache) {
+template<int32_t PREFIX_TYPE, typename KeyType, typename ValueType, typename MapType>
+string DbCacheToString(CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType, MapType> &cache) {
+    typedef CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType, MapType> CacheType;
     string str;
-    CDBIterator< CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType> > it(cache);
-    for(it.First(); it.IsValid(); it.Next()) {
-        str += strprintf("%s={%s},\n", db_util::ToString(it.GetKey()), db_util::ToString(it.GetValue()));
+    if constexpr (CacheType::IS_ORDERED) {
+        CDBIterator<CacheType> it(cache);
+        for(it.First(); it.IsValid(); it.Next()) {
+            str += strprintf("%s={%s},\n", db_util::ToString(it.GetKey()), db_util::ToString(it.GetValue()));
+        }
+    } else {
+        // the hash map of the cache has no key order, merge the data of all levels into a sorted map
+        map<KeyType, ValueType> elements;
+        cache.GetAllElements(elements);
+        for (const auto &item : elements) {
+            str += strprintf("%s={%s},\n", db_util::ToString(item.first), db_util::ToString(item.second));
+        }
     }
     return strprintf("-->%s, data={%s}\n", GetKeyPrefix(cache.PREFIX_TYPE), str);
 }
@@ -299,6 +309,37 @@ static void DumpDbAll(FILE *f) {
     DBK_PREFIX_CACHE_LIST(DUMP_DB_ALL);
 }
 
+template<int32_t PREFIX_TYPE, typename KeyType, typename ValueType, typename MapType>
+void DbCacheStatsToJson(CCompositeKVCache<PREFIX_TYPE, KeyType, ValueType, MapType> &cache, Object &obj) {
+    const auto &missingKeys = cache.GetMissingKeys();
+    Object item;
+    item.push_back(Pair("cache_size",           (uint64_t)cache.GetCacheSize()));
+    item.push_back(Pair("missing_keys",         (uint64_t)missingKeys.GetKeyCount()));
+    item.push_back(Pair("missing_key_hits",     missingKeys.GetHits()));
+    item.push_back(Pair("missing_key_misses",   missingKeys.GetMisses()));
+
+    CDBAccess *pDbAccess = cache.GetDbAccessPtr();
+    if (pDbAccess != nullptr) {
+        CDbReadCache::PrefixStats stats = pDbAccess->GetReadCacheStats(cache.PREFIX_TYPE);
+        item.push_back(Pair("read_cache_budget",    stats.budget));
+        item.push_back(Pair("read_cache_size",      stats.size));
+        item.push_back(Pair("read_cache_count",     stats.count));
+        item.push_back(Pair("read_cache_hits",      stats.hits));
+        item.push_back(Pair("read_cache_misses",    stats.misses));
+    }
+    obj.push_back(Pair(GetKeyPrefix(cache.PREFIX_TYPE), item));
+}
+
+template<int32_t PREFIX_TYPE, typename ValueType>
+void DbCacheStatsToJson(CSimpleKVCache<PREFIX_TYPE, ValueType> &cache, Object &obj) {
+    // the single value cache has no missing keys
+}
+
+#define DB_CACHE_STATS_ONE(prefixType, db, cache) \
+    case dbk::prefixType: { DbCacheStatsToJson(pCdMan->db->cache, obj); break;}
+#define DB_CACHE_STATS_ALL(prefixType, db, cache) \
+    DbCacheStatsToJson(pCdMan->db->cache, obj);
+
 
 Value dumpdb(const Array& params, bool fHelp) {
     if (fHelp || params.size() > 2)
@@ -355,3 +396,51 @@ Value dumpdb(const Array& params, bool fHelp) {
 
     return Object();
 }
+
+Value getdbcachestats(const Array& params, bool fHelp) {
+    if (fHelp || params.size() > 1)
+        throw runtime_error(
+            "getdbcachestats \"[key_prefix_type]\"\n"
+            "\nget the stats of the db level caches\n"
+            "\nArguments:\n"
+            "1. \"key_prefix_type\"   (string, optional) the data key prefix type, * is all data, default is *\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"key_prefix\": {\n"
+            "    \"cache_size\": n,           (numeric) the size of the cached data\n"
+            "    \"missing_keys\": n,         (numeric) the count of the keys known missing in db\n"
+            "    \"missing_key_hits\": n,     (numeric) the lookups answered by the missing keys without reading db\n"
+            "    \"missing_key_misses\": n,   (numeric) the lookups which read db and found nothing\n"
+            "    \"read_cache_budget\": n,    (numeric) the memory budget of the deserialized data read cache\n"
+            "    \"read_cache_size\": n,      (numeric) the memory used by the read cache\n"
+            "    \"read_cache_count\": n,     (numeric) the count of the values in the read cache\n"
+            "    \"read_cache_hits\": n,      (numeric) the db reads answered by the read cache\n"
+            "    \"read_cache_misses\": n,    (numeric) the db reads missed by the read cache\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbcachestats", "") + "\nAs json rpc\n" + HelpExampleRpc("getdbcachestats", "")
+        );
+
+    string prefixTypeStr = "";
+    if (params.size() > 0)
+        prefixTypeStr = params[0].get_str();
+
+    Object obj;
+    LOCK(cs_main);
+    if (!prefixTypeStr.empty() && prefixTypeStr != "*") {
+        dbk::PrefixType prefixType = dbk::ParseKeyPrefixType(prefixTypeStr);
+        switch (prefixType) {
+            DBK_PREFIX_CACHE_LIST(DB_CACHE_STATS_ONE);
+            default :
+                throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("unsupported db data key prefix type=%s",
+                    prefixTypeStr));
+                break;
+        }
+    } else {
+        DBK_PREFIX_CACHE_LIST(DB_CACHE_STATS_ALL);
+    }
+
+    return obj;
+}
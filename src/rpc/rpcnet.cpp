@@ -8,6 +8,7 @@
 #include "main.h"
 #include "net.h"
 #include "netbase.h"
+#include "p2p/msgprecheck.h"
 #include "p2p/protocol.h"
 #include "sync.h"
 #include "commons/util/util.h"
@@ -322,6 +323,40 @@ Value getnettotals(const Array& params, bool fHelp) {
     return obj;
 }
 
+Value getmsgstats(const Array& params, bool fHelp) {
+    if (fHelp || params.size() > 0)
+        throw runtime_error(
+            "getmsgstats\n"
+            "\nReturns the processing time of the received p2p messages by command, in microseconds.\n"
+            "The messages of the commands not in the protocol are counted under \"unknown\".\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"command\": {\n"
+            "    \"count\": n,             (numeric) Number of the messages processed\n"
+            "    \"avgwaittime\": n,       (numeric) Average time from received to the start of the processing\n"
+            "    \"avgprechecktime\": n,   (numeric) Average time of the precheck on the precheck threads\n"
+            "    \"avgtime\": n,           (numeric) Average time of the processing on the message handler thread\n"
+            "    \"maxtime\": n            (numeric) Max. time of the processing on the message handler thread\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getmsgstats", "") + "\nAs json rpc\n" + HelpExampleRpc("getmsgstats", ""));
+
+    Object obj;
+    for (const auto &item : messageStats.GetStats()) {
+        const CMessageStats::CommandStats &stats = item.second;
+        Object cmdObj;
+        cmdObj.push_back(Pair("count",              stats.count));
+        cmdObj.push_back(Pair("avgwaittime",        stats.totalWaitTime / (int64_t)stats.count));
+        cmdObj.push_back(Pair("avgprechecktime",    stats.totalPrecheckTime / (int64_t)stats.count));
+        cmdObj.push_back(Pair("avgtime",            stats.totalTime / (int64_t)stats.count));
+        cmdObj.push_back(Pair("maxtime",            stats.maxTime));
+        obj.push_back(Pair(item.first, cmdObj));
+    }
+    return obj;
+}
+
 Value getnetworkinfo(const Array& params, bool fHelp) {
     if (fHelp || params.size() != 0)
         throw runtime_error(
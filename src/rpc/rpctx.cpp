@@ -806,7 +806,9 @@ Value getaccountinfo(const Array& params, bool fHelp) {
     }
 
     RPCTypeCheck(params, list_of(str_type));
-    CKeyID keyid = RPC_PARAM::GetKeyId(params[0]);
+    auto spSnapshot = GetRpcChainStateSnapshot();
+    CCacheWrapper cw(spSnapshot->spCw.get());
+    CKeyID keyid = RPC_PARAM::GetKeyId(cw.accountCache, params[0]);
     CUserID userId;
 
 
@@ -814,48 +816,50 @@ Value getaccountinfo(const Array& params, bool fHelp) {
     Object obj;
     bool found = false;
 
-    CAccount account;
-    if (pCdMan->pAccountCache->GetAccount(userId, account)) {
-        if (!account.owner_pubkey.IsValid()) {
-            CPubKey pubKey;
-            CPubKey minerPubKey;
-            if (pWalletMain->GetPubKey(keyid, pubKey)) {
-                pWalletMain->GetPubKey(keyid, minerPubKey, true);
-                account.owner_pubkey = pubKey;
-                account.keyid        = pubKey.GetKeyId();
-                if (pubKey != minerPubKey && !account.miner_pubkey.IsValid()) {
-                    account.miner_pubkey = minerPubKey;
-                }
-            }
-        }
-        obj = account.ToJsonObj();
-        obj.push_back(Pair("position", "inblock"));
-
-        found = true;
-    } else {  // unregistered keyid
-        CPubKey pubKey;
-        CPubKey minerPubKey;
+    // the rpc runs without cs_main, the account is read from the snapshot and the keys from the locked wallet
+    CPubKey pubKey;
+    CPubKey minerPubKey;
+    bool inWallet = false;
+    {
+        LOCK(pWalletMain->cs_wallet);
         if (pWalletMain->GetPubKey(keyid, pubKey)) {
             pWalletMain->GetPubKey(keyid, minerPubKey, true);
+            inWallet = true;
+        }
+    }
+
+    CAccount account;
+    if (cw.accountCache.GetAccount(userId, account)) {
+        if (!account.owner_pubkey.IsValid() && inWallet) {
             account.owner_pubkey = pubKey;
             account.keyid        = pubKey.GetKeyId();
-            if (minerPubKey != pubKey) {
+            if (pubKey != minerPubKey && !account.miner_pubkey.IsValid()) {
                 account.miner_pubkey = minerPubKey;
             }
-            obj = account.ToJsonObj();
-            obj.push_back(Pair("position", "inwallet"));
+        }
+        obj = account.ToJsonObj(cw, spSnapshot->height);
+        obj.push_back(Pair("position", "inblock"));
 
-            found = true;
+        found = true;
+    } else if (inWallet) {  // unregistered keyid
+        account.owner_pubkey = pubKey;
+        account.keyid        = pubKey.GetKeyId();
+        if (minerPubKey != pubKey) {
+            account.miner_pubkey = minerPubKey;
         }
+        obj = account.ToJsonObj(cw, spSnapshot->height);
+        obj.push_back(Pair("position", "inwallet"));
+
+        found = true;
     }
 
     if (found) {
         // TODO: multi stable coin
         uint64_t bcoinMedianPrice =
-            pCdMan->pBlockCache->GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
+            cw.blockCache.GetMedianPrice(CoinPricePair(SYMB::WICC, SYMB::USD));
         Array cdps;
         vector<CUserCDP> userCdps;
-        if (pCdMan->pCdpCache->GetCDPList(account.regid, userCdps)) {
+        if (cw.cdpCache.GetCDPList(account.regid, userCdps)) {
             for (auto& cdp : userCdps) {
                 cdps.push_back(cdp.ToJson(bcoinMedianPrice));
             }
@@ -971,12 +975,14 @@ Value getcontractinfo(const Array& params, bool fHelp) {
             HelpExampleRpc("getcontractinfo", "1-1"));
 
     CRegID regid(params[0].get_str());
-    if (regid.IsEmpty() || !pCdMan->pContractCache->HaveContract(regid)) {
+    auto spSnapshot = GetRpcChainStateSnapshot();
+    CCacheWrapper cw(spSnapshot->spCw.get());
+    if (regid.IsEmpty() || !cw.contractCache.HaveContract(regid)) {
         throw JSONRPCError(RPC_INVALID_PARAMS, "Invalid contract regid.");
     }
 
     CUniversalContract contract;
-    if (!pCdMan->pContractCache->GetContract(regid, contract)) {
+    if (!cw.contractCache.GetContract(regid, contract)) {
         throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to acquire contract from db.");
     }
 
@@ -1067,7 +1073,9 @@ Value getcontractdata(const Array& params, bool fHelp) {
         key = params[1].get_str();
     }
     string value;
-    if (!pCdMan->pContractCache->GetContractData(regId, key, value)) {
+    auto spSnapshot = GetRpcChainStateSnapshot();
+    CCacheWrapper cw(spSnapshot->spCw.get());
+    if (!cw.contractCache.GetContractData(regId, key, value)) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Failed to acquire contract data");
     }
 
@@ -48,3 +48,82 @@ void CSignatureCache::Set(const uint256& sigHash, const std::vector<unsigned cha
 
     setValid.insert(entry);
 }
+
+void CSignatureCheckQueue::Start(int32_t nThreads) {
+    Stop();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    fQuit = false;
+    for (int32_t i = 0; i < nThreads; i++) {
+        threads.emplace_back([this]() {
+            RenameThread("coin-sigcheck");
+            Loop(false);
+        });
+    }
+}
+
+void CSignatureCheckQueue::Stop() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        fQuit = true;
+    }
+    condWorker.notify_all();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+}
+
+void CSignatureCheckQueue::Verify(std::vector<CSignatureCheck>& checks) {
+    if (checks.empty()) return;
+
+    std::unique_lock<std::mutex> verifyLock(mtxVerify);
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        pChecks = &checks;
+        nNext   = 0;
+        nTodo   = checks.size();
+    }
+    condWorker.notify_all();
+
+    Loop(true);
+}
+
+void CSignatureCheckQueue::Loop(bool fMaster) {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        if (fMaster) {
+            if (nNext >= pChecks->size()) {
+                // nothing left to take, wait for the checks still running on the workers
+                condMaster.wait(lock, [this]() { return nTodo == 0; });
+                pChecks = nullptr;
+                return;
+            }
+        } else {
+            condWorker.wait(lock, [this]() { return fQuit || (pChecks != nullptr && nNext < pChecks->size()); });
+            if (fQuit) return;
+        }
+
+        // Take a part of the remaining checks, small enough to balance the load over all threads.
+        std::vector<CSignatureCheck>& checks = *pChecks;
+        size_t nRemain = checks.size() - nNext;
+        size_t nBatch  = std::max<size_t>(1, std::min(MAX_BATCH_SIZE, nRemain / (threads.size() + 1)));
+        size_t begin   = nNext;
+        size_t end     = begin + nBatch;
+        nNext          = end;
+        lock.unlock();
+
+        for (size_t i = begin; i < end; i++) {
+            const CSignatureCheck& check = checks[i];
+            if (!cache.Get(check.sigHash, check.signature, check.pubKey) &&
+                check.pubKey.Verify(check.sigHash, check.signature)) {
+                cache.Set(check.sigHash, check.signature, check.pubKey);
+            }
+        }
+
+        lock.lock();
+        nTodo -= nBatch;
+        if (nTodo == 0) condMaster.notify_one();
+    }
+}
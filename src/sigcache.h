@@ -7,7 +7,9 @@
 #ifndef COIN_SIGCACHE_H
 #define COIN_SIGCACHE_H
 
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include "config/chainparams.h"
@@ -17,6 +19,11 @@
 #include "commons/uint256.h"
 #include "commons/util/util.h"
 
+/** Maximum number of signature verification threads */
+static const int32_t MAX_SIG_CHECK_THREADS = 16;
+/** -par default (number of signature verification threads, 0 = auto) */
+static const int32_t DEFAULT_SIG_CHECK_THREADS = 0;
+
 /**
  * Valid signature cache, to avoid doing expensive ECDSA signature checking
  * twice for every transaction (once when accepted into memory pool, and
@@ -41,4 +48,52 @@ private:
                       const std::vector<unsigned char>& vchSig, const CPubKey& pubKey);
 };
 
+/** A signature waiting for verification */
+struct CSignatureCheck {
+    uint256 sigHash;
+    std::vector<unsigned char> signature;
+    CPubKey pubKey;
+
+    CSignatureCheck() {}
+    CSignatureCheck(const uint256& sigHashIn, const std::vector<unsigned char>& signatureIn, const CPubKey& pubKeyIn)
+        : sigHash(sigHashIn), signature(signatureIn), pubKey(pubKeyIn) {}
+};
+
+/**
+ * Queue to verify a batch of signatures on a pool of worker threads, the calling
+ * thread joins the work as well. The valid signatures are put into the signature
+ * cache, the invalid ones are left to the serial check which reports the error.
+ */
+class CSignatureCheckQueue {
+private:
+    CSignatureCache& cache;
+    std::vector<std::thread> threads;
+
+    std::mutex mtxVerify;  // only one batch is verified at a time
+    std::mutex mtx;
+    std::condition_variable condWorker;
+    std::condition_variable condMaster;
+    std::vector<CSignatureCheck>* pChecks = nullptr;
+    size_t nNext = 0;  // index of the next check to take
+    size_t nTodo = 0;  // count of the checks not finished yet
+    bool fQuit   = false;
+
+public:
+    //! Maximum count of checks a thread takes at a time
+    static const size_t MAX_BATCH_SIZE = 16;
+
+    explicit CSignatureCheckQueue(CSignatureCache& cacheIn) : cache(cacheIn) {}
+    ~CSignatureCheckQueue() { Stop(); }
+
+    void Start(int32_t nThreads);
+    void Stop();
+    bool IsEnabled() const { return !threads.empty(); }
+
+    //! Verify the checks and return when all of them are finished
+    void Verify(std::vector<CSignatureCheck>& checks);
+
+private:
+    void Loop(bool fMaster);
+};
+
 #endif  // COIN_SIGCACHE_H
\ No newline at end of file
@@ -0,0 +1,83 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <memory>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "p2p/compactblock.h"
+#include "tx/blockrewardtx.h"
+#include "tx/cointransfertx.h"
+#include "tx/txmempool.h"
+#include "tx/txserializer.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(compactblock_tests)
+
+// a block of a reward tx and the transfer txs
+static CBlock CreateBlock(uint32_t txCount) {
+    CBlock block;
+    block.SetHeight(100);
+    block.vptx.push_back(std::make_shared<CBlockRewardTx>());
+    for (uint32_t i = 1; i < txCount; i++) {
+        block.vptx.push_back(std::make_shared<CBaseCoinTransferTx>(CRegID(10, i), CRegID(20, i), 100, i * 1000,
+                                                                   10000, ""));
+    }
+    block.SetMerkleRootHash(block.BuildMerkleTree());
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_rebuild_test)
+{
+    CBlock block = CreateBlock(5);
+
+    // the keys of the short txids are restored by the deserialization
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << CCompactBlock(block);
+    CCompactBlock cmpctBlock;
+    ss >> cmpctBlock;
+    BOOST_CHECK(cmpctBlock.prefilledTxs.size() == 1 && cmpctBlock.shortTxIds.size() == 4);
+    BOOST_CHECK(cmpctBlock.GetShortTxId(block.vptx[1]->GetHash()) == cmpctBlock.shortTxIds[0]);
+
+    // the txs in the pool are filled, the others are missing
+    CTxMemPool pool;
+    for (uint32_t i : {1, 3}) {
+        pool.memPoolTxs.emplace(block.vptx[i]->GetHash(), CTxMemPoolEntry(block.vptx[i].get(), 0, 100));
+    }
+
+    CPartialBlock partialBlock;
+    BOOST_CHECK(partialBlock.Init(cmpctBlock, pool) == COMPACT_BLOCK_OK);
+    BOOST_CHECK(partialBlock.GetMissingIndexes() == vector<uint32_t>({2, 4}));
+
+    CPartialBlock wrongBlock = partialBlock;
+    BOOST_CHECK(wrongBlock.FillMissingTxs({block.vptx[2]}) == COMPACT_BLOCK_INVALID);
+    BOOST_CHECK(wrongBlock.FillMissingTxs({block.vptx[4], block.vptx[2]}) == COMPACT_BLOCK_OK);
+    CBlock rebuiltBlock;
+    BOOST_CHECK(wrongBlock.GetBlock(rebuiltBlock) == COMPACT_BLOCK_FAILED);
+
+    BOOST_CHECK(partialBlock.FillMissingTxs({block.vptx[2], block.vptx[4]}) == COMPACT_BLOCK_OK);
+    BOOST_CHECK(partialBlock.GetBlock(rebuiltBlock) == COMPACT_BLOCK_OK);
+    BOOST_CHECK(rebuiltBlock.GetHash() == block.GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(compact_block_invalid_test)
+{
+    CTxMemPool pool;
+    CCompactBlock cmpctBlock(CreateBlock(3));
+    CPartialBlock partialBlock;
+
+    // a prefilled tx out of the block
+    CCompactBlock badBlock = cmpctBlock;
+    badBlock.prefilledTxs[0].index = 3;
+    BOOST_CHECK(partialBlock.Init(badBlock, pool) == COMPACT_BLOCK_INVALID);
+
+    // a short txid collision needs the full block
+    badBlock = cmpctBlock;
+    badBlock.shortTxIds[1] = badBlock.shortTxIds[0];
+    BOOST_CHECK(partialBlock.Init(badBlock, pool) == COMPACT_BLOCK_FAILED);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,7 +8,12 @@
 #include <vector>
 #include <map>
 #include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include "persistence/blockdb.h"
 #include "persistence/dbaccess.h"
+#include "persistence/disk.h"
+#include "persistence/txdb.h"
+#include "tx/cointransfertx.h"
 
 using namespace std;
 
@@ -60,6 +65,148 @@ BOOST_AUTO_TEST_CASE(dbaccess_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(dbaccess_deferred_write_test)
+{
+    bool isWipe = true;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    map<string, string> mapData;
+    mapData["regid-1"] = "keyid-1";
+    mapData["regid-2"] = "keyid-2";
+    pDBAccess->BatchWrite<string, string>(prefix, mapData);
+
+    pDBAccess->BeginDeferredWrite();
+    map<string, string> mapDeferred;
+    mapDeferred["regid-1"] = "";  // erase
+    mapDeferred["regid-3"] = "keyid-3";
+    pDBAccess->BatchWrite<string, string>(prefix, mapDeferred);
+    pDBAccess->EndDeferredWrite();
+
+    // the deferred data is readable before written
+    string value;
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-1"), value));
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-3"), value) && value == "keyid-3");
+
+    BOOST_CHECK(pDBAccess->WriteDeferred());
+
+    map<string, string> elements;
+    set<string> expiredKeys;
+    BOOST_CHECK(pDBAccess->GetAllElements(prefix, expiredKeys, elements));
+    BOOST_CHECK(elements.size() == 2 && elements["regid-2"] == "keyid-2" && elements["regid-3"] == "keyid-3");
+}
+
+BOOST_AUTO_TEST_CASE(dbaccess_snapshot_test)
+{
+    bool isWipe = true;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    map<string, string> mapData;
+    mapData["regid-1"] = "keyid-1";
+    mapData["regid-2"] = "keyid-2";
+    pDBAccess->BatchWrite<string, string>(prefix, mapData);
+
+    // the snapshot taken before the deferred data is written
+    pDBAccess->BeginDeferredWrite();
+    map<string, string> mapDeferred;
+    mapDeferred["regid-1"] = "";  // erase
+    mapDeferred["regid-3"] = "keyid-3";
+    pDBAccess->BatchWrite<string, string>(prefix, mapDeferred);
+    pDBAccess->EndDeferredWrite();
+    shared_ptr<CDBAccess> pSnapshot = pDBAccess->NewSnapshot();
+
+    BOOST_CHECK(pDBAccess->WriteDeferred());
+    mapData.clear();
+    mapData["regid-2"] = "keyid-22";
+    pDBAccess->BatchWrite<string, string>(prefix, mapData);
+
+    // the snapshot keeps the deferred data, but not the data written after it
+    string value;
+    BOOST_CHECK(!pSnapshot->GetData(prefix, string("regid-1"), value));
+    BOOST_CHECK(pSnapshot->GetData(prefix, string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(pSnapshot->GetData(prefix, string("regid-3"), value) && value == "keyid-3");
+    map<string, string> elements;
+    set<string> expiredKeys;
+    BOOST_CHECK(pSnapshot->GetAllElements(prefix, expiredKeys, elements));
+    BOOST_CHECK(elements.size() == 2 && elements["regid-2"] == "keyid-2" && elements["regid-3"] == "keyid-3");
+
+    // the frozen cache of the snapshot is read through the child caches, which don't change it
+    CCompositeKVCache<prefix, string, string> frozenCache(pDBAccess.get());
+    frozenCache.SetDbAccess(pSnapshot.get());
+    BOOST_CHECK(frozenCache.IsFrozen());
+    CCompositeKVCache<prefix, string, string> cache(&frozenCache);
+    BOOST_CHECK(cache.GetData(string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(!cache.GetData(string("regid-1"), value));
+    BOOST_CHECK(frozenCache.GetMapData().empty());
+}
+
+BOOST_AUTO_TEST_CASE(dbaccess_read_cache_test)
+{
+    bool isWipe = true;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    pDBAccess->SetReadCacheSize(1 << 20);
+    BOOST_CHECK(pDBAccess->GetReadCacheStats(prefix).budget == (1 << 20) * GetDbReadCacheShare(prefix) / 1000);
+    BOOST_CHECK(pDBAccess->GetReadCacheStats(dbk::CDP).budget == 0);  // not the prefix of the account db
+
+    map<string, string> mapData;
+    mapData["regid-1"] = "keyid-1";
+    mapData["regid-2"] = "keyid-2";
+    pDBAccess->BatchWrite<string, string>(prefix, mapData);
+
+    // the written values are read from the read cache
+    string value;
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-1");
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-3"), value));
+    CDbReadCache::PrefixStats stats = pDBAccess->GetReadCacheStats(prefix);
+    BOOST_CHECK(stats.count == 2 && stats.hits == 1 && stats.misses == 1);
+
+    // the overwritten and erased values are updated
+    mapData["regid-1"] = "keyid-11";
+    mapData["regid-2"] = "";
+    pDBAccess->BatchWrite<string, string>(prefix, mapData);
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-11");
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-2"), value));
+    BOOST_CHECK(pDBAccess->GetReadCacheStats(prefix).count == 1);
+
+    // the budget 0 disables the read cache
+    pDBAccess->SetReadCacheSize(0);
+    BOOST_CHECK(pDBAccess->GetReadCacheStats(prefix).count == 0);
+    BOOST_CHECK(pDBAccess->GetData(prefix, string("regid-1"), value) && value == "keyid-11");
+}
+
+BOOST_AUTO_TEST_CASE(db_op_log_test)
+{
+    // the op log keeps the serialized format of the undo files
+    CKeyID keyId(uint160S("0x0102030405060708090a0b0c0d0e0f1011121314"));
+    pair<string, uint64_t> value = make_pair(string("keyid-1"), 100);
+    CDbOpLog opLog;
+    opLog.Set(keyId, value);
+
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION), ssValue(SER_DISK, CLIENT_VERSION);
+    ssKey << keyId;
+    ssValue << value;
+    BOOST_CHECK(opLog.GetKey() == ssKey.str() && opLog.GetValue() == ssValue.str());
+
+    CKeyID keyIdOut;
+    pair<string, uint64_t> valueOut;
+    opLog.Get(keyIdOut, valueOut);
+    BOOST_CHECK(keyIdOut == keyId && valueOut == value);
+
+    // the set op log is reusable
+    opLog.Set(string("regid-1"));
+    string strOut;
+    opLog.Get(strOut);
+    BOOST_CHECK(strOut == "regid-1");
+
+    // reading past the end of the data fails
+    uint256 hashOut;
+    BOOST_CHECK_THROW(opLog.Get(hashOut), std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -181,4 +328,408 @@ BOOST_AUTO_TEST_CASE(dbcache_cache_size_test)
     BOOST_CHECK(!pDBCache2->IsCalcSize() && pDBCache2->GetCacheSize() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_key_tracker_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->SetData("regid-2", "keyid-2");
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    auto pDBCache3 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache2.get());
+    CDBKeyTracker tracker;
+    pDBCache3->SetDbKeyTracker(&tracker);
+
+    string value;
+    BOOST_CHECK(pDBCache3->GetData(string("regid-1"), value));
+    BOOST_CHECK(!pDBCache3->GetData(string("regid-4"), value));
+    pDBCache3->SetData("regid-3", "keyid-3");
+    BOOST_CHECK(tracker.accessedKeys.size() == 3 && tracker.writtenKeys.size() == 1);
+    BOOST_CHECK(tracker.writtenKeys.count(dbk::GenDbKey(prefix, string("regid-3"))));
+    BOOST_CHECK(tracker.accessedKeys.count(dbk::GenDbKey(prefix, string("regid-4"))));
+    pDBCache3->Flush();
+
+    // the base changed, the discarded data is read from the base again
+    pDBCache1->SetData("regid-1", "keyid-1-new");
+    pDBCache1->SetData("regid-2", "keyid-2-new");
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1");
+    pDBCache2->DiscardData({dbk::GenDbKey(prefix, string("regid-1"))});
+    BOOST_CHECK(pDBCache2->GetData(string("regid-1"), value) && value == "keyid-1-new");
+    BOOST_CHECK(pDBCache2->GetData(string("regid-3"), value) && value == "keyid-3");
+}
+
+// Write the keys through 3 levels of caches, then read them from a new top level cache, return the time used in us.
+template <typename CacheType>
+static int64_t RunCacheLevel3(CDBAccess *pDBAccess, const vector<CKeyID> &keys) {
+    int64_t nStart = GetTimeMicros();
+    CacheType cache1(pDBAccess);
+    CacheType cache2(&cache1);
+    {
+        CacheType cache3(&cache2);
+        for (const auto &key : keys)
+            cache3.SetData(key, key.ToString());
+        cache3.Flush();
+    }
+    for (int32_t round = 0; round < 10; round++) {
+        CacheType cache3(&cache2);
+        string value;
+        for (const auto &key : keys)
+            BOOST_CHECK(cache3.GetData(key, value) && value == key.ToString());
+        for (size_t i = 0; i < keys.size(); i += 2)
+            cache3.EraseData(keys[i]);
+        BOOST_CHECK(!cache3.GetData(keys[0], value) && cache3.GetData(keys[1], value));
+    }
+    cache2.Flush();
+    cache1.Flush();
+    return GetTimeMicros() - nStart;
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_flat_hash_map_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::KEYID_ACCOUNT;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    vector<CKeyID> keys;
+    for (int32_t i = 0; i < 20000; i++)
+        keys.push_back(CKeyID(Hash160(ParseHex(strprintf("%08x", i)))));
+
+    int64_t mapTime  = RunCacheLevel3< CCompositeKVCache<prefix, CKeyID, string> >(pDBAccess.get(), keys);
+    int64_t hashTime = RunCacheLevel3< CHashKVCache<prefix, CKeyID, string> >(pDBAccess.get(), keys);
+    BOOST_TEST_MESSAGE(strprintf("cache level3 of %u keys: std::map %.2fms, flat hash map %.2fms", keys.size(),
+                                 0.001 * mapTime, 0.001 * hashTime));
+
+    // the data flushed through the hash map caches is the same
+    CHashKVCache<prefix, CKeyID, string> cache(pDBAccess.get());
+    map<CKeyID, string> elements;
+    BOOST_CHECK(cache.GetAllElements(elements) && elements.size() == keys.size() / 2);
+    BOOST_CHECK(!elements.count(keys[0]) && elements[keys[1]] == keys[1].ToString());
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_missing_keys_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    CCompositeKVCache<prefix, string, string> cache1(pDBAccess.get());
+    CCompositeKVCache<prefix, string, string> cache2(&cache1);
+    const auto &missingKeys = cache1.GetMissingKeys();
+
+    // the repeated lookups of a missing key read db only once
+    string value;
+    BOOST_CHECK(!cache1.GetData("regid-1", value));
+    BOOST_CHECK(!cache1.HaveData("regid-1"));
+    BOOST_CHECK(!cache2.GetData("regid-1", value));
+    BOOST_CHECK(missingKeys.GetMisses() == 1 && missingKeys.GetHits() == 2 && missingKeys.GetKeyCount() == 1);
+
+    // the key set by the child cache is found before and after flushed to db
+    BOOST_CHECK(cache2.SetData("regid-1", "keyid-1") && missingKeys.GetHits() == 3);
+    cache2.Flush();
+    BOOST_CHECK(cache1.GetData("regid-1", value) && value == "keyid-1");
+    cache1.Flush();
+    BOOST_CHECK(missingKeys.GetKeyCount() == 0);
+    BOOST_CHECK(cache1.GetData("regid-1", value) && value == "keyid-1");
+
+    // the erased key is missing after flushed to db
+    BOOST_CHECK(cache1.EraseData("regid-1"));
+    cache1.Flush();
+    BOOST_CHECK(missingKeys.GetKeyCount() == 1);
+    BOOST_CHECK(!cache1.GetData("regid-1", value) && !pDBAccess->GetData(prefix, string("regid-1"), value));
+    BOOST_CHECK(missingKeys.GetMisses() == 1 && missingKeys.GetHits() == 4);
+
+    // the copy of the cache starts with no missing keys
+    CCompositeKVCache<prefix, string, string> cacheCopy = cache1;
+    BOOST_CHECK(cacheCopy.GetMissingKeys().GetKeyCount() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_missing_keys_parallel_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+    CCompositeKVCache<prefix, string, string> cache1(pDBAccess.get());
+
+    // the child caches of the parallel tx executions look up the missing keys of the same db level cache
+    const int32_t threads = 4, keyCount = 500;
+    boost::thread_group lookups;
+    for (int32_t t = 0; t < threads; t++) {
+        lookups.create_thread([&, t]() {
+            CCompositeKVCache<prefix, string, string> cache2(&cache1);
+            string value;
+            for (int32_t round = 0; round < 2; round++) {
+                for (int32_t i = 0; i < keyCount; i++)
+                    cache2.GetData(strprintf("regid-%d-%d", t, i), value);
+            }
+        });
+    }
+    lookups.join_all();
+
+    const auto &missingKeys = cache1.GetMissingKeys();
+    BOOST_CHECK(missingKeys.GetKeyCount() == threads * keyCount);
+    BOOST_CHECK(missingKeys.GetMisses() == threads * keyCount && missingKeys.GetHits() == threads * keyCount);
+}
+
+BOOST_AUTO_TEST_CASE(dbcache_frozen_layer_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    CCompositeKVCache<prefix, string, string> cache(pDBAccess.get());
+    cache.SetData("regid-1", "keyid-1");
+    cache.SetData("regid-2", "keyid-2");
+    cache.Flush();
+    cache.SetData("regid-3", "keyid-3");
+
+    // the frozen copy of the cache and the db snapshot
+    shared_ptr<CDBAccess> pSnapshot = pDBAccess->NewSnapshot();
+    CCompositeKVCache<prefix, string, string> frozenCache = cache;
+    frozenCache.SetDbAccess(pSnapshot.get());
+
+    // the changes of a block in a child cache, frozen as a layer above the frozen copy
+    CCompositeKVCache<prefix, string, string> blockCache(&cache);
+    blockCache.EraseData("regid-1");
+    blockCache.SetData("regid-4", "keyid-4");
+    CCompositeKVCache<prefix, string, string> layer = blockCache;
+    layer.SetFrozenBase(&frozenCache);
+    blockCache.Flush();
+    cache.SetData("regid-2", "keyid-22");
+    cache.Flush();
+    BOOST_CHECK(layer.IsFrozen() && !blockCache.IsFrozen());
+
+    // the reader of the layer sees the chain state of the block only
+    CCompositeKVCache<prefix, string, string> reader(&layer);
+    string value;
+    BOOST_CHECK(!reader.GetData(string("regid-1"), value));
+    BOOST_CHECK(reader.GetData(string("regid-2"), value) && value == "keyid-2");
+    BOOST_CHECK(reader.GetData(string("regid-3"), value) && value == "keyid-3");
+    BOOST_CHECK(reader.GetData(string("regid-4"), value) && value == "keyid-4");
+    map<string, string> elements;
+    BOOST_CHECK(reader.GetAllElements(elements) && elements.size() == 3 && !elements.count("regid-1"));
+    BOOST_CHECK(layer.GetMapData().size() == 2 && frozenCache.GetMapData().size() == 1);
+}
+
+// a block of the coin transfer txs
+static CBlock CreateTransferBlock(int32_t height, int32_t txCount) {
+    CBlock block;
+    block.SetHeight(height);
+    for (int32_t i = 0; i < txCount; i++) {
+        block.vptx.push_back(std::make_shared<CBaseCoinTransferTx>(CRegID(10, i), CRegID(20, i), 100,
+                                                                   height * 10000 + i, 10000, ""));
+    }
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(tx_mem_cache_test)
+{
+    vector<CBlock> blocks;
+    for (int32_t height = 1; height <= 20; height++)
+        blocks.push_back(CreateTransferBlock(height, 100));
+
+    CTxMemCache txCache;
+    for (const auto &block : blocks)
+        txCache.AddBlockTx(block);
+    txCache.RemoveBlockTx(blocks[0]);
+    BOOST_CHECK(txCache.GetSize() == 1900);
+
+    // the child cache hides the removed txids of its base, its txids replace the ones of its base after flushed
+    CTxMemCache childCache(&txCache);
+    childCache.RemoveBlockTx(blocks[1]);
+    childCache.AddBlockTx(blocks[0]);
+    BOOST_CHECK(!childCache.HaveTx(blocks[1].vptx[0]->GetHash()) && txCache.HaveTx(blocks[1].vptx[0]->GetHash()));
+    BOOST_CHECK(childCache.HaveTx(blocks[0].vptx[0]->GetHash()) && childCache.GetSize() == 1900);
+
+    // the copy is not changed by its origin
+    CTxMemCache copyCache = txCache;
+    childCache.Flush();
+    BOOST_CHECK(txCache.HaveTx(blocks[0].vptx[0]->GetHash()) && !txCache.HaveTx(blocks[1].vptx[0]->GetHash()));
+    BOOST_CHECK(!txCache.HaveTx(blocks[19].vptx[99]->GetHash()) && txCache.GetSize() == 100);
+    BOOST_CHECK(!copyCache.HaveTx(blocks[0].vptx[0]->GetHash()) && copyCache.HaveTx(blocks[1].vptx[0]->GetHash()));
+
+    // the base of a flushed cache is not looked up any more
+    CTxMemCache forkCache(&copyCache);
+    CTxMemCache forkChildCache(&forkCache);
+    forkChildCache.AddBlockTx(blocks[0]);
+    forkChildCache.Flush();
+    BOOST_CHECK(forkCache.HaveTx(blocks[0].vptx[0]->GetHash()) && !forkCache.HaveTx(blocks[19].vptx[99]->GetHash()));
+    BOOST_CHECK(forkCache.GetSize() == 100 && copyCache.GetSize() == 1900);
+}
+
+// Create a fork view of a chain state, and disconnect 10 blocks on it. The chain state has 20000 keys cached and the
+// txids of 500 blocks, the fork view is a deep copy of it or a child of its frozen copy.
+BOOST_AUTO_TEST_CASE(dbcache_fork_view_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::KEYID_ACCOUNT;
+    typedef CCompositeKVCache<prefix, CKeyID, string> CacheType;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    vector<CKeyID> keys;
+    for (int32_t i = 0; i < 20000; i++)
+        keys.push_back(CKeyID(Hash160(ParseHex(strprintf("%08x", i)))));
+    vector<CBlock> blocks;
+    for (int32_t height = 1; height <= 500; height++)
+        blocks.push_back(CreateTransferBlock(height, 100));
+
+    CacheType cache(pDBAccess.get());
+    for (const auto &key : keys)
+        cache.SetData(key, key.ToString());
+    CTxMemCache txCache;
+    for (const auto &block : blocks)
+        txCache.AddBlockTx(block);
+
+    auto ReplayFork = [&](CacheType &forkCache, CTxMemCache &forkTxCache) {
+        for (int32_t i = 0; i < 10; i++) {
+            for (int32_t j = 0; j < 100; j++)
+                forkCache.SetData(keys[i * 100 + j], "fork");
+            forkTxCache.RemoveBlockTx(blocks[blocks.size() - 1 - i]);
+        }
+        string value;
+        BOOST_CHECK(forkCache.GetData(keys[0], value) && value == "fork");
+        BOOST_CHECK(forkCache.GetData(keys[1000], value) && value == keys[1000].ToString());
+        BOOST_CHECK(!forkTxCache.HaveTx(blocks.back().vptx[0]->GetHash()) &&
+                    forkTxCache.HaveTx(blocks[0].vptx[0]->GetHash()));
+    };
+
+    const int32_t forkCount = 10;
+    int64_t nStart          = GetTimeMicros();
+    size_t copyEntries      = 0;
+    for (int32_t i = 0; i < forkCount; i++) {
+        CacheType forkCache = cache;
+        CTxMemCache forkTxCache;  // owns all the txids, as the deep copy of the tx cache did
+        for (const auto &block : blocks)
+            forkTxCache.AddBlockTx(block);
+        ReplayFork(forkCache, forkTxCache);
+        copyEntries = forkCache.GetMapData().size() + forkTxCache.GetSize();
+    }
+    int64_t copyTime = GetTimeMicros() - nStart;
+
+    // the frozen copy is shared by all the forks of the tip
+    nStart = GetTimeMicros();
+    shared_ptr<CDBAccess> pSnapshot = pDBAccess->NewSnapshot();
+    CacheType frozenCache = cache;
+    frozenCache.SetDbAccess(pSnapshot.get());
+    CTxMemCache frozenTxCache = txCache;
+    int64_t frozenTime = GetTimeMicros() - nStart;
+
+    nStart              = GetTimeMicros();
+    size_t childEntries = 0;
+    for (int32_t i = 0; i < forkCount; i++) {
+        CacheType forkCache(&frozenCache);
+        CTxMemCache forkTxCache(&frozenTxCache);
+        ReplayFork(forkCache, forkTxCache);
+        childEntries = forkCache.GetMapData().size() + 10 * 100;  // and the removed txids of the 10 blocks
+    }
+    int64_t childTime = GetTimeMicros() - nStart;
+
+    BOOST_CHECK(childEntries < copyEntries / 10);
+    BOOST_TEST_MESSAGE(strprintf("fork view of 10 disconnected blocks: deep copy %.2fms %u entries, child of "
+                                 "frozen copy %.2fms %u entries, frozen copy %.2fms", 0.001 * copyTime / forkCount,
+                                 copyEntries, 0.001 * childTime / forkCount, childEntries, 0.001 * frozenTime));
+}
+
+BOOST_AUTO_TEST_CASE(block_tx_random_access_test)
+{
+    CBlock block;
+    block.SetHeight(100);
+    for (int32_t i = 0; i < 1000; i++) {
+        block.vptx.push_back(std::make_shared<CBaseCoinTransferTx>(CRegID(10, i), CRegID(20, i), 100, 1000 + i,
+                                                                   10000, strprintf("memo-%d", i)));
+    }
+    CDataStream ds(SER_DISK, CLIENT_VERSION);
+    ds << block;
+    vector<uint32_t> offsets;
+    block.GetTxOffsets(offsets);
+    BOOST_CHECK(offsets.size() == block.vptx.size());
+
+    const int32_t fetchCount = 100;
+    vector<uint32_t> indexes;
+    for (int32_t i = 0; i < fetchCount; i++)
+        indexes.push_back((i * 7919) % block.vptx.size());
+
+    // fetch a tx by deserializing the whole block
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t index : indexes) {
+        CBlockFileStream stream(&ds[0], ds.size());
+        CBlock readBlock;
+        stream >> readBlock;
+        BOOST_CHECK(readBlock.vptx[index]->GetHash() == block.vptx[index]->GetHash());
+    }
+    int64_t blockTime = GetTimeMicros() - nStart;
+
+    // fetch a tx by its offset
+    nStart = GetTimeMicros();
+    for (uint32_t index : indexes) {
+        CBlockFileStream stream(&ds[0], ds.size());
+        CBlockHeader header;
+        std::shared_ptr<CBaseTx> pTx;
+        stream >> header;
+        stream.ignore(offsets[index]);
+        stream >> pTx;
+        BOOST_CHECK(pTx->GetHash() == block.vptx[index]->GetHash() && header.GetHeight() == 100);
+    }
+    int64_t txTime = GetTimeMicros() - nStart;
+
+    BOOST_TEST_MESSAGE(strprintf("fetch a tx of 1000-tx block: whole block %.1fus, tx offset %.1fus",
+                                 1.0 * blockTime / fetchCount, 1.0 * txTime / fetchCount));
+}
+
+BOOST_AUTO_TEST_CASE(block_index_load_test)
+{
+    CBlockIndexDB blockIndexDb(true, true);
+
+    // a chain of 100 blocks and a fork from the block 50, so that the hashes spread over all the key ranges
+    vector<uint256> hashes;
+    uint256 prevHash, forkHash;
+    for (int32_t height = 0; height < 100; height++) {
+        CDiskBlockIndex diskIndex;
+        diskIndex.height   = height;
+        diskIndex.nTime    = 1000 + height;
+        diskIndex.hashPrev = prevHash;
+        BOOST_CHECK(blockIndexDb.WriteBlockIndex(diskIndex));
+        prevHash = diskIndex.GetBlockHash();
+        hashes.push_back(prevHash);
+        if (height == 50) {
+            diskIndex.height   = 51;
+            diskIndex.nTime    = 2000;
+            diskIndex.hashPrev = prevHash;
+            BOOST_CHECK(blockIndexDb.WriteBlockIndex(diskIndex));
+            forkHash = diskIndex.GetBlockHash();
+        }
+    }
+
+    vector<CBlockIndex *> sortedByHeight;
+    BOOST_CHECK(blockIndexDb.LoadBlockIndexes(sortedByHeight));
+    BOOST_CHECK(sortedByHeight.size() == hashes.size() + 1);
+    for (uint32_t i = 1; i < sortedByHeight.size(); i++) {
+        BOOST_CHECK(sortedByHeight[i - 1]->height <= sortedByHeight[i]->height);
+    }
+
+    for (int32_t height = 0; height < 100; height++) {
+        auto it = mapBlockIndex.find(hashes[height]);
+        BOOST_CHECK(it != mapBlockIndex.end());
+        CBlockIndex *pIndex = it->second;
+        BOOST_CHECK(pIndex->GetBlockHash() == hashes[height] && pIndex->height == height);
+        BOOST_CHECK(pIndex->pprev == (height > 0 ? mapBlockIndex[hashes[height - 1]] : nullptr));
+        BOOST_CHECK(blockIndexArena.Owns(pIndex));
+    }
+    BOOST_CHECK(mapBlockIndex[forkHash]->pprev == mapBlockIndex[hashes[50]]);
+    BOOST_CHECK(mapBlockIndex[forkHash]->nTime == 2000);
+
+    // the indexes stay in the arena
+    for (const auto &hash : hashes) {
+        mapBlockIndex.erase(hash);
+    }
+    mapBlockIndex.erase(forkHash);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,60 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <memory>
+#include <string>
+#include <boost/test/unit_test.hpp>
+#include "vm/luavm/lua/lua.hpp"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(luavm_tests)
+
+static const string script =
+    "local sum = 0\n"
+    "local t = {}\n"
+    "for i = 1, 200 do\n"
+    "    t[#t + 1] = string.format('%d', i)\n"
+    "    sum = sum + i * 2\n"
+    "end\n"
+    "result = sum .. #t\n";
+
+static int StringWriter(lua_State *L, const void *p, size_t sz, void *ud) {
+    ((string *)ud)->append((const char *)p, sz);
+    return 0;
+}
+
+// run the script or its bytecode by the burner of the version, return the burned fuel
+static uint64_t RunScript(const string &code, const char *mode, int burnVersion, string *pBytecode = nullptr) {
+    std::unique_ptr<lua_State, decltype(&lua_close)> luaStatePtr(luaL_newstate(), &lua_close);
+    lua_State *L = luaStatePtr.get();
+    BOOST_CHECK(lua_StartBurner(L, nullptr, 1000000, burnVersion));
+    luaL_requiref(L, LUA_STRLIBNAME, luaopen_string, 1);
+    lua_pop(L, 1);
+
+    BOOST_CHECK(luaL_loadbufferx(L, code.data(), code.size(), "line", mode) == LUA_OK);
+    if (pBytecode != nullptr)
+        BOOST_CHECK(lua_dump(L, StringWriter, pBytecode, 0) == 0);
+    BOOST_CHECK(lua_pcallk(L, 0, 0, 0, 0, NULL, BURN_VER_STEP_V1) == LUA_OK);
+
+    lua_getglobal(L, "result");
+    BOOST_CHECK(string(lua_tostring(L, -1)) == "40200200");
+    return lua_GetBurnedFuel(L);
+}
+
+BOOST_AUTO_TEST_CASE(lua_bytecode_fuel_test)
+{
+    // the steps burned by the bytecode are the same as by the script
+    string bytecode;
+    uint64_t scriptFuel = RunScript(script, "t", BURN_VER_R1, &bytecode);
+    BOOST_CHECK(scriptFuel > 0 && !bytecode.empty());
+    BOOST_CHECK(RunScript(bytecode, "b", BURN_VER_R1) == scriptFuel);
+
+    // the memory burned since R2 includes the parsing of the script
+    BOOST_CHECK(RunScript(script, "t", BURN_VER_R2) > RunScript(bytecode, "b", BURN_VER_R2));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,174 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "miner/miner.h"
+#include "persistence/blockundo.h"
+#include "persistence/cachewrapper.h"
+#include "tx/blockrewardtx.h"
+#include "tx/cointransfertx.h"
+
+using namespace std;
+
+static const uint64_t ACCOUNT_BALANCE = 100 * COIN;
+static const uint64_t TX_FEES         = 10000;
+
+// a transfer tx without the signature and fee checks, they need the accounts and the params of a running chain
+class CUncheckedTransferTx : public CBaseCoinTransferTx {
+public:
+    using CBaseCoinTransferTx::CBaseCoinTransferTx;
+
+    virtual bool CheckTx(CTxExecuteContext &context) { return true; }
+};
+
+// the failed txs are logged to the db of pCdMan, so it is opened in a temporary data dir
+struct FMinerTests {
+    FMinerTests() {
+        data_dir = boost::filesystem::temp_directory_path() / "coind_unit_test" / "miner_tests";
+        boost::filesystem::remove_all(data_dir);
+        BOOST_CHECK_NO_THROW(boost::filesystem::create_directories(data_dir));
+
+        SysCfg().SoftSetArgCover("-datadir", data_dir.string());
+        ClearDatadirCache();
+        pCdMan = new CCacheDBManager(false, false);
+    }
+    ~FMinerTests() {
+        delete pCdMan;
+        pCdMan = nullptr;
+        SysCfg().EraseArg("-datadir");
+        ClearDatadirCache();
+        BOOST_CHECK_NO_THROW(boost::filesystem::remove_all(data_dir));
+    }
+
+    // the accounts of the regids (1, 0), (1, 1), ...
+    void CreateAccounts(CCacheWrapper &cw, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            CAccount account(CKeyID(Hash160(strprintf("account-%u", i))));
+            account.regid = CRegID(1, i);
+            account.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, ACCOUNT_BALANCE);
+            cw.accountCache.SaveAccount(account);
+        }
+    }
+
+    std::shared_ptr<CBaseTx> NewTransferTx(uint32_t from, const CRegID &toRegId, uint64_t amount) {
+        return std::make_shared<CUncheckedTransferTx>(CRegID(1, from), toRegId, 100, amount, TX_FEES, "");
+    }
+
+    // pack the tx into the block like the miner, return whether it is packed
+    bool PackTx(CBlock &block, CCacheWrapper &cw, const std::shared_ptr<CBaseTx> &spTx,
+                uint64_t totalRunStep = 0) {
+        CValidationState state;
+        CTxExecuteContext context(100, block.vptx.size(), 1, 1000, 990, &cw, &state,
+                                  transaction_status_type::mining);
+        bool packed = false;
+        BOOST_CHECK(ExecuteTxToPack(spTx.get(), context, totalRunStep, packed));
+        if (packed)
+            block.vptx.push_back(spTx);
+
+        return packed;
+    }
+
+    uint64_t GetBalance(CCacheWrapper &cw, uint32_t regIndex) {
+        CAccount account;
+        BOOST_CHECK(cw.accountCache.GetAccount(CRegID(1, regIndex), account));
+        return account.GetToken(SYMB::WICC).free_amount;
+    }
+
+    boost::filesystem::path data_dir;
+};
+
+BOOST_FIXTURE_TEST_SUITE(miner_tests, FMinerTests)
+
+BOOST_AUTO_TEST_CASE(pack_failed_tx_rollback_test)
+{
+    CCacheWrapper baseCw(pCdMan);
+    CreateAccounts(baseCw, 3);
+
+    CCacheWrapper blockCw(&baseCw);
+    CDBOpLogMap blockOpLogs;
+    blockCw.SetDbOpLogMap(&blockOpLogs);
+
+    CBlock block;
+    block.vptx.push_back(std::make_shared<CBlockRewardTx>());
+    auto tx1 = NewTransferTx(0, CRegID(1, 1), COIN);
+    // it saves the debited sender account, then fails to read the unregistered receiver
+    auto failedTx = NewTransferTx(1, CRegID(9, 9), COIN);
+    auto tx2 = NewTransferTx(2, CRegID(1, 0), COIN);
+    // it executes, but the block has no run steps left
+    auto exceededTx = NewTransferTx(2, CRegID(1, 1), COIN);
+
+    BOOST_CHECK(PackTx(block, blockCw, tx1));
+    BOOST_CHECK(!PackTx(block, blockCw, failedTx));
+    BOOST_CHECK(PackTx(block, blockCw, tx2));
+    BOOST_CHECK(!PackTx(block, blockCw, exceededTx, MAX_BLOCK_RUN_STEP));
+
+    BOOST_CHECK(block.vptx.size() == 3 && block.vptx[1] == tx1 && block.vptx[2] == tx2);
+
+    // the writes of the packed txs are kept, the ones of the others are rolled back
+    BOOST_CHECK(GetBalance(blockCw, 0) == ACCOUNT_BALANCE - TX_FEES);
+    BOOST_CHECK(GetBalance(blockCw, 1) == ACCOUNT_BALANCE + COIN);
+    BOOST_CHECK(GetBalance(blockCw, 2) == ACCOUNT_BALANCE - COIN - TX_FEES);
+
+    // the op logs of the block only hold the writes of the packed txs, so undoing them restores the base
+    CBlockUndo blockUndo;
+    blockUndo.vtxundo.emplace_back();
+    blockUndo.vtxundo.back().dbOpLogMap = blockOpLogs;
+    blockCw.SetDbOpLogMap(nullptr);
+    BOOST_CHECK(CBlockUndoExecutor(blockCw, blockUndo).Execute());
+    for (uint32_t i = 0; i < 3; i++) {
+        BOOST_CHECK(GetBalance(blockCw, i) == ACCOUNT_BALANCE);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pack_txs_benchmark)
+{
+    CCacheWrapper baseCw(pCdMan);
+    CreateAccounts(baseCw, 100);
+
+    // every 10th tx fails after writing the sender account
+    vector<std::shared_ptr<CBaseTx> > txs;
+    for (uint32_t i = 0; i < 2000; i++) {
+        txs.push_back(NewTransferTx(i % 100, i % 10 == 9 ? CRegID(9, i) : CRegID(1, (i + 1) % 100), 1000));
+    }
+
+    // the savepoint of the block cache
+    CCacheWrapper savepointCw(&baseCw);
+    CBlock savepointBlock;
+    int64_t nStart = GetTimeMicros();
+    for (const auto &spTx : txs) {
+        PackTx(savepointBlock, savepointCw, spTx);
+    }
+    int64_t savepointTime = GetTimeMicros() - nStart;
+
+    // a child cache for every tx, flushed into the block cache when the tx is packed
+    CCacheWrapper childCw(&baseCw);
+    CBlock childBlock;
+    nStart = GetTimeMicros();
+    for (const auto &spTx : txs) {
+        CCacheWrapper txCw(&childCw);
+        CValidationState state;
+        CTxExecuteContext context(100, childBlock.vptx.size(), 1, 1000, 990, &txCw, &state,
+                                  transaction_status_type::mining);
+        if (spTx->CheckTx(context) && spTx->ExecuteTx(context)) {
+            txCw.Flush();
+            childBlock.vptx.push_back(spTx);
+        }
+    }
+    int64_t childTime = GetTimeMicros() - nStart;
+
+    BOOST_CHECK(savepointBlock.vptx.size() == 1800 && childBlock.vptx.size() == 1800);
+    for (uint32_t i = 0; i < 100; i++) {
+        BOOST_CHECK(GetBalance(savepointCw, i) == GetBalance(childCw, i));
+    }
+
+    BOOST_TEST_MESSAGE(strprintf("pack 2000 txs: savepoint %.3fms, child cache per tx %.3fms",
+                                 0.001 * savepointTime, 0.001 * childTime));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,185 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "chain/parallelexec.h"
+#include "persistence/blockundo.h"
+#include "persistence/cachewrapper.h"
+#include "tx/blockrewardtx.h"
+#include "tx/cointransfertx.h"
+
+using namespace std;
+
+static const uint64_t ACCOUNT_BALANCE = 100 * COIN;
+static const uint64_t TX_FEES         = 10000;
+
+// the block txs are logged to the db of pCdMan on failure, so it is opened in a temporary data dir
+struct FParallelExecTests {
+    FParallelExecTests() {
+        data_dir = boost::filesystem::temp_directory_path() / "coind_unit_test" / "parallelexec_tests";
+        boost::filesystem::remove_all(data_dir);
+        BOOST_CHECK_NO_THROW(boost::filesystem::create_directories(data_dir));
+
+        SysCfg().SoftSetArgCover("-datadir", data_dir.string());
+        ClearDatadirCache();
+        SysCfg().SetLogFailures(true);
+        pCdMan = new CCacheDBManager(false, false);
+    }
+    ~FParallelExecTests() {
+        delete pCdMan;
+        pCdMan = nullptr;
+        chain::SetParallelConnectThreads(0);
+        SysCfg().SetLogFailures(false);
+        SysCfg().EraseArg("-datadir");
+        ClearDatadirCache();
+        BOOST_CHECK_NO_THROW(boost::filesystem::remove_all(data_dir));
+    }
+
+    // the accounts of the regids (1, 0), (1, 1), ...
+    void CreateAccounts(CCacheWrapper &cw, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            CAccount account(CKeyID(Hash160(strprintf("account-%u", i))));
+            account.regid = CRegID(1, i);
+            account.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, ACCOUNT_BALANCE);
+            cw.accountCache.SaveAccount(account);
+            keyIds.push_back(account.keyid);
+        }
+    }
+
+    void AddTransferTx(CBlock &block, uint32_t from, const CUserID &toUid, uint64_t amount) {
+        block.vptx.push_back(std::make_shared<CBaseCoinTransferTx>(CRegID(1, from), toUid, block.GetHeight(), amount,
+                                                                   TX_FEES, ""));
+    }
+
+    // the transfers of 40 accounts, the txs conflict in the groups of 4 accounts, some go to new accounts
+    CBlock CreateBlock(int32_t height, uint32_t txCount) {
+        CBlock block;
+        block.SetHeight(height);
+        block.vptx.push_back(std::make_shared<CBlockRewardTx>());
+        for (uint32_t i = 0; i < txCount; i++) {
+            uint32_t from = i % 40;
+            if (i % 5 == 4)
+                AddTransferTx(block, from, CKeyID(Hash160(strprintf("new-account-%u", i))), COIN);
+            else
+                AddTransferTx(block, from, CRegID(1, from / 4 * 4 + (i + 1) % 4), COIN + i);
+        }
+        return block;
+    }
+
+    bool ExecuteBlock(CBlock &block, int32_t threads, CCacheWrapper &cw, CBlockUndo &blockUndo,
+                      CValidationState &state) {
+        CBlockIndex index;
+        index.height = block.GetHeight();
+        index.nTime  = 1000 + block.GetHeight();
+        chain::SetParallelConnectThreads(threads);
+        return chain::ExecuteBlockTxs(block, &index, cw, blockUndo, state);
+    }
+
+    string GetAccountData(CCacheWrapper &cw, const CUserID &uid) {
+        CAccount account;
+        if (!cw.accountCache.GetAccount(uid, account))
+            return "";
+
+        CDataStream ds(SER_DISK, CLIENT_VERSION);
+        ds << account;
+        return ds.str();
+    }
+
+    boost::filesystem::path data_dir;
+    vector<CKeyID> keyIds;
+};
+
+BOOST_FIXTURE_TEST_SUITE(parallelexec_tests, FParallelExecTests)
+
+BOOST_AUTO_TEST_CASE(parallel_serial_same_result_test)
+{
+    CCacheWrapper baseCw(pCdMan);
+    CreateAccounts(baseCw, 40);
+    CBlock block = CreateBlock(100, 60);
+
+    CCacheWrapper serialCw(&baseCw), parallelCw(&baseCw);
+    CBlockUndo serialUndo, parallelUndo;
+    CValidationState serialState, parallelState;
+    BOOST_CHECK(ExecuteBlock(block, 0, serialCw, serialUndo, serialState));
+    BOOST_CHECK(ExecuteBlock(block, 4, parallelCw, parallelUndo, parallelState));
+
+    // the same undo logs in block order
+    BOOST_CHECK(parallelUndo.vtxundo.size() == block.vptx.size() - 1);
+    CDataStream serialDs(SER_DISK, CLIENT_VERSION), parallelDs(SER_DISK, CLIENT_VERSION);
+    serialDs << serialUndo;
+    parallelDs << parallelUndo;
+    BOOST_CHECK(serialDs.str() == parallelDs.str());
+
+    // the same accounts
+    for (const auto &keyId : keyIds) {
+        BOOST_CHECK(GetAccountData(serialCw, keyId) == GetAccountData(parallelCw, keyId));
+        BOOST_CHECK(GetAccountData(serialCw, keyId) != GetAccountData(baseCw, keyId));
+    }
+    for (uint32_t i = 4; i < 60; i += 5) {
+        CKeyID newKeyId(Hash160(strprintf("new-account-%u", i)));
+        BOOST_CHECK(!GetAccountData(parallelCw, newKeyId).empty());
+        BOOST_CHECK(GetAccountData(serialCw, newKeyId) == GetAccountData(parallelCw, newKeyId));
+    }
+
+    // the undo logs of the parallel execution restore the accounts
+    BOOST_CHECK(CBlockUndoExecutor(parallelCw, parallelUndo).Execute());
+    for (const auto &keyId : keyIds) {
+        BOOST_CHECK(GetAccountData(parallelCw, keyId) == GetAccountData(baseCw, keyId));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_serial_same_failure_test)
+{
+    CCacheWrapper baseCw(pCdMan);
+    CreateAccounts(baseCw, 40);
+
+    // two txs of the different groups fail, the first one in block order is reported
+    auto createFailBlock = [&](int32_t height) {
+        CBlock block = CreateBlock(height, 40);
+        block.vptx[11] = std::make_shared<CBaseCoinTransferTx>(CRegID(1, 10), CRegID(1, 11), height,
+                                                               2 * ACCOUNT_BALANCE, TX_FEES, "");
+        block.vptx[31] = std::make_shared<CBaseCoinTransferTx>(CRegID(1, 30), CRegID(1, 31), height,
+                                                               2 * ACCOUNT_BALANCE, TX_FEES, "");
+        return block;
+    };
+    CBlock serialBlock = createFailBlock(100), parallelBlock = createFailBlock(101);
+
+    CCacheWrapper serialCw(&baseCw), parallelCw(&baseCw);
+    CBlockUndo serialUndo, parallelUndo;
+    CValidationState serialState, parallelState;
+    BOOST_CHECK(!ExecuteBlock(serialBlock, 0, serialCw, serialUndo, serialState));
+    BOOST_CHECK(!ExecuteBlock(parallelBlock, 4, parallelCw, parallelUndo, parallelState));
+    BOOST_CHECK(parallelState.GetRejectCode() == serialState.GetRejectCode());
+    BOOST_CHECK(parallelState.GetRejectReason() == serialState.GetRejectReason());
+
+    vector<std::tuple<uint256, uint8_t, string> > serialFails, parallelFails;
+    BOOST_CHECK(pCdMan->pLogCache->GetExecuteFail(100, serialFails));
+    BOOST_CHECK(pCdMan->pLogCache->GetExecuteFail(101, parallelFails));
+    BOOST_CHECK(serialFails.size() == 1 && std::get<0>(serialFails[0]) == serialBlock.vptx[11]->GetHash());
+    BOOST_CHECK(parallelFails.size() == 1 && std::get<0>(parallelFails[0]) == parallelBlock.vptx[11]->GetHash());
+}
+
+BOOST_AUTO_TEST_CASE(parallel_connect_benchmark)
+{
+    CCacheWrapper baseCw(pCdMan);
+    CreateAccounts(baseCw, 40);
+    CBlock block = CreateBlock(100, 2000);
+
+    for (int32_t threads : {0, 2, 4, 8}) {
+        CCacheWrapper cw(&baseCw);
+        CBlockUndo blockUndo;
+        CValidationState state;
+        int64_t nStart = GetTimeMicros();
+        BOOST_CHECK(ExecuteBlock(block, threads, cw, blockUndo, state));
+        BOOST_TEST_MESSAGE(strprintf("execute a block of %u transfer txs with %d threads: %.2fms",
+                                     block.vptx.size() - 1, threads, 0.001 * (GetTimeMicros() - nStart)));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,139 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <map>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "commons/random.h"
+#include "persistence/pricefeeddb.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(pricefeed_tests)
+
+// the few distinct prices make many equal ones
+static uint64_t RandPrice() { return 100 + GetRand(8); }
+
+BOOST_AUTO_TEST_CASE(median_price_set_test)
+{
+    CMedianPriceSet priceSet;
+    vector<uint64_t> prices;
+    BOOST_CHECK(priceSet.GetMedian() == 0);
+
+    for (uint32_t i = 0; i < 200; i++) {
+        if (!prices.empty() && GetRand(3) == 0) {
+            uint32_t index = GetRand(prices.size());
+            priceSet.Erase(prices[index]);
+            prices.erase(prices.begin() + index);
+        } else {
+            prices.push_back(RandPrice());
+            priceSet.Insert(prices.back());
+        }
+
+        vector<uint64_t> expected = prices;
+        BOOST_CHECK(priceSet.GetSize() == prices.size());
+        BOOST_CHECK(priceSet.GetMedian() == CMedianPriceSet::ComputeMedianNumber(expected));
+
+        // the median of the prices changed by a few erased and inserted ones
+        vector<uint64_t> changed = prices;
+        vector<uint64_t> erasedPrices, insertedPrices;
+        for (uint32_t j = GetRand(4); j > 0 && !changed.empty(); j--) {
+            uint32_t index = GetRand(changed.size());
+            erasedPrices.push_back(changed[index]);
+            changed.erase(changed.begin() + index);
+        }
+        for (uint32_t j = GetRand(4); j > 0; j--) {
+            insertedPrices.push_back(RandPrice());
+            changed.push_back(insertedPrices.back());
+        }
+        BOOST_CHECK(priceSet.GetMedian(erasedPrices, insertedPrices) ==
+                    CMedianPriceSet::ComputeMedianNumber(changed));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(price_point_cache_median_test)
+{
+    CoinPricePair coinPricePair(SYMB::WICC, SYMB::USD);
+    map<int32_t, vector<uint64_t>> blockPrices;
+    auto addBlockPrices = [&](CPricePointMemCache &cache, int32_t height) {
+        for (uint32_t i = 1; i <= 5; i++) {
+            blockPrices[height].push_back(RandPrice());
+            cache.AddPrice(height, CRegID(100, i), {CPricePoint(coinPricePair, blockPrices[height].back())});
+        }
+    };
+    auto deleteBlockPrices = [&](CPricePointMemCache &cache, int32_t height) {
+        CBlock block;
+        block.SetHeight(height);
+        cache.DeleteBlockFromCache(block);
+        blockPrices.erase(height);
+    };
+    auto expectedMedian = [&](int32_t blockHeight, int32_t slideWindow) {
+        vector<uint64_t> prices;
+        for (int32_t height = blockHeight; height > blockHeight - slideWindow && height > 0; --height) {
+            if (blockPrices.count(height))
+                prices.insert(prices.end(), blockPrices[height].begin(), blockPrices[height].end());
+        }
+        return CMedianPriceSet::ComputeMedianNumber(prices);
+    };
+
+    CPricePointMemCache baseCache;
+    for (int32_t height = 1; height <= 11; height++) {
+        addBlockPrices(baseCache, height);
+    }
+    BOOST_CHECK(baseCache.ComputeBlockMedianPrice(11, 11, coinPricePair) == expectedMedian(11, 11));
+    BOOST_CHECK(baseCache.ComputeBlockMedianPrice(11, 4, coinPricePair) == expectedMedian(11, 4));
+
+    // the child caches expire the old blocks and add the new ones
+    CPricePointMemCache childCache(&baseCache);
+    deleteBlockPrices(childCache, 1);
+    addBlockPrices(childCache, 12);
+    BOOST_CHECK(childCache.ComputeBlockMedianPrice(12, 11, coinPricePair) == expectedMedian(12, 11));
+
+    CPricePointMemCache grandChildCache(&childCache);
+    deleteBlockPrices(grandChildCache, 2);
+    deleteBlockPrices(grandChildCache, 12);
+    addBlockPrices(grandChildCache, 13);
+    BOOST_CHECK(grandChildCache.ComputeBlockMedianPrice(13, 11, coinPricePair) == expectedMedian(13, 11));
+    BOOST_CHECK(grandChildCache.ComputeBlockMedianPrice(13, 5, coinPricePair) == expectedMedian(13, 5));
+    BOOST_CHECK(grandChildCache.ComputeBlockMedianPrice(13, 20, coinPricePair) == expectedMedian(13, 20));
+
+    // the flushed prices are merged into the sorted prices of the base cache
+    grandChildCache.Flush();
+    childCache.Flush();
+    BOOST_CHECK(baseCache.ComputeBlockMedianPrice(13, 11, coinPricePair) == expectedMedian(13, 11));
+    BOOST_CHECK(baseCache.ComputeBlockMedianPrice(13, 5, coinPricePair) == expectedMedian(13, 5));
+    BOOST_CHECK(baseCache.ComputeBlockMedianPrice(14, 11, coinPricePair) == expectedMedian(14, 11));
+    BOOST_CHECK(baseCache.ComputeBlockMedianPrice(13, 11, CoinPricePair(SYMB::WGRT, SYMB::USD)) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(price_point_cache_file_test)
+{
+    CoinPricePair coinPricePair(SYMB::WICC, SYMB::USD);
+    CPricePointMemCache cache;
+    for (int32_t height = 1; height <= 11; height++) {
+        for (uint32_t i = 1; i <= 3; i++) {
+            cache.AddPrice(height, CRegID(100, i), {CPricePoint(coinPricePair, RandPrice())});
+        }
+    }
+
+    // the prices written to the mem cache file are sorted again when read back
+    CoinBlockUserPriceMap coinBlockUserPrices;
+    cache.GetCoinBlockUserPrices(coinBlockUserPrices);
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << coinBlockUserPrices;
+    CoinBlockUserPriceMap readPrices;
+    ss >> readPrices;
+    BOOST_CHECK(readPrices == coinBlockUserPrices);
+
+    CPricePointMemCache readCache;
+    readCache.SetCoinBlockUserPrices(readPrices);
+    for (int32_t slideWindow : {11, 5, 1}) {
+        BOOST_CHECK(readCache.ComputeBlockMedianPrice(11, slideWindow, coinPricePair) ==
+                    cache.ComputeBlockMedianPrice(11, slideWindow, coinPricePair));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
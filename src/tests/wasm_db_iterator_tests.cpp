@@ -0,0 +1,150 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "persistence/cachewrapper.h"
+#include "wasm/wasm_context.hpp"
+
+using namespace std;
+
+static const uint64_t TEST_CONTRACT = wasm::N(testcontract);
+
+// the contract data is iterated over the caches and the db of pCdMan, so it is opened in a temporary data dir
+struct FWasmDbIteratorTests {
+    FWasmDbIteratorTests() {
+        data_dir = boost::filesystem::temp_directory_path() / "coind_unit_test" / "wasm_db_iterator_tests";
+        boost::filesystem::remove_all(data_dir);
+        BOOST_CHECK_NO_THROW(boost::filesystem::create_directories(data_dir));
+
+        SysCfg().SoftSetArgCover("-datadir", data_dir.string());
+        ClearDatadirCache();
+        pCdMan = new CCacheDBManager(false, false);
+
+        CAccount account(CKeyID(Hash160(string("testcontract"))));
+        account.regid  = CRegID(1, 1);
+        account.nickid = CNickID(TEST_CONTRACT);
+        CCacheWrapper cw(pCdMan);
+        cw.accountCache.SaveAccount(account);
+        cw.accountCache.SetNickId(account, 1);
+        cw.Flush();
+    }
+    ~FWasmDbIteratorTests() {
+        delete pCdMan;
+        pCdMan = nullptr;
+        SysCfg().EraseArg("-datadir");
+        ClearDatadirCache();
+        BOOST_CHECK_NO_THROW(boost::filesystem::remove_all(data_dir));
+    }
+
+    // the key written by the host methods, prefixed by the contract
+    static string ContractKey(const string &key) {
+        std::vector<char> prefix = wasm::pack(TEST_CONTRACT);
+        return string(prefix.data(), prefix.size()) + key;
+    }
+
+    // the keys from the lower bound of the key to the end
+    static vector<string> ScanKeys(wasm::wasm_context &context, const string &key) {
+        vector<string> keys;
+        string k, v;
+        for (int32_t it = context.db_lowerbound(TEST_CONTRACT, ContractKey(key)); it >= 0; it = context.db_next(it)) {
+            context.db_iterator_data(it, k, v);
+            keys.push_back(k);
+        }
+        return keys;
+    }
+
+    boost::filesystem::path data_dir;
+};
+
+BOOST_FIXTURE_TEST_SUITE(wasm_db_iterator_tests, FWasmDbIteratorTests)
+
+BOOST_AUTO_TEST_CASE(wasm_db_iterator_order_test)
+{
+    CWasmContractTx tx;
+    tx.pending_block_height = SysCfg().GetVer3ForkHeight();
+    wasm::inline_transaction trx;
+    vector<CReceipt> receipts;
+
+    // the keys in the db, the block cache and the tx cache are merged in key order
+    CCacheWrapper blockCw(pCdMan);
+    {
+        wasm::wasm_context context(tx, trx, blockCw, receipts, false);
+        context.set_data(TEST_CONTRACT, ContractKey("b"), "db-b");
+        context.set_data(TEST_CONTRACT, ContractKey("d"), "db-d");
+    }
+    blockCw.Flush();
+    BOOST_CHECK(pCdMan->Flush());
+
+    CCacheWrapper txCw(&blockCw);
+    wasm::wasm_context context(tx, trx, txCw, receipts, false);
+    context.set_data(TEST_CONTRACT, ContractKey("a"), "tx-a");
+    context.set_data(TEST_CONTRACT, ContractKey("c"), "tx-c");
+    context.set_data(TEST_CONTRACT, ContractKey("d"), "tx-d");
+
+    BOOST_CHECK(ScanKeys(context, "") == vector<string>({"a", "b", "c", "d"}));
+    BOOST_CHECK(ScanKeys(context, "b") == vector<string>({"b", "c", "d"}));
+    BOOST_CHECK(ScanKeys(context, "bb") == vector<string>({"c", "d"}));
+
+    // the end of the range
+    BOOST_CHECK(context.db_lowerbound(TEST_CONTRACT, ContractKey("e")) == -1);
+    int32_t it = context.db_lowerbound(TEST_CONTRACT, ContractKey("d"));
+    string k, v;
+    context.db_iterator_data(it, k, v);
+    BOOST_CHECK(k == "d" && v == "tx-d");
+    BOOST_CHECK(context.db_next(it) == -1);
+    BOOST_CHECK_THROW(context.db_iterator_data(it, k, v), wasm_chain::wasm_assert_exception);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_db_iterator_write_test)
+{
+    CWasmContractTx tx;
+    tx.pending_block_height = SysCfg().GetVer3ForkHeight();
+    wasm::inline_transaction trx;
+    vector<CReceipt> receipts;
+
+    CCacheWrapper txCw(pCdMan);
+    wasm::wasm_context context(tx, trx, txCw, receipts, false);
+    for (const string key : {"a", "c", "e"}) {
+        context.set_data(TEST_CONTRACT, ContractKey(key), "value-" + key);
+    }
+
+    // the iterator moves on from its key after the data is written by the same tx
+    int32_t it = context.db_lowerbound(TEST_CONTRACT, ContractKey("a"));
+    context.set_data(TEST_CONTRACT, ContractKey("b"), "value-b");
+    context.erase_data(TEST_CONTRACT, ContractKey("c"));
+    string k, v;
+    BOOST_CHECK(context.db_next(it) == it);
+    context.db_iterator_data(it, k, v);
+    BOOST_CHECK(k == "b" && v == "value-b");
+
+    // the value written ahead of the iterator is read when it moves to the key
+    context.set_data(TEST_CONTRACT, ContractKey("e"), "updated-e");
+    BOOST_CHECK(context.db_next(it) == it);
+    context.db_iterator_data(it, k, v);
+    BOOST_CHECK(k == "e" && v == "updated-e");
+    BOOST_CHECK(context.db_next(it) == -1);
+}
+
+BOOST_AUTO_TEST_CASE(wasm_db_iterator_fork_test)
+{
+    CWasmContractTx tx;
+    wasm::inline_transaction trx;
+    vector<CReceipt> receipts;
+    CCacheWrapper txCw(pCdMan);
+    wasm::wasm_context context(tx, trx, txCw, receipts, false);
+    context.set_data(TEST_CONTRACT, ContractKey("a"), "value-a");
+
+    // the intrinsics are not enabled before the feature fork of the wasm contracts
+    tx.pending_block_height = SysCfg().GetVer3ForkHeight() - 1;
+    BOOST_CHECK_THROW(context.db_lowerbound(TEST_CONTRACT, ContractKey("a")), wasm_chain::wasm_assert_exception);
+
+    tx.pending_block_height = SysCfg().GetVer3ForkHeight();
+    BOOST_CHECK(context.db_lowerbound(TEST_CONTRACT, ContractKey("a")) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
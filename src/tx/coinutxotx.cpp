@@ -15,18 +15,14 @@ bool GetUtxoTxFromChain(TxID &txid, std::shared_ptr<CCoinUtxoTx> pTx) {
     
     CDiskTxPos txPos;
     if (pCdMan->pBlockCache->ReadTxIndex(txid, txPos)) {
-        LOCK(cs_main);
-        CAutoFile file(OpenBlockFile(txPos, true), SER_DISK, CLIENT_VERSION);
         CBlockHeader header;
-
-        try {
-            file >> header;
-            fseek(file, txPos.nTxOffset, SEEK_CUR);
-            file >> pTx;
-            
-        } catch (std::exception &e) {
-            throw runtime_error(tfm::format("%s : Deserialize or I/O error - %s", __func__, e.what()).c_str());
-        }
+        bool ret = ReadBlockFile(txPos, [&](CBlockFileStream &stream) {
+            stream >> header;
+            stream.ignore(txPos.nTxOffset);
+            stream >> pTx;
+        });
+        if (!ret)
+            throw runtime_error(tfm::format("%s : Deserialize or I/O error", __func__).c_str());
     }
     return true;
 }
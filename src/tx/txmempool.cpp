@@ -15,16 +15,20 @@ using namespace std;
 CTxMemPoolEntry::CTxMemPoolEntry() {
     nTxSize   = 0;
     dPriority = 0.0;
+    dFeePerKb = 0.0;
 
     nTime   = 0;
     height = 0;
+    sequence = 0;
 }
 
-CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height) : nTime(time), height(height) {
+CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height)
+    : nTime(time), height(height), sequence(0) {
     pTx       = pBaseTx->GetNewInstance();
     nFees     = pTx->GetFees();
     nTxSize   = ::GetSerializeSize(*pTx, SER_NETWORK, PROTOCOL_VERSION);
     dPriority = pTx->GetPriority();
+    dFeePerKb = 0.0;
 }
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
@@ -32,9 +36,22 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
     this->nFees     = other.nFees;
     this->nTxSize   = other.nTxSize;
     this->dPriority = other.dPriority;
+    this->dFeePerKb = other.dFeePerKb;
 
     this->nTime  = other.nTime;
     this->height = other.height;
+
+    this->dbKeys   = other.dbKeys;
+    this->sequence = other.sequence;
+}
+
+void CTxMemPoolEntry::SetFeePerKb(int32_t height, uint32_t fuelRate) {
+    // nRunStep of pTx is set by the last execution in mempool
+    dFeePerKb = double(std::get<1>(nFees) - pTx->GetFuel(height, fuelRate)) / nTxSize * 1000.0;
+}
+
+CTxMemPoolPriorityKey CTxMemPoolEntry::GetPriorityKey(const uint256 &txid) const {
+    return {int32_t(dPriority / TRANSACTION_PRIORITY_CEILING), dFeePerKb, txid};
 }
 
 CTxMemPool::CTxMemPool() {
@@ -42,29 +59,78 @@ CTxMemPool::CTxMemPool() {
     // accepting transactions becomes O(N^2) where N is the number
     // of transactions in the pool
     fSanityCheck         = false;
+    nSequence            = 0;
+    nTotalTxSize         = 0;
+    nScanHeight          = 0;
 }
 
 void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive) {
     // Remove transaction from memory pool
     LOCK(cs);
     uint256 txid = pBaseTx->GetHash();
-    if (memPoolTxs.count(txid)) {
-        removed.push_front(std::shared_ptr<CBaseTx>(memPoolTxs[txid].GetTransaction()));
-        memPoolTxs.erase(txid);
+    auto it = memPoolTxs.find(txid);
+    if (it != memPoolTxs.end()) {
+        removed.push_front(std::shared_ptr<CBaseTx>(it->second.GetTransaction()));
+        EraseEntry(it);
         EraseTransaction(txid);
     }
 }
 
+void CTxMemPool::RemoveConfirmedTxs(const CBlock &block) {
+    LOCK(cs);
+    for (const auto &pTx : block.vptx) {
+        auto it = memPoolTxs.find(pTx->GetHash());
+        if (it != memPoolTxs.end())
+            EraseEntry(it);
+    }
+}
+
+map<uint256, CTxMemPoolEntry>::iterator CTxMemPool::EraseEntry(map<uint256, CTxMemPoolEntry>::iterator it) {
+    // the data written by the removed tx is still in cw, and must be discarded by the next scan
+    const set<string> &writtenKeys = it->second.GetDbKeys().writtenKeys;
+    changedDbKeys.insert(writtenKeys.begin(), writtenKeys.end());
+    RemoveFromIndex(it->first, it->second);
+    return memPoolTxs.erase(it);
+}
+
+void CTxMemPool::AddToIndex(const uint256 &txid, const CTxMemPoolEntry &entry) {
+    priorityIndex.insert(entry.GetPriorityKey(txid));
+    nTotalTxSize += entry.GetTxSize();
+}
+
+void CTxMemPool::RemoveFromIndex(const uint256 &txid, const CTxMemPoolEntry &entry) {
+    priorityIndex.erase(entry.GetPriorityKey(txid));
+    nTotalTxSize -= entry.GetTxSize();
+}
+
 bool CTxMemPool::AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state) {
     // Add to memory pool without checking anything.
     // Used by main.cpp AcceptToMemoryPool(), which DOES
     // all the appropriate checks.
     LOCK(cs);
     {
-        if (!CheckTxInMemPool(txid, entry, state))
+        // The data written by the tx is kept out of cw until the tx is sure to stay in the pool.
+        CDBKeyTracker dbKeys;
+        std::shared_ptr<CCacheWrapper> spTxCw;
+        if (!CheckTxInMemPool(txid, entry, state, true, &dbKeys, &spTxCw))
             return false;
 
-        memPoolTxs.insert(make_pair(txid, entry));
+        auto ret = memPoolTxs.insert(make_pair(txid, entry));
+        ret.first->second.SetExecuted(std::move(dbKeys), ++nSequence);
+        ret.first->second.SetFeePerKb(chainActive.Height(), GetElementForBurn(chainActive.Tip()));
+        AddToIndex(txid, ret.first->second);
+
+        set<uint256> evictedTxids;
+        SelectTxsToEvict(evictedTxids);
+        if (evictedTxids.count(txid)) {
+            RemoveFromIndex(txid, ret.first->second);
+            memPoolTxs.erase(ret.first);
+            return state.Invalid(ERRORMSG("AddUnchecked() : txid: %s evicted from the full mempool", txid.GetHex()),
+                                 REJECT_INSUFFICIENTFEE, "mempool-full");
+        }
+
+        spTxCw->Flush();
+        EvictTxs(evictedTxids);
     }
     return true;
 }
@@ -80,7 +146,8 @@ void CTxMemPool::QueryHash(vector<uint256> &txids) {
 }
 
 bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &memPoolEntry, CValidationState &state,
-                                  bool bExecute) {
+                                  bool bExecute, CDBKeyTracker *pDbKeyTracker,
+                                  std::shared_ptr<CCacheWrapper> *pTxCw) {
     // is it within valid height
     static int validHeight = SysCfg().GetTxCacheHeight();
     if (!memPoolEntry.GetTransaction()->IsValidHeight(chainActive.Height(), validHeight))
@@ -92,9 +159,10 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
         return state.Invalid(ERRORMSG("CheckTxInMemPool() : txid: %s has been confirmed", txid.GetHex()), REJECT_INVALID,
                              "tx-duplicate-confirmed");
 
-    auto spCW = std::make_shared<CCacheWrapper>(cw.get());
-
     if (bExecute) {
+        auto spCW = std::make_shared<CCacheWrapper>(cw.get());
+        spCW->SetDbKeyTracker(pDbKeyTracker);
+
         CBlockIndex *pTip =  chainActive.Tip();
         uint32_t fuelRate  = GetElementForBurn(pTip);
         uint32_t blockTime = pTip->GetBlockTime();
@@ -105,9 +173,15 @@ bool CTxMemPool::CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &me
                                               state.GetRejectCode(), state.GetRejectReason());
             return false;
         }
-    }
 
-    spCW->Flush();
+        if (pTxCw != nullptr) {
+            // the tracker of the caller goes out of scope before the returned cache is flushed
+            spCW->SetDbKeyTracker(nullptr);
+            *pTxCw = spCW;
+        } else {
+            spCW->Flush();
+        }
+    }
 
     return true;
 }
@@ -116,26 +190,156 @@ void CTxMemPool::SetMemPoolCache() {
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
-void CTxMemPool::ReScanMemPoolTx() {
-    cw.reset(new CCacheWrapper(pCdMan));
+void CTxMemPool::AddChangedDbKeys(const set<string> &dbKeys) {
+    LOCK(cs);
+    changedDbKeys.insert(dbKeys.begin(), dbKeys.end());
+}
+
+// Whether any of the keys is changed, a key prefix recorded by a range read matches all the keys with the prefix.
+static bool HasChangedKey(const set<string> &keys, const set<string> &changedKeys) {
+    for (const auto &key : keys) {
+        auto it = changedKeys.lower_bound(key);
+        if (it != changedKeys.end() && it->compare(0, key.size(), key) == 0)
+            return true;
+    }
+    return false;
+}
+
+void CTxMemPool::SelectTxsToEvict(set<uint256> &evictedTxids) const {
+    static uint64_t maxSize = SysCfg().GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
+    if (nTotalTxSize <= maxSize)
+        return;
+
+    map<uint64_t, map<uint256, CTxMemPoolEntry>::const_iterator> txsBySequence;
+    for (auto it = memPoolTxs.begin(); it != memPoolTxs.end(); ++it) {
+        txsBySequence.emplace(it->second.GetSequence(), it);
+    }
+
+    uint64_t totalSize = nTotalTxSize;
+    for (auto itKey = priorityIndex.begin(); itKey != priorityIndex.end() && totalSize > maxSize; ++itKey) {
+        if (evictedTxids.count(itKey->txid))
+            continue;
+
+        // the txs executed after it on the data written by it go with it
+        set<string> writtenKeys;
+        for (auto itSeq = txsBySequence.find(memPoolTxs.at(itKey->txid).GetSequence()); itSeq != txsBySequence.end();
+             ++itSeq) {
+            const uint256 &txid          = itSeq->second->first;
+            const CTxMemPoolEntry &entry = itSeq->second->second;
+            if (evictedTxids.count(txid) ||
+                (txid != itKey->txid && !HasChangedKey(entry.GetDbKeys().accessedKeys, writtenKeys)))
+                continue;
 
+            evictedTxids.insert(txid);
+            writtenKeys.insert(entry.GetDbKeys().writtenKeys.begin(), entry.GetDbKeys().writtenKeys.end());
+            totalSize -= entry.GetTxSize();
+        }
+    }
+}
+
+void CTxMemPool::EvictTxs(const set<uint256> &txids) {
+    if (txids.empty())
+        return;
+
+    for (const auto &txid : txids) {
+        LogPrint(BCLog::DEBUG, "CTxMemPool::EvictTxs() : mempool full, evict txid: %s\n", txid.GetHex());
+        EraseEntry(memPoolTxs.find(txid));
+        EraseTransaction(txid);
+    }
+
+    // the data written by the evicted txs is discarded from cw, and the txs before them on the data are re-executed
+    ReExecuteChangedTxs(false);
+}
+
+void CTxMemPool::ReScanMemPoolTx() {
     LOCK(cs);
+    int64_t nStart = GetTimeMicros();
+
+    // The tx execution rules may change at the fork height, all txs must be re-executed then.
+    int32_t height = chainActive.Height();
+    bool fFullScan = GetFeatureForkVersion(height) != GetFeatureForkVersion(nScanHeight);
+    nScanHeight    = height;
+
+    // 1. Remove the txs beyond the scope of valid height or confirmed already.
     CValidationState state;
-    for (map<uint256, CTxMemPoolEntry>::iterator iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end();) {
-        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, true)) {
+    for (auto iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end();) {
+        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, false)) {
             uint256 txid = iterTx->first;
-            iterTx       = memPoolTxs.erase(iterTx++);
+            iterTx       = EraseEntry(iterTx);
             EraseTransaction(txid);
             continue;
         }
         ++iterTx;
     }
+
+    // 2. Re-execute the txs affected by the changed data.
+    uint32_t reExecuted = ReExecuteChangedTxs(fFullScan);
+
+    if (SysCfg().IsBenchmark())
+        LogPrint(BCLog::INFO, "- Rescan mempool: %u of %u txs re-executed: %.2fms\n", reExecuted,
+                 memPoolTxs.size(), 0.001 * (GetTimeMicros() - nStart));
+}
+
+uint32_t CTxMemPool::ReExecuteChangedTxs(bool fFullScan) {
+    // Find the txs accessing the changed data, and the txs accessing the data written by them in turn.
+    // The price feed txs are always re-executed since their prices are kept by height in the price point cache.
+    map<uint64_t, uint256> affectedTxs;  // sequence -> txid
+    bool fFound = true;
+    while (fFound) {
+        fFound = false;
+        for (auto &item : memPoolTxs) {
+            CTxMemPoolEntry &entry = item.second;
+            if (affectedTxs.count(entry.GetSequence()))
+                continue;
+
+            if (fFullScan || entry.GetTransaction()->IsPriceFeedTx() ||
+                HasChangedKey(entry.GetDbKeys().accessedKeys, changedDbKeys)) {
+                affectedTxs.emplace(entry.GetSequence(), item.first);
+                changedDbKeys.insert(entry.GetDbKeys().writtenKeys.begin(), entry.GetDbKeys().writtenKeys.end());
+                fFound = true;
+            }
+        }
+    }
+
+    // Discard the changed data from cw, then re-execute the affected txs in their previous order. The other txs
+    // access none of the changed data, so their state in cw is still valid on the new chain state.
+    if (fFullScan) {
+        cw.reset(new CCacheWrapper(pCdMan));
+    } else {
+        cw->DiscardData(changedDbKeys);
+        cw->ppCache = CPricePointMemCache(pCdMan->pPpCache);
+    }
+    changedDbKeys.clear();
+
+    CValidationState state;
+    int32_t height    = chainActive.Height();
+    uint32_t fuelRate = GetElementForBurn(chainActive.Tip());
+    for (const auto &item : affectedTxs) {
+        auto iterTx = memPoolTxs.find(item.second);
+        RemoveFromIndex(iterTx->first, iterTx->second);
+
+        CDBKeyTracker dbKeys;
+        if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, true, &dbKeys)) {
+            memPoolTxs.erase(iterTx);
+            EraseTransaction(item.second);
+            continue;
+        }
+        // the run steps of the tx may change on the new chain state
+        iterTx->second.SetExecuted(std::move(dbKeys), ++nSequence);
+        iterTx->second.SetFeePerKb(height, fuelRate);
+        AddToIndex(iterTx->first, iterTx->second);
+    }
+
+    return affectedTxs.size();
 }
 
 void CTxMemPool::Clear() {
     LOCK(cs);
 
     memPoolTxs.clear();
+    priorityIndex.clear();
+    nTotalTxSize = 0;
+    changedDbKeys.clear();
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
@@ -144,6 +348,11 @@ uint64_t CTxMemPool::Size() {
     return memPoolTxs.size();
 }
 
+uint64_t CTxMemPool::TotalTxSize() {
+    LOCK(cs);
+    return nTotalTxSize;
+}
+
 bool CTxMemPool::Exists(const uint256 txid) {
     LOCK(cs);
     return ((memPoolTxs.count(txid) != 0));
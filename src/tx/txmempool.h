@@ -14,13 +14,29 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
+#include <tuple>
 
 using namespace std;
 
 class CValidationState;
 class CBaseTx;
+class CBlock;
 class uint256;
 
+/*
+ * The packing order of a mempool tx, the greater goes into the block first.
+ */
+struct CTxMemPoolPriorityKey {
+    int32_t priorityLevel;  // The priority in units of TRANSACTION_PRIORITY_CEILING, puts the price feed txs first
+    double feePerKb;        // The fee per KB net of the fuel
+    uint256 txid;
+
+    bool operator<(const CTxMemPoolPriorityKey &other) const {
+        return std::tie(priorityLevel, feePerKb, txid) < std::tie(other.priorityLevel, other.feePerKb, other.txid);
+    }
+};
+
 /*
  * CTxMemPool stores these:
  */
@@ -30,10 +46,14 @@ private:
     std::pair<TokenSymbol, uint64_t> nFees;  // Cached to avoid expensive parent-transaction lookups
     uint32_t nTxSize;                     // Cached to avoid recomputing tx size
     double dPriority;                     // Cached to avoid recomputing priority
+    double dFeePerKb;                     // Fee per KB net of the fuel of the last execution in mempool
 
     int64_t nTime;     // Local time when entering the mempool
     uint32_t height;  // Chain height when entering the mempool
 
+    CDBKeyTracker dbKeys;  // The db keys read or written by the last execution in mempool
+    uint64_t sequence;     // The order of the last execution in mempool
+
 public:
     CTxMemPoolEntry(CBaseTx *ptx, int64_t time, uint32_t height);
     CTxMemPoolEntry();
@@ -44,9 +64,19 @@ public:
     inline std::pair<TokenSymbol, uint64_t> GetFees() const { return nFees; }
     inline uint32_t GetTxSize() const { return nTxSize; }
     inline double GetPriority() const { return dPriority; }
+    inline double GetFeePerKb() const { return dFeePerKb; }
+    void SetFeePerKb(int32_t height, uint32_t fuelRate);
+    CTxMemPoolPriorityKey GetPriorityKey(const uint256 &txid) const;
 
     inline int64_t GetTime() const { return nTime; }
     inline uint32_t GetHeight() const { return height; }
+
+    inline const CDBKeyTracker &GetDbKeys() const { return dbKeys; }
+    inline uint64_t GetSequence() const { return sequence; }
+    void SetExecuted(CDBKeyTracker &&dbKeysIn, uint64_t sequenceIn) {
+        dbKeys   = std::move(dbKeysIn);
+        sequence = sequenceIn;
+    }
 };
 
 /*
@@ -63,6 +93,7 @@ class CTxMemPool {
 public:
     mutable CCriticalSection cs;
     map<uint256, CTxMemPoolEntry > memPoolTxs;
+    set<CTxMemPoolPriorityKey> priorityIndex;  // Index of memPoolTxs in packing order
     std::shared_ptr<CCacheWrapper> cw;
 
 public:
@@ -73,18 +104,41 @@ public:
     bool AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state);
     void Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive = false);
     void QueryHash(vector<uint256> &txids);
+    // The data written by the executed tx is flushed into cw, or returned in pTxCw if given.
     bool CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state,
-                          bool bExecute = true);
+                          bool bExecute = true, CDBKeyTracker *pDbKeyTracker = nullptr,
+                          std::shared_ptr<CCacheWrapper> *pTxCw = nullptr);
     void SetMemPoolCache();
+    // Add the db keys changed by a connected or disconnected block.
+    void AddChangedDbKeys(const set<string> &dbKeys);
+    void RemoveConfirmedTxs(const CBlock &block);
+    // Re-execute the txs depending on the changed db keys, the others keep their state in cw.
     void ReScanMemPoolTx();
     void Clear();
 
     uint64_t Size();
+    uint64_t TotalTxSize();
     bool Exists(const uint256 txid);
     std::shared_ptr<CBaseTx> Lookup(const uint256 txid) const;
 
+private:
+    map<uint256, CTxMemPoolEntry>::iterator EraseEntry(map<uint256, CTxMemPoolEntry>::iterator it);
+    void AddToIndex(const uint256 &txid, const CTxMemPoolEntry &entry);
+    void RemoveFromIndex(const uint256 &txid, const CTxMemPoolEntry &entry);
+    // Select the txs with the lowest packing order until the pool fits in -maxmempool, together with the txs
+    // executed after them on the data they wrote.
+    void SelectTxsToEvict(set<uint256> &evictedTxids) const;
+    void EvictTxs(const set<uint256> &txids);
+    // Re-execute the txs accessing the changed db keys in their order, after discarding the keys from cw. Returns
+    // the count of the txs re-executed.
+    uint32_t ReExecuteChangedTxs(bool fFullScan);
+
 private:
     bool fSanityCheck; // Normally false, true if -checkmempool or -regtest
+    uint64_t nSequence;         // The sequence of the last tx execution
+    uint64_t nTotalTxSize;      // The serialized size of all txs in memPoolTxs
+    int32_t nScanHeight;        // The chain height of the last scan
+    set<string> changedDbKeys;  // The db keys changed since the last scan, must be discarded from cw
 };
 
 
@@ -278,6 +278,7 @@ bool CWasmContractTx::ExecuteTx(CTxExecuteContext &context) {
     auto& execute_tx_to_return = *context.pState;
     transaction_status         = context.transaction_status;
     pending_block_time         = context.block_time;
+    pending_block_height       = context.height;
 
     wasm::inline_transaction* trx_current_for_exception = nullptr;
 
@@ -11,6 +11,8 @@
 #include <string.h>
 
 #include <openssl/des.h>
+#include <list>
+#include <map>
 #include <vector>
 #include "crypto/hash.h"
 #include "entities/key.h"
@@ -127,6 +129,64 @@ static int luaopen_array(lua_State *L){
 
 #endif
 
+/**
+ * The LRU cache of the precompiled contract scripts, keyed by the contract regid and checked by the code hash, so
+ * the script of a redeployed contract is compiled again. Loading the bytecode allocates other memory than parsing
+ * the script does, so the cache is only used by the burner versions which do not burn the allocated memory, the
+ * fuel burned by the steps is the same either way.
+ */
+class CLuaProtoCache {
+public:
+    std::shared_ptr<const string> Get(const CRegID &regid, const uint256 &codeHash) {
+        LOCK(cs_cache);
+        auto it = mapProtos.find(regid);
+        if (it == mapProtos.end() || it->second.codeHash != codeHash)
+            return nullptr;
+
+        lruRegids.splice(lruRegids.begin(), lruRegids, it->second.lruIt);
+        return it->second.pBytecode;
+    }
+
+    void Add(const CRegID &regid, const uint256 &codeHash, std::shared_ptr<const string> pBytecode) {
+        LOCK(cs_cache);
+        auto it = mapProtos.find(regid);
+        if (it != mapProtos.end()) {  // the contract has been redeployed
+            totalSize -= it->second.pBytecode->size();
+            lruRegids.erase(it->second.lruIt);
+            mapProtos.erase(it);
+        }
+
+        lruRegids.push_front(regid);
+        mapProtos[regid] = {codeHash, pBytecode, lruRegids.begin()};
+        totalSize += pBytecode->size();
+        while (totalSize > MAX_LUA_PROTO_CACHE_SIZE && lruRegids.size() > 1) {
+            auto lastIt = mapProtos.find(lruRegids.back());
+            totalSize -= lastIt->second.pBytecode->size();
+            mapProtos.erase(lastIt);
+            lruRegids.pop_back();
+        }
+    }
+
+private:
+    struct Entry {
+        uint256 codeHash;
+        std::shared_ptr<const string> pBytecode;
+        list<CRegID>::iterator lruIt;
+    };
+
+    CCriticalSection cs_cache;
+    map<CRegID, Entry> mapProtos;
+    list<CRegID> lruRegids;  // the most recently used contract is at the front
+    uint64_t totalSize = 0;
+};
+
+static CLuaProtoCache luaProtoCache;
+
+static int LuaDumpWriter(lua_State *L, const void *p, size_t sz, void *ud) {
+    ((string *)ud)->append((const char *)p, sz);
+    return 0;
+}
+
 CLuaVM::CLuaVM(const std::string &codeIn, const std::string &argumentsIn):
     code(codeIn), arguments(argumentsIn) {
     assert(code.size() <= MAX_CONTRACT_CODE_SIZE);
@@ -285,9 +345,28 @@ tuple<uint64_t, string> CLuaVM::Run(uint64_t fuelLimit, CLuaVMRunEnv *pVmRunEnv)
     lua_setglobal(lua_state, "VmScriptRun");
     LogPrint(BCLog::LUAVM, "pVmRunEnv=%p\n", pVmRunEnv);
 
-    // 5. Load the contract script
+    // 5. Load the contract script, or its bytecode compiled before
+    bool isProtoCacheable = pVmRunEnv->GetBurnVersion() < BURN_VER_R2;
+    std::shared_ptr<const string> pBytecode;
+    uint256 codeHash;
+    if (isProtoCacheable) {
+        codeHash  = Hash(code.begin(), code.end());
+        pBytecode = luaProtoCache.Get(pVmRunEnv->GetContractRegID(), codeHash);
+    }
+
     std::string strError;
-    int luaStatus = luaL_loadbuffer(lua_state, code.c_str(), code.size(), "line");
+    int luaStatus;
+    if (pBytecode) {
+        luaStatus = luaL_loadbufferx(lua_state, pBytecode->data(), pBytecode->size(), "line", "b");
+    } else {
+        luaStatus = luaL_loadbuffer(lua_state, code.c_str(), code.size(), "line");
+        if (luaStatus == LUA_OK && isProtoCacheable) {
+            auto pNewBytecode = std::make_shared<string>();
+            if (lua_dump(lua_state, LuaDumpWriter, pNewBytecode.get(), 0) == 0)
+                luaProtoCache.Add(pVmRunEnv->GetContractRegID(), codeHash, pNewBytecode);
+        }
+    }
+
     if (luaStatus == LUA_OK) {
         luaStatus = lua_pcallk(lua_state, 0, 0, 0, 0, NULL, BURN_VER_STEP_V1);
         if (luaStatus != LUA_OK) {
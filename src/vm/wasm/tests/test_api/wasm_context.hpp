@@ -190,6 +190,20 @@ class wasm_context : public wasm_context_interface {
         bool get_data  ( const uint64_t& contract, const string& k, string &v ) { return cache.GetContractData(contract, k, v); }
         bool erase_data( const uint64_t& contract, const string& k ) { return cache.EraseContractData(contract, k); }
 
+        int32_t db_lowerbound( const uint64_t& contract, const string& k ) {
+            string prefix((const char *)&contract, sizeof(uint64_t));
+            return load_db_iterator(-1, prefix, cache.database.lower_bound(prefix + k));
+        }
+        int32_t db_next( const int32_t& iterator ) {
+            const string &key = db_iterators.at(iterator);
+            return load_db_iterator(iterator, key.substr(0, sizeof(uint64_t)), cache.database.upper_bound(key));
+        }
+        void db_iterator_data( const int32_t& iterator, string& k, string& v ) {
+            const string &key = db_iterators.at(iterator);
+            k = key.substr(2 * sizeof(uint64_t));
+            v = cache.database[key];
+        }
+
         std::vector<uint64_t>    get_active_producers() { return std::vector<uint64_t>(); }
         vm::wasm_allocator*      get_wasm_allocator()   { return &wasm_alloc; }
         // bool                     is_memory_in_wasm_allocator( const char* p ) { 
@@ -228,6 +242,19 @@ class wasm_context : public wasm_context_interface {
         //std::chrono::milliseconds ;
 
     private:
+        // the contract data keys are prefixed by the contract twice, by the cache and by the host methods
+        int32_t load_db_iterator( int32_t iterator, const string& prefix, map<string, string>::iterator it ) {
+            if (it == cache.database.end() || it->first.compare(0, 2 * prefix.size(), prefix + prefix) != 0)
+                return -1;
+            if (iterator < 0) {
+                db_iterators.push_back(it->first);
+                return db_iterators.size() - 1;
+            }
+            db_iterators[iterator] = it->first;
+            return iterator;
+        }
+
         std::ostringstream _pending_console_output;
+        vector<string>     db_iterators;
     };
 }
@@ -21,6 +21,8 @@ namespace wasm {
     const static uint32_t max_wasm_api_data_bytes      = 64*1024;
     const static uint16_t max_inline_transactions_size = 1024;
     const static uint16_t max_signatures_size          = 16;
+    const static uint16_t max_db_iterators_size        = 1024;
+    const static uint64_t max_wasm_instantiation_cache_bytes = 256*1024*1024;
 
     const static uint64_t wasmio       = N(wasmio);
     const static uint64_t wasmio_bank  = N(wasmio.bank);
@@ -29,6 +31,7 @@ namespace wasm {
 
     const static uint64_t store_fuel_fee_per_byte       = 100;
     const static uint64_t notice_fuel_fee_per_recipient = 10000;
+    const static uint64_t db_iterator_fuel_fee_per_step = 1000;
 
 
     namespace wasm_constraints {
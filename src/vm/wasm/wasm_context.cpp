@@ -4,6 +4,7 @@
 #include "wasm/wasm_constants.hpp"
 #include "wasm/wasm_log.hpp"
 #include "entities/account.h"
+#include "config/configuration.h"
 
 #include "wasm/exception/exceptions.hpp"
 
@@ -281,6 +282,95 @@ namespace wasm {
         return active_producers;
     }
 
+    int32_t wasm_context::db_lowerbound( const uint64_t& contract, const string& k ) {
+
+        check_db_iterator_enabled();
+        CHAIN_ASSERT( db_iterators.size() < max_db_iterators_size,
+                      wasm_chain::wasm_assert_exception,
+                      "too many db iterators, max %d", max_db_iterators_size)
+
+        CAccount contract_account;
+        CHAIN_ASSERT( database.accountCache.GetAccount(nick_name(contract), contract_account),
+                      wasm_chain::account_access_exception,
+                      "contract '%s' does not exist",
+                      wasm::name(contract).to_string())
+
+        control_trx.run_cost += db_iterator_fuel_fee_per_step;
+
+        std::vector<char> prefix = wasm::pack(contract);
+        db_iterator iter;
+        iter.it = database.contractCache.CreateContractDataIterator(contract_account.regid,
+                                                                    string(prefix.data(), prefix.size()));
+        if (!iter.it) return -1;
+
+        // the iterator seeks the keys after the given key only
+        if (database.contractCache.GetContractData(contract_account.regid, k, iter.value)) {
+            iter.key = k;
+        } else {
+            iter.it->SeekUpper(&k);
+            load_db_iterator(iter);
+            if (iter.key.empty()) return -1;
+        }
+
+        db_iterators.push_back(iter);
+        return db_iterators.size() - 1;
+    }
+
+    int32_t wasm_context::db_next( const int32_t& iterator ) {
+
+        check_db_iterator_enabled();
+        CHAIN_ASSERT( iterator >= 0 && iterator < (int32_t)db_iterators.size() && !db_iterators[iterator].key.empty(),
+                      wasm_chain::wasm_assert_exception,
+                      "invalid db iterator %d", iterator)
+
+        control_trx.run_cost += db_iterator_fuel_fee_per_step;
+
+        // seek again if the data has been changed since the iterator moved
+        db_iterator& iter = db_iterators[iterator];
+        if (iter.is_positioned && iter.data_version == data_version) {
+            iter.it->Next();
+        } else {
+            string last_key = iter.key;
+            iter.it->SeekUpper(&last_key);
+        }
+
+        load_db_iterator(iter);
+        return iter.key.empty() ? -1 : iterator;
+    }
+
+    void wasm_context::db_iterator_data( const int32_t& iterator, string& k, string& v ) {
+
+        check_db_iterator_enabled();
+        CHAIN_ASSERT( iterator >= 0 && iterator < (int32_t)db_iterators.size() && !db_iterators[iterator].key.empty(),
+                      wasm_chain::wasm_assert_exception,
+                      "invalid db iterator %d", iterator)
+
+        const db_iterator& iter = db_iterators[iterator];
+        k = iter.key.substr(sizeof(uint64_t));
+        v = iter.value;
+    }
+
+    void wasm_context::load_db_iterator( db_iterator& iter ) {
+
+        if (iter.it->IsValid()) {
+            iter.key   = iter.it->GetContractKey();
+            iter.value = iter.it->GetValue();
+        } else {
+            iter.key.clear();
+            iter.value.clear();
+        }
+        iter.is_positioned = true;
+        iter.data_version  = data_version;
+    }
+
+    // the db iterator intrinsics are linked into every module, they work from the feature fork of the wasm contracts
+    void wasm_context::check_db_iterator_enabled() {
+
+        CHAIN_ASSERT( GetFeatureForkVersion(control_trx.pending_block_height) >= MAJOR_VER_R3,
+                      wasm_chain::wasm_assert_exception,
+                      "db iterators are not enabled at height %d", control_trx.pending_block_height)
+    }
+
     void wasm_context::update_storage_usage(const uint64_t& account, const int64_t& size_in_bytes){
 
         int64_t disk_usage    = size_in_bytes * store_fuel_fee_per_byte;
@@ -78,6 +78,7 @@ namespace wasm {
                           "contract '%s' does not exist",
                           contract_name.to_string().c_str())
 
+            data_version++;
             return database.contractCache.SetContractData(contract_account.regid, k, v);
         }
 
@@ -100,9 +101,14 @@ namespace wasm {
                           "contract '%s' does not exist",
                           contract_name.to_string().c_str())
 
+            data_version++;
             return database.contractCache.EraseContractData(contract_account.regid, k);
         }
 
+        int32_t db_lowerbound   ( const uint64_t& contract, const string& k );
+        int32_t db_next         ( const int32_t& iterator );
+        void    db_iterator_data( const int32_t& iterator, string& k, string& v );
+
         std::vector<uint64_t> get_active_producers();
 
         bool contracts_console() {
@@ -136,6 +142,19 @@ namespace wasm {
         uint64_t                   _receiver;
 
     private:
+        struct db_iterator {
+            std::shared_ptr<CDBContractDataIterator> it;
+            string                                   key;   // with the contract prefix, empty at the end
+            string                                   value;
+            bool                                     is_positioned = false; // it is at the key
+            uint64_t                                 data_version  = 0;
+        };
+
+        void load_db_iterator( db_iterator& iter );
+        void check_db_iterator_enabled();
+
         std::ostringstream         _pending_console_output;
+        vector<db_iterator>        db_iterators;
+        uint64_t                   data_version = 0; // changed by every write of the contract data
     };
 }
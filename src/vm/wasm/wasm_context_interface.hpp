@@ -43,6 +43,11 @@ namespace wasm {
         virtual bool get_data  ( const uint64_t& contract, const string& k, string &v       ) = 0;//{ return 0; }
         virtual bool erase_data( const uint64_t& contract, const string& k                  ) = 0;//{ return 0; }
 
+        // the iterators of the contract data in key order, the iterator is -1 at the end
+        virtual int32_t db_lowerbound   ( const uint64_t& contract, const string& k         ) = 0;
+        virtual int32_t db_next         ( const int32_t& iterator                           ) = 0;
+        virtual void    db_iterator_data( const int32_t& iterator, string& k, string& v     ) = 0;
+
         virtual std::vector<uint64_t> get_active_producers() = 0;//{ return std::vector<uint64_t>(); }
         virtual vm::wasm_allocator*   get_wasm_allocator()   = 0;//{ return nullptr;                 }
         virtual bool                  is_memory_in_wasm_allocator ( const uint64_t& p ) = 0 ;
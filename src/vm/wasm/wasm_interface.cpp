@@ -15,6 +15,9 @@
 #include "wasm/exception/exceptions.hpp"
 
 #include "crypto/hash.h"
+#include <list>
+#include <map>
+#include <mutex>
 #include <openssl/ripemd.h>
 #include <openssl/sha.h>
 
@@ -37,9 +40,66 @@ namespace wasm {
     using backend_validate_t = backend<wasm::wasm_context_interface, vm::interpreter>;
     using rhf_t              = eosio::vm::registered_host_functions<wasm_context_interface>;
 
-    std::optional<std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>>& get_wasm_instantiation_cache(){
-        static std::optional<std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>> wasm_instantiation_cache;
-        return wasm_instantiation_cache;
+    /**
+     * LRU cache of the instantiated modules, bounded by the memory held by the modules.
+     * A module evicted while it is executing is released after the execution.
+     */
+    class wasm_instantiation_cache {
+    public:
+        std::shared_ptr<wasm_instantiated_module_interface> get(const code_version_t &code_id) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto it = modules.find(code_id);
+            if (it == modules.end())
+                return nullptr;
+
+            lru_ids.splice(lru_ids.begin(), lru_ids, it->second.lru_it);
+            return it->second.module;
+        }
+
+        std::shared_ptr<wasm_instantiated_module_interface> add(const code_version_t &code_id,
+                        std::shared_ptr<wasm_instantiated_module_interface> module) {
+            uint64_t size = module->memory_size();
+
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            auto it = modules.find(code_id);
+            if (it != modules.end())  // instantiated by another thread
+                return it->second.module;
+
+            lru_ids.push_front(code_id);
+            modules[code_id] = {module, size, lru_ids.begin()};
+            total_size += size;
+            while (total_size > max_wasm_instantiation_cache_bytes && lru_ids.size() > 1) {
+                auto last_it = modules.find(lru_ids.back());
+                total_size -= last_it->second.size;
+                modules.erase(last_it);
+                lru_ids.pop_back();
+            }
+            return module;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            modules.clear();
+            lru_ids.clear();
+            total_size = 0;
+        }
+
+    private:
+        struct entry {
+            std::shared_ptr<wasm_instantiated_module_interface> module;
+            uint64_t                                             size;
+            std::list<code_version_t>::iterator                  lru_it;
+        };
+
+        std::mutex                        cache_mutex;
+        std::map<code_version_t, entry>   modules;
+        std::list<code_version_t>         lru_ids; // the most recently used module is at the front
+        uint64_t                          total_size = 0;
+    };
+
+    wasm_instantiation_cache& get_wasm_instantiation_cache(){
+        static wasm_instantiation_cache instantiation_cache;
+        return instantiation_cache;
     }
 
     std::shared_ptr <wasm_runtime_interface>& get_runtime_interface(){
@@ -58,17 +118,13 @@ namespace wasm {
     std::shared_ptr <wasm_instantiated_module_interface> get_instantiated_backend(const vector <uint8_t> &code) {
 
         try {
-            if(!get_wasm_instantiation_cache().has_value()){
-                 get_wasm_instantiation_cache() = std::map <code_version_t, std::shared_ptr<wasm_instantiated_module_interface>>{};
-            }
-
             auto code_id = Hash(code.begin(), code.end());
-            auto it = get_wasm_instantiation_cache()->find(code_id);
-            if (it == get_wasm_instantiation_cache()->end()) {
-                get_wasm_instantiation_cache().value()[code_id] = get_runtime_interface()->instantiate_module((const char*)code.data(), code.size());
-                return get_wasm_instantiation_cache().value()[code_id];
-            }
-            return it->second;
+            auto module  = get_wasm_instantiation_cache().get(code_id);
+            if (module)
+                return module;
+
+            module = get_runtime_interface()->instantiate_module((const char*)code.data(), code.size());
+            return get_wasm_instantiation_cache().add(code_id, module);
         } catch (...) {
             throw;
         }
@@ -350,6 +406,54 @@ namespace wasm {
             return 1;
         }
 
+        int32_t db_lowerbound( const void *key, uint32_t key_len ) {
+
+            CHECK_WASM_IN_MEMORY(key,     key_len)
+            CHECK_WASM_DATA_SIZE(key_len, "key"  )
+
+            string k        = string((const char *) key, key_len);
+            auto   contract = pWasmContext->receiver();
+            AddPrefix(contract, k);
+
+            return pWasmContext->db_lowerbound(contract, k);
+        }
+
+        int32_t db_next( int32_t iterator ) {
+            return pWasmContext->db_next(iterator);
+        }
+
+        int32_t db_iterator_key( int32_t iterator, void *key, uint32_t key_len ) {
+
+            string k, v;
+            pWasmContext->db_iterator_data(iterator, k, v);
+
+            auto size = k.size();
+            if (key_len == 0) return size;
+
+            CHECK_WASM_IN_MEMORY(key,     key_len)
+            CHECK_WASM_DATA_SIZE(key_len, "key"  )
+
+            auto key_size = key_len > size ? size : key_len;
+            std::memcpy(key, k.data(), key_size);
+            return key_size;
+        }
+
+        int32_t db_iterator_value( int32_t iterator, void *val, uint32_t val_len ) {
+
+            string k, v;
+            pWasmContext->db_iterator_data(iterator, k, v);
+
+            auto size = v.size();
+            if (val_len == 0) return size;
+
+            CHECK_WASM_IN_MEMORY(val,     val_len)
+            CHECK_WASM_DATA_SIZE(val_len, "value")
+
+            auto val_size = val_len > size ? size : val_len;
+            std::memcpy(val, v.data(), val_size);
+            return val_size;
+        }
+
 
         //memory
         void *memcpy( void *dest, const void *src, int len ) {
@@ -908,6 +1012,10 @@ namespace wasm {
     REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_remove, db_remove)
     REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_get,    db_get)
     REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_update, db_update)
+    REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_lowerbound,     db_lowerbound)
+    REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_next,           db_next)
+    REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_iterator_key,   db_iterator_key)
+    REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, db_iterator_value, db_iterator_value)
 
     REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, memcpy,  memcpy)
     REGISTER_WASM_VM_INTRINSIC(wasm_host_methods, env, memmove, memmove)
@@ -989,5 +1097,5 @@ namespace wasm {
 
 extern  void wasm_code_cache_free() {
      //free heap before shut down
-     wasm::get_wasm_instantiation_cache().reset();
+     wasm::get_wasm_instantiation_cache().clear();
 }
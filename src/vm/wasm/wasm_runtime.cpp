@@ -62,6 +62,11 @@ namespace wasm {
             _runtime->_bkend = nullptr;
         }
 
+        uint64_t memory_size() override {
+            auto &allocator = _instantiated_module->get_module().allocator;
+            return allocator._capacity + (allocator.is_jit ? allocator._code_size : 0);
+        }
+
     private:
         wasm_vm_runtime <Impl> *    _runtime;
         std::shared_ptr <backend_t> _instantiated_module;